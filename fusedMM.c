@@ -4,6 +4,9 @@
 #endif
 #include<stdint.h>
 #include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
 #include <omp.h>
 #include"kernels/include/kernels.h"
 #ifdef DREAL
@@ -13,12 +16,72 @@
 #endif
 #include "fusedMM.h"
 #include "fusedMM_internal.h"
+#include "kernels/simd/simd.h"
+/*
+ * SIMD version of the operations are used when SIMD unit is found. 
+ * DEBUG uses scalar version to check the dimensions   
+ */
+#if defined(VTYPE) && !defined(DEBUG) && !defined(NO_SIMD_FUSEDMM)
+   #define SIMD_FUSEDMM 1 
+   #define KERN_SEL(func_) func_##_SIMD
+#else
+   #define KERN_SEL(func_) func_
+#endif
 
 
-#define fmax(x,y) ( (x) > (y) ? (x) : (y))
-#define fmin(x,y) ( (x) < (y) ? (x) : (y))
-#define fabs(x) ( (x) >= 0 ? (x) : -(y))
+/*
+ * USER DEFINE FUNC IMPLEMENTATION 
+ * DUMMY function, always return error when not implemented by user but used in
+ * message using UDEF
+ */
+#ifndef VOP_UDEF_IMPL 
+int VOP_UDEF_FUNC(INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim, 
+      const VALUETYPE *rhs, INDEXTYPE out_dim, VALUETYPE *out)
+{
+   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
+}
+#endif
+#ifndef ROP_UDEF_IMPL 
+int ROP_UDEF_FUNC(INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim, 
+      const VALUETYPE *rhs, VALUETYPE *out) 
+{
+   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
+}
+#endif
 
+#ifndef SOP_UDEF_IMPL 
+int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out) 
+{
+   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
+}
+#endif
+#ifndef SOP_UDEF_BATCH_IMPL 
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out) 
+{
+   int status;
+   for (INDEXTYPE i = 0; i < n; i++)
+   {
+      status = SOP_UDEF_FUNC(in[i], out+i);
+      if (status != FUSEDMM_SUCCESS_RETURN)
+         return status;
+   }
+   return FUSEDMM_SUCCESS_RETURN;  
+}
+#endif
+#ifndef VSC_UDEF_IMPL 
+int VSC_UDEF_FUNC(INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE scal, 
+      INDEXTYPE out_dim, VALUETYPE *out) 
+{
+   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
+}
+#endif
+#ifndef AOP_UDEF_IMPL /* func prototype */
+int AOP_UDEF_FUNC(INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out) 
+{
+   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
+}
+#endif
 
 /*============================================================================
  *    VOP (Vector-vector operation) 
@@ -116,7 +179,7 @@ int KERN_VOP_MAX (INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim,
    }
 #endif
    for (INDEXTYPE i = 0; i < out_dim; i++)
-      out[i] = fmax(lhs[i], rhs[i]);
+      out[i] = (lhs[i] > rhs[i]) ? lhs[i] : rhs[i];
 
    return FUSEDMM_SUCCESS_RETURN;
 }
@@ -132,7 +195,7 @@ int KERN_VOP_MIN (INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim,
    }
 #endif
    for (INDEXTYPE i = 0; i < out_dim; i++)
-      out[i] = fmin(lhs[i], rhs[i]);
+      out[i] = (lhs[i] < rhs[i]) ? lhs[i] : rhs[i];
 
    return FUSEDMM_SUCCESS_RETURN;
 }
@@ -313,7 +376,7 @@ int KERN_AOP_MAX(INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim,
    }
 #endif
    for (INDEXTYPE i = 0; i < rhs_dim; i++)
-      out[i] = fmax (out[i], rhs[i]);
+      out[i] = (out[i] > rhs[i]) ? out[i] : rhs[i];
    return FUSEDMM_SUCCESS_RETURN;
 }
 
@@ -328,11 +391,230 @@ int KERN_AOP_MIN(INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim,
    }
 #endif
    for (INDEXTYPE i = 0; i < rhs_dim; i++)
-      out[i] = fmin (out[i], rhs[i]);
+      out[i] = (out[i] < rhs[i]) ? out[i] : rhs[i];
    return FUSEDMM_SUCCESS_RETURN;
 }
 
 
+#ifdef SIMD_FUSEDMM
+/*=============================================================================
+ *    SIMD version of the operations using kernels/simd/simd.h  
+ *       remainder of the dimension (n % VLEN) uses masked load/store 
+ *============================================================================*/
+/*
+ * out = lhs op rhs where op_(dst, src1, src2) is a BCL_* vector instruction 
+ */
+#define SIMD_VV_OP(n_, out_, lhs_, rhs_, op_) \
+{  INDEXTYPE i_; VTYPE vl_, vr_; MTYPE k_; \
+   for (i_ = 0; i_ + VLEN <= (n_); i_ += VLEN) \
+   {  BCL_vldu(vl_, (lhs_)+i_); BCL_vldu(vr_, (rhs_)+i_); \
+      op_(vl_, vl_, vr_); \
+      BCL_vstu((out_)+i_, vl_); \
+   } \
+   if (i_ < (n_)) \
+   {  BCL_tailmask(k_, (n_)-i_); \
+      BCL_maskz_vldu(vl_, k_, (lhs_)+i_); BCL_maskz_vldu(vr_, k_, (rhs_)+i_); \
+      op_(vl_, vl_, vr_); \
+      BCL_mask_vstu((out_)+i_, k_, vl_); \
+   } \
+}
+/*
+ * out = scal op rhs 
+ */
+#define SIMD_SV_OP(n_, out_, scal_, rhs_, op_) \
+{  INDEXTYPE i_; VTYPE vs_, vr_; MTYPE k_; \
+   BCL_vset1(vs_, scal_); \
+   for (i_ = 0; i_ + VLEN <= (n_); i_ += VLEN) \
+   {  BCL_vldu(vr_, (rhs_)+i_); \
+      op_(vr_, vs_, vr_); \
+      BCL_vstu((out_)+i_, vr_); \
+   } \
+   if (i_ < (n_)) \
+   {  BCL_tailmask(k_, (n_)-i_); \
+      BCL_maskz_vldu(vr_, k_, (rhs_)+i_); \
+      op_(vr_, vs_, vr_); \
+      BCL_mask_vstu((out_)+i_, k_, vr_); \
+   } \
+}
+/*
+ * out = src 
+ */
+#define SIMD_COPY(n_, out_, src_) \
+{  INDEXTYPE i_; VTYPE v_; MTYPE k_; \
+   for (i_ = 0; i_ + VLEN <= (n_); i_ += VLEN) \
+   {  BCL_vldu(v_, (src_)+i_); \
+      BCL_vstu((out_)+i_, v_); \
+   } \
+   if (i_ < (n_)) \
+   {  BCL_tailmask(k_, (n_)-i_); \
+      BCL_maskz_vldu(v_, k_, (src_)+i_); \
+      BCL_mask_vstu((out_)+i_, k_, v_); \
+   } \
+}
+/*
+ * *out = sum of lhs[i]*rhs[i], masked lanes are zero  
+ */
+#define SIMD_VV_DOT(n_, out_, lhs_, rhs_) \
+{  INDEXTYPE i_; VTYPE vl_, vr_, vacc_; MTYPE k_; \
+   BCL_vzero(vacc_); \
+   for (i_ = 0; i_ + VLEN <= (n_); i_ += VLEN) \
+   {  BCL_vldu(vl_, (lhs_)+i_); BCL_vldu(vr_, (rhs_)+i_); \
+      BCL_vmac(vacc_, vl_, vr_); \
+   } \
+   if (i_ < (n_)) \
+   {  BCL_tailmask(k_, (n_)-i_); \
+      BCL_maskz_vldu(vl_, k_, (lhs_)+i_); BCL_maskz_vldu(vr_, k_, (rhs_)+i_); \
+      BCL_vmac(vacc_, vl_, vr_); \
+   } \
+   BCL_vrsum1(*(out_), vacc_); \
+}
+/*
+ * *out = sum of src[i] 
+ */
+#define SIMD_V_SUM(n_, out_, src_) \
+{  INDEXTYPE i_; VTYPE v_, vacc_; MTYPE k_; \
+   BCL_vzero(vacc_); \
+   for (i_ = 0; i_ + VLEN <= (n_); i_ += VLEN) \
+   {  BCL_vldu(v_, (src_)+i_); \
+      BCL_vadd(vacc_, vacc_, v_); \
+   } \
+   if (i_ < (n_)) \
+   {  BCL_tailmask(k_, (n_)-i_); \
+      BCL_maskz_vldu(v_, k_, (src_)+i_); \
+      BCL_vadd(vacc_, vacc_, v_); \
+   } \
+   BCL_vrsum1(*(out_), vacc_); \
+}
+
+/*
+ * VOP 
+ */
+int KERN_VOP_COPY_LHS_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out)
+{
+   SIMD_COPY(out_dim, out, lhs);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_VOP_COPY_RHS_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out)
+{
+   SIMD_COPY(out_dim, out, rhs);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_VOP_ADD_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out)
+{
+   SIMD_VV_OP(out_dim, out, lhs, rhs, BCL_vadd);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_VOP_SUBL_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out)
+{
+   SIMD_VV_OP(out_dim, out, rhs, lhs, BCL_vsub); // subtract lhs from rhs 
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_VOP_SUBR_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out)
+{
+   SIMD_VV_OP(out_dim, out, lhs, rhs, BCL_vsub); // subtract rhs from lhs 
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_VOP_MAX_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out)
+{
+   SIMD_VV_OP(out_dim, out, lhs, rhs, BCL_vmax);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_VOP_MIN_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
+      VALUETYPE *out)
+{
+   SIMD_VV_OP(out_dim, out, lhs, rhs, BCL_vmin);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+/*
+ * ROP 
+ */
+int KERN_ROP_DOT_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE *out)
+{
+   SIMD_VV_DOT(lhs_dim, out, lhs, rhs);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_ROP_ADD_LHS_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE *out)
+{
+   SIMD_V_SUM(lhs_dim, out, lhs);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_ROP_ADD_RHS_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE *out)
+{
+   SIMD_V_SUM(rhs_dim, out, rhs);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_ROP_NORML_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE *out)
+{
+   SIMD_VV_DOT(rhs_dim, out, lhs, lhs);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_ROP_NORMR_SIMD (INDEXTYPE lhs_dim, const VALUETYPE *lhs, 
+      INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE *out)
+{
+   SIMD_VV_DOT(rhs_dim, out, rhs, rhs);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+/*
+ * VSC 
+ */
+int KERN_VSC_MUL_SIMD(INDEXTYPE rhs_dim, const VALUETYPE *rhs, 
+      VALUETYPE scal, INDEXTYPE out_dim, VALUETYPE *out) 
+{
+   SIMD_SV_OP(rhs_dim, out, scal, rhs, BCL_vmul);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_VSC_ADD_SIMD(INDEXTYPE rhs_dim, const VALUETYPE *rhs, 
+      VALUETYPE scal, INDEXTYPE out_dim, VALUETYPE *out) 
+{
+   SIMD_SV_OP(rhs_dim, out, scal, rhs, BCL_vadd);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+/*
+ * AOP 
+ */
+int KERN_AOP_MUL_SIMD(INDEXTYPE rhs_dim, const VALUETYPE *rhs, 
+      INDEXTYPE out_dim, VALUETYPE *out) 
+{
+   SIMD_VV_OP(rhs_dim, out, out, rhs, BCL_vmul);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_AOP_ADD_SIMD(INDEXTYPE rhs_dim, const VALUETYPE *rhs, 
+      INDEXTYPE out_dim, VALUETYPE *out) 
+{
+   SIMD_VV_OP(rhs_dim, out, out, rhs, BCL_vadd);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_AOP_MAX_SIMD(INDEXTYPE rhs_dim, const VALUETYPE *rhs, 
+      INDEXTYPE out_dim, VALUETYPE *out) 
+{
+   SIMD_VV_OP(rhs_dim, out, out, rhs, BCL_vmax);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+int KERN_AOP_MIN_SIMD(INDEXTYPE rhs_dim, const VALUETYPE *rhs, 
+      INDEXTYPE out_dim, VALUETYPE *out) 
+{
+   SIMD_VV_OP(rhs_dim, out, out, rhs, BCL_vmin);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+#endif /* end of SIMD_FUSEDMM */
+
 /*=============================================================================
  * Select funciton based on imessage 
  *
@@ -349,25 +631,25 @@ FP_VOP_FUNC GetVOPFunc(int32_t msg)
          break;
       */
       case VOP_COPY_LHS: 
-         VOP_FUNC = KERN_VOP_COPY_LHS;
+         VOP_FUNC = KERN_SEL(KERN_VOP_COPY_LHS);
          break;
       case VOP_COPY_RHS: 
-         VOP_FUNC = KERN_VOP_COPY_RHS;
+         VOP_FUNC = KERN_SEL(KERN_VOP_COPY_RHS);
          break;
       case VOP_ADD: 
-         VOP_FUNC = KERN_VOP_ADD;
+         VOP_FUNC = KERN_SEL(KERN_VOP_ADD);
          break;
       case VOP_SUBL: 
-         VOP_FUNC = KERN_VOP_SUBL;
+         VOP_FUNC = KERN_SEL(KERN_VOP_SUBL);
          break;
       case VOP_SUBR: 
-         VOP_FUNC = KERN_VOP_SUBR;
+         VOP_FUNC = KERN_SEL(KERN_VOP_SUBR);
          break;
       case VOP_MAX: 
-         VOP_FUNC = KERN_VOP_MAX;
+         VOP_FUNC = KERN_SEL(KERN_VOP_MAX);
          break;
       case VOP_MIN: 
-         VOP_FUNC = KERN_VOP_MIN;
+         VOP_FUNC = KERN_SEL(KERN_VOP_MIN);
          break;
       case VOP_UDEF: 
          VOP_FUNC = VOP_UDEF_FUNC;
@@ -388,19 +670,19 @@ FP_ROP_FUNC GetROPFunc(int32_t msg)
          ROP_FUNC = KERN_ROP_NOOP;
          break;
       case ROP_DOT: 
-         ROP_FUNC = KERN_ROP_DOT;
+         ROP_FUNC = KERN_SEL(KERN_ROP_DOT);
          break;
       case ROP_ADD_LHS: 
-         ROP_FUNC = KERN_ROP_ADD_LHS;
+         ROP_FUNC = KERN_SEL(KERN_ROP_ADD_LHS);
          break;
       case ROP_ADD_RHS: 
-         ROP_FUNC = KERN_ROP_ADD_RHS;
+         ROP_FUNC = KERN_SEL(KERN_ROP_ADD_RHS);
          break;
       case ROP_NORML: 
-         ROP_FUNC = KERN_ROP_NORML;
+         ROP_FUNC = KERN_SEL(KERN_ROP_NORML);
          break;
       case ROP_NORMR: 
-         ROP_FUNC = KERN_ROP_NORMR;
+         ROP_FUNC = KERN_SEL(KERN_ROP_NORMR);
          break;
       case ROP_UDEF: 
          ROP_FUNC = ROP_UDEF_FUNC;
@@ -423,6 +705,9 @@ FP_SOP_FUNC GetSOPFunc(int32_t msg)
       case SOP_COPY: 
          SOP_FUNC = KERN_SOP_COPY;
          break;
+      case SOP_SOFTMAX: /* applied on the row, see GenSoftmaxRow */
+         SOP_FUNC = KERN_SOP_COPY;
+         break;
       case SOP_UDEF: 
          SOP_FUNC = SOP_UDEF_FUNC;
          break;
@@ -442,10 +727,10 @@ FP_VSC_FUNC GetVSCFunc(int32_t msg)
          VSC_FUNC = KERN_VSC_NOOP;
          break;
       case VSC_MUL: 
-         VSC_FUNC = KERN_VSC_MUL;
+         VSC_FUNC = KERN_SEL(KERN_VSC_MUL);
          break;
       case VSC_ADD: 
-         VSC_FUNC = KERN_VSC_ADD;
+         VSC_FUNC = KERN_SEL(KERN_VSC_ADD);
          break;
       case VSC_UDEF: 
          VSC_FUNC = VSC_UDEF_FUNC;
@@ -466,13 +751,13 @@ FP_AOP_FUNC GetAOPFunc(int32_t msg)
          AOP_FUNC = KERN_AOP_NOOP;
          break;
       case AOP_ADD: 
-         AOP_FUNC = KERN_AOP_ADD;
+         AOP_FUNC = KERN_SEL(KERN_AOP_ADD);
          break;
       case AOP_MAX: 
-         AOP_FUNC = KERN_AOP_MAX;
+         AOP_FUNC = KERN_SEL(KERN_AOP_MAX);
          break;
       case AOP_MIN: 
-         AOP_FUNC = KERN_AOP_MIN;
+         AOP_FUNC = KERN_SEL(KERN_AOP_MIN);
          break;
       case AOP_UDEF: 
          AOP_FUNC = AOP_UDEF_FUNC;
@@ -484,39 +769,19 @@ FP_AOP_FUNC GetAOPFunc(int32_t msg)
    return(AOP_FUNC);
 }
 
-int fusedMM_csr 
-(
-   const int32_t imessage,    // message to dictate the operations  
-   const INDEXTYPE m,         // number of row of X
-   const INDEXTYPE n,         // number of row of Y
-   const INDEXTYPE k,         // dimension (col of X or Y)
-   const VALUETYPE alpha,     // not used yet
-   const INDEXTYPE nnz,       // nonzeros in sparse matrix 
-   const INDEXTYPE rows,      // number of rows in sparse matrix
-   const INDEXTYPE cols,      // number of columns in sparse matrix 
-   const VALUETYPE *val,      // value of non-zeros 
-   const INDEXTYPE *indx,     // colids -> column indices 
-   const INDEXTYPE *pntrb,    // starting of rowptr for each row
-   const INDEXTYPE *pntre,    // ending of rowptr for each row
-   const VALUETYPE *x,        // Dense X matrix
-   const INDEXTYPE ldx,       // 1eading dimension of X   
-   const VALUETYPE *y,        // Dense Y matrix
-   const INDEXTYPE ldy,       // leading dimension of Y   
-   const VALUETYPE beta,      // beta value 
-   VALUETYPE *z,              // Dense matrix Z
-   const INDEXTYPE ldz        // leading dimension size of z 
-)
-{
-   int status = 0;
-
 #ifdef ENABLE_OPT_FUSEDMM
-/* ============================================================================
- * call Predefined optimized kernel :
- *    NOTE that optimized kernel can call user defined SOP_UDEF function
+/*=============================================================================
+ * Select predefined optimized kernel based on imessage 
  *    TODO: update parameterized code generator to support all vector ops. 
- *          For now, we only support VSC_MUL and AOP_ADD which can easily
- *          be extended for all other vector operations. 
- * ===========================================================================*/
+ *          For now, we only support VSC_MUL and AOP_ADD (and AOP_MAX, 
+ *          AOP_MIN of max / min pooling) which can easily be extended for 
+ *          all other vector operations. 
+ *    returns tkern of optimized kernel: 't' = tdist, 's' = sigmoid, 
+ *    'm' = spmm, 'g' = gcn, 'a' = softmax, 'x' = max, 'n' = min. returns 0 
+ *    when there is no optimized kernel 
+ *============================================================================*/
+char GetOptKern(int32_t imessage)
+{
 /*
  * Check for GCN pattern
  */
@@ -525,16 +790,7 @@ int fusedMM_csr
          && GET_SOP_FLAG(imessage) == SOP_NOOP 
          && GET_VSC_FLAG(imessage) == VSC_NOOP 
          && GET_AOP_FLAG(imessage) == AOP_ADD)
-   {
-      #ifdef DREAL 
-      dgfusedMM_csr('g', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
-      #else
-      sgfusedMM_csr('g', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
-      #endif
-      return status;
-   }
+      return 'g';
 /*
  * Check for SPMM 
  */
@@ -543,16 +799,7 @@ int fusedMM_csr
          && GET_SOP_FLAG(imessage) == SOP_COPY 
          && GET_VSC_FLAG(imessage) == VSC_MUL 
          && GET_AOP_FLAG(imessage) == AOP_ADD)
-   {
-      #ifdef DREAL 
-      dgfusedMM_csr('m', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
-      #else
-      sgfusedMM_csr('m', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
-      #endif
-      return status;
-   }
+      return 'm';
 /*
  * check for sigmoid kernel 
  * NOTE: optfusedmm can call SOP_UDEF  
@@ -562,16 +809,16 @@ int fusedMM_csr
          && GET_SOP_FLAG(imessage) == SOP_UDEF 
          && GET_VSC_FLAG(imessage) == VSC_MUL 
          && GET_AOP_FLAG(imessage) == AOP_ADD)
-   {
-      #ifdef DREAL 
-      dgfusedMM_csr('s', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
-      #else
-      sgfusedMM_csr('s', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
-      #endif
-      return status;
-   }
+      return 's';
+/*
+ * check for softmax (attention) kernel: softmax of the dot products of a row
+ */
+   if ( GET_VOP_FLAG(imessage) == VOP_COPY_RHS 
+         && GET_ROP_FLAG(imessage) == ROP_DOT 
+         && GET_SOP_FLAG(imessage) == SOP_SOFTMAX 
+         && GET_VSC_FLAG(imessage) == VSC_MUL 
+         && GET_AOP_FLAG(imessage) == AOP_ADD)
+      return 'a';
 /*
  * Check for t-dist / FR : SOP_UDEF may be different
  * NOTE: optfusedmm calls SOP_UDEF
@@ -581,16 +828,180 @@ int fusedMM_csr
          && GET_SOP_FLAG(imessage) == SOP_UDEF 
          && GET_VSC_FLAG(imessage) == VSC_MUL 
          && GET_AOP_FLAG(imessage) == AOP_ADD)
+      return 't';
+/*
+ * Check for max / min pooling: max (min) of the rows of Y of the edges 
+ */
+   if ( GET_VOP_FLAG(imessage) == VOP_COPY_RHS 
+         && GET_ROP_FLAG(imessage) == ROP_NOOP 
+         && GET_SOP_FLAG(imessage) == SOP_NOOP 
+         && GET_VSC_FLAG(imessage) == VSC_NOOP)
+   {
+      if (GET_AOP_FLAG(imessage) == AOP_MAX)
+         return 'x';
+      if (GET_AOP_FLAG(imessage) == AOP_MIN)
+         return 'n';
+   }
+   return 0;
+}
+#endif
+
+/*=============================================================================
+ * Parallel driver of the general fusedMM specialized for the message, see 
+ * fusedMM_spec.h 
+ *    rowb = NULL: rows are scheduled by openmp (static or DYNAMIC) among 
+ *       nthreads threads
+ *    otherwise: partition t has rows rowb[t] to rowb[t+1]-1, t < nthreads
+ *    work: scratch space of nthreads*k elements, allocated when NULL
+ *============================================================================*/
+int fusedMM_spec_csr
+(
+   FP_SPEC_KERN_FUNC kern,    // specialized kernel, see GetSpecKern  
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE *val,      // value of non-zeros 
+   const COLINDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X   
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y   
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz,       // leading dimension size of z 
+   const INDEXTYPE nthreads,  // number of threads and partitions in rowb 
+   const INDEXTYPE *rowb,     // row partition, can be NULL 
+   VALUETYPE *work            // scratch space, can be NULL 
+)
+{
+   int status = 0;
+
+#ifdef PTTIME
+   #pragma omp parallel num_threads(nthreads) reduction(+:status)  
+#endif
    {
-      //fprintf(stdout, "calling optimized t-dist\n");
-      #ifdef DREAL 
-      dgfusedMM_csr('t', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
+   #ifdef PTTIME
+      INDEXTYPE id = omp_get_thread_num();
+      INDEXTYPE nt = omp_get_num_threads(); 
+   #else
+      INDEXTYPE id = 0, nt = 1; 
+   #endif
+      VALUETYPE *T; /* temporary space to hold result of vector compute */
+      
+      if (work)
+         T = work + id * k;
+      else
+         T = (VALUETYPE*) malloc(k * sizeof(VALUETYPE)); 
+
+      if (rowb)
+      {
+/*
+ *       NOTE: when runtime gives us less threads than requested, a thread 
+ *       handles more than one partition
+ */
+         for (INDEXTYPE t = id; t < nthreads; t += nt)
+            status += kern(rowb[t], rowb[t+1], k, val, indx, pntrb, pntre, 
+                  x, ldx, y, ldy, z, ldz, T);
+      }
+      else
+      {
+      #ifdef DYNAMIC
+         #pragma omp for schedule(dynamic)   
       #else
-      sgfusedMM_csr('t', m, n, k, alpha, nnz, rows, cols, val, 
-              indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);   
+         #pragma omp for schedule(static)   
       #endif
-      return status;
+         for (INDEXTYPE i = 0; i < m; i++)
+            status += kern(i, i+1, k, val, indx, pntrb, pntre, x, ldx, y, ldy, 
+                  z, ldz, T);
+      }
+      if (!work)
+         free(T);
+   }
+   return status;
+}
+
+/*=============================================================================
+ * Number of threads: set by fusedMM_set_num_threads, otherwise from the 
+ * FUSEDMM_NUM_THREADS environment variable, otherwise the default of openmp. 
+ * Kernels use it in num_threads clause, the number of threads of the 
+ * application (omp_set_num_threads) is never changed 
+ *============================================================================*/
+static int FusedMMNumThreads = 0; /* 0: not set by user */
+
+void fusedMM_set_num_threads(const int nthreads)
+{
+   FusedMMNumThreads = (nthreads > 0) ? nthreads : 0; 
+}
+
+int fusedMM_get_num_threads(void)
+{
+#ifdef PTTIME
+   const char *env; 
+
+   if (FusedMMNumThreads)
+      return FusedMMNumThreads;
+   env = getenv("FUSEDMM_NUM_THREADS");
+   if (env && atoi(env) > 0)
+      return atoi(env);
+   return omp_get_max_threads();
+#else
+   return 1; 
+#endif
+}
+
+/*=============================================================================
+ * Execution plan: 
+ *    decode message, select kernel, partition rows and allocate scratch space 
+ *    once, execute only runs the edge loop. fusedMM_csr uses a temporary plan
+ *============================================================================*/
+/*
+ * decode message and select the kernels of plan, partition and scratch space 
+ * are set by the caller 
+ */
+static int InitPlan
+(
+   fusedMM_plan_t *pl,        // OUT: plan to initialize
+   const int32_t imessage,    // message to dictate the operations  
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix 
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix 
+   const COLINDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre     // ending of rowptr for each row
+)
+{
+   memset(pl, 0, sizeof(fusedMM_plan_t));
+   pl->imessage = imessage; 
+   pl->m = m; pl->n = n; pl->k = k; 
+   pl->nnz = nnz; pl->rows = rows; pl->cols = cols; 
+   pl->indx = indx; pl->pntrb = pntrb; pl->pntre = pntre; 
+   pl->nthreads = fusedMM_get_num_threads();
+#ifdef ENABLE_OPT_FUSEDMM
+/* ============================================================================
+ * Predefined optimized kernel for beta = 0, beta = 1 (alpha = 1) and general
+ * alpha and beta (any alpha other than 1 selects it): 
+ *    NOTE that optimized kernel can call user defined SOP_UDEF function
+ * ===========================================================================*/
+   pl->tkern = GetOptKern(imessage);
+   if (pl->tkern)
+   {
+   #ifdef DREAL 
+      pl->kern_b0 = dgfusedMM_csr_getkern(pl->tkern, k, 1.0, 0.0);
+      pl->kern_b1 = dgfusedMM_csr_getkern(pl->tkern, k, 1.0, 1.0);
+      pl->kern_bx = dgfusedMM_csr_getkern(pl->tkern, k, 0.0, 0.0);
+   #else
+      pl->kern_b0 = sgfusedMM_csr_getkern(pl->tkern, k, 1.0, 0.0);
+      pl->kern_b1 = sgfusedMM_csr_getkern(pl->tkern, k, 1.0, 1.0);
+      pl->kern_bx = sgfusedMM_csr_getkern(pl->tkern, k, 0.0, 0.0);
+   #endif
+   /* to combine partial results of heavy rows: add, max or min */
+      pl->AOP_FUNC = GetAOPFunc(GET_AOP_FLAG(imessage));
+   /* softmax needs all the edges of a row */
+      pl->splitok = (pl->tkern != 'a'); 
+      return FUSEDMM_SUCCESS_RETURN;
    }
 /*
  * Reaching here means, we don't have matching optFusedMM. By default, we call
@@ -604,146 +1015,2481 @@ int fusedMM_csr
    #endif
 #endif
 /* ===========================================================================*/
+#ifndef DISABLE_SPEC_FUSEDMM
+/*
+ * general fusedMM specialized for the message at compile time, see 
+ * fusedMM_spec.h. Falls back to the function pointers below when there is 
+ * no instantiation for the message 
+ */
+   pl->spec_kern = GetSpecKern(imessage);
+#endif
 /*
  * Select appropriate operation based on the message
  */
-   FP_VOP_FUNC VOP_FUNC = GetVOPFunc(GET_VOP_FLAG(imessage));
-   if(!VOP_FUNC)
+   pl->VOP_FUNC = GetVOPFunc(GET_VOP_FLAG(imessage));
+   if(!pl->VOP_FUNC)
       return FUSEDMM_VOP_FAIL_RETURN;
 
-   FP_ROP_FUNC ROP_FUNC = GetROPFunc(GET_ROP_FLAG(imessage));
-   if(!ROP_FUNC)
+   pl->ROP_FUNC = GetROPFunc(GET_ROP_FLAG(imessage));
+   if(!pl->ROP_FUNC)
       return FUSEDMM_ROP_FAIL_RETURN;
 
-   FP_SOP_FUNC SOP_FUNC = GetSOPFunc(GET_SOP_FLAG(imessage));
-   if(!SOP_FUNC)
+   pl->SOP_FUNC = GetSOPFunc(GET_SOP_FLAG(imessage));
+   if(!pl->SOP_FUNC)
       return FUSEDMM_SOP_FAIL_RETURN;
 
-   FP_VSC_FUNC VSC_FUNC = GetVSCFunc(GET_VSC_FLAG(imessage));
-   if(!VSC_FUNC)
+   pl->VSC_FUNC = GetVSCFunc(GET_VSC_FLAG(imessage));
+   if(!pl->VSC_FUNC)
       return FUSEDMM_VSC_FAIL_RETURN;
    
-   FP_AOP_FUNC AOP_FUNC = GetAOPFunc(GET_AOP_FLAG(imessage));
-   if(!AOP_FUNC)
+   pl->AOP_FUNC = GetAOPFunc(GET_AOP_FLAG(imessage));
+   if(!pl->AOP_FUNC)
       return FUSEDMM_AOP_FAIL_RETURN;
-   
 /*
- *  Implementation 
+ * partial results of a heavy row can only be combined by these AOP 
  */
-#if defined(PTTIME) && defined(LOAD_BALANCE)
-   omp_set_num_threads(NTHREADS);
-   #pragma omp parallel reduction(+:status)  
-   {
-      INDEXTYPE RowPerThd, tt;
-      INDEXTYPE i, rowb, rowe;
-      INDEXTYPE Mnnz = 0; /* non-zero count in M rows  */
-      INDEXTYPE deg, cumRow, curRow;
-      INDEXTYPE id = omp_get_thread_num();
-      INDEXTYPE nthreads = omp_get_num_threads(); 
-      // ASSUMPTION: dimension k is small enough to fit in stack, 
-      //    need to use some efficient allocator otherwise  
-      VALUETYPE T[k]; /* temporary space to hold result of vector compute */
-      
-      for (i=0; i < m; i++)
-         Mnnz += (pntre[i] - pntrb[i]); 
-      RowPerThd = Mnnz / nthreads; 
-      
-      curRow = cumRow = 0; 
-      tt = 1; 
-      rowe = -1;  /* init */
-      /* set rowstart for 1st thread */ 
-      if (id == 0) 
-         rowb = 0;
-      for (i=0; i < m; i++)
-      {
-         deg = pntre[i] - pntrb[i]; 
-         cumRow += deg;
-         curRow += deg;
-         if (curRow > RowPerThd)
-         {
-            if (tt == id)
-               rowb = i; 
-            else if (tt == id+1)
-               rowe = i; 
-            curRow = 0;
-            RowPerThd = (Mnnz - cumRow) / (nthreads - tt);
-            tt += 1; 
-         }
+   pl->splitok = (GET_AOP_FLAG(imessage) == AOP_ADD 
+                 || GET_AOP_FLAG(imessage) == AOP_MAX 
+                 || GET_AOP_FLAG(imessage) == AOP_MIN)
+                 && GET_SOP_FLAG(imessage) != SOP_SOFTMAX;
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+/*
+ * General fusedMM of a row with SOP_SOFTMAX: 1st pass computes the max and 
+ * the sum of exp of the scalars of the edges (sum is rescaled when the max is
+ * raised), 2nd pass recomputes each scalar and applies VSC and AOP with its 
+ * softmax 
+ */
+static int GenSoftmaxRow(const fusedMM_plan_t *plan, const INDEXTYPE jb, 
+      const INDEXTYPE je, const VALUETYPE *val, const VALUETYPE *lhs, 
+      const VALUETYPE *y, const INDEXTYPE ldy, VALUETYPE *O, VALUETYPE *T)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const COLINDEXTYPE *indx = plan->indx; 
+   VALUETYPE smax = -HUGE_VAL, ssum = 0.0; 
+
+   for (INDEXTYPE j=jb; j < je; j++)
+   {
+      VALUETYPE scal = val[j]; 
+      
+      status += plan->VOP_FUNC(k, lhs, k, y + indx[j] * ldy, k, T);
+      status += plan->ROP_FUNC(k, lhs, k, T, &scal);
+      if (scal > smax)
+      {
+         ssum = ssum * exp(smax - scal) + 1.0; 
+         smax = scal; 
       }
-      if (tt == id+1)
-         rowe = m; 
+      else
+         ssum += exp(scal - smax); 
+   }
+   for (INDEXTYPE j=jb; j < je; j++)
+   {
+      VALUETYPE scal = val[j]; 
+      
+      status += plan->VOP_FUNC(k, lhs, k, y + indx[j] * ldy, k, T);
+      status += plan->ROP_FUNC(k, lhs, k, T, &scal);
+      status += plan->VSC_FUNC(k, T, exp(scal - smax) / ssum, k, T);
+      status += plan->AOP_FUNC(k, T, k, O);
+   }
+   return status;
+}
+/*
+ * General fusedMM of nonzeros jb to je-1 of a row using the operation of 
+ * each stage, lhs = Xi, O = Zi, T: scratch space of k elements  
+ */
+static int GenFusedMMRow(const fusedMM_plan_t *plan, const INDEXTYPE jb, 
+      const INDEXTYPE je, const VALUETYPE *val, const VALUETYPE *lhs, 
+      const VALUETYPE *y, const INDEXTYPE ldy, VALUETYPE *O, VALUETYPE *T)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const COLINDEXTYPE *indx = plan->indx; 
+   FP_VOP_FUNC VOP_FUNC = plan->VOP_FUNC;
+   FP_ROP_FUNC ROP_FUNC = plan->ROP_FUNC;
+   FP_SOP_FUNC SOP_FUNC = plan->SOP_FUNC;
+   FP_VSC_FUNC VSC_FUNC = plan->VSC_FUNC;
+   FP_AOP_FUNC AOP_FUNC = plan->AOP_FUNC;
+
+   if (GET_SOP_FLAG(plan->imessage) == SOP_SOFTMAX)
+      return GenSoftmaxRow(plan, jb, je, val, lhs, y, ldy, O, T);
+   for (INDEXTYPE j=jb; j < je; j++)
+   {
+      VALUETYPE scal, out; 
+      const VALUETYPE *cT = T; /* where T is const */ 
+      INDEXTYPE cid = indx[j];
+      const VALUETYPE *rhs = y + cid * ldy; 
+/*
+ *    scal init with val be default to manage SPMM type operation
+ *    It will be overwritten when ROP is used 
+ *    HERE HERE, default value of out??? 
+ */
+      scal = val[j];
+   #ifdef DEBUG
+      status += 
+   #endif
+         VOP_FUNC(k,lhs,k,rhs,k,T);
+   #ifdef DEBUG
+      status += 
+   #endif
+         ROP_FUNC(k,lhs,k,cT, &scal);
+   #ifdef DEBUG
+      status += 
+   #endif
+         SOP_FUNC(scal, &out);
+   #ifdef DEBUG
+      status += 
+   #endif
+         VSC_FUNC(k,T,out, k,T);
+   #ifdef DEBUG
+      status += 
+   #endif
+         AOP_FUNC(k, T, k, O);
+   }
+   return status;
+}
+/*
+ * General fusedMM using the operation of each stage:
+ *    rowb = NULL: rows are scheduled by openmp (static or DYNAMIC)
+ *    otherwise: partition t has rows rowb[t] to rowb[t+1]-1, t < npart
+ */
+static int GenFusedMM(const fusedMM_plan_t *plan, const INDEXTYPE npart, 
+      const INDEXTYPE *rowb, const INDEXTYPE *pntre, const VALUETYPE *val, 
+      const VALUETYPE *x, const INDEXTYPE ldx, const VALUETYPE *y, 
+      const INDEXTYPE ldy, VALUETYPE *z, const INDEXTYPE ldz)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const INDEXTYPE *pntrb = plan->pntrb; 
+   const INDEXTYPE np = rowb ? npart : plan->m; 
 
-      for (i=rowb; i < rowe; i++)
-#else /* not LBD or not PTTIME */
+#ifdef PTTIME
+   #pragma omp parallel num_threads(plan->nthreads) reduction(+:status)  
+#endif
+   {
+      // ASSUMPTION: feature dimension k is small enough to fit in stack, 
+      //    need to use some efficient allocator otherwise  
+      VALUETYPE Tl[k]; /* temporary space to hold result of vector compute */
    #ifdef PTTIME
-      #ifdef NTHREADS
-      omp_set_num_threads(NTHREADS);
-      #endif
       #ifdef DYNAMIC
-         #ifdef DEBUG 
-            #pragma omp parallel for schedule(dynamic) reduction(+:status)  
-         #else
-            #pragma omp parallel for schedule(dynamic)   
-         #endif
+         #pragma omp for schedule(dynamic)   
       #else
-         #ifdef DEBUG 
-            #pragma omp parallel for schedule(static) reduction(+:status)  
-         #else
-            #pragma omp parallel for schedule(static)   
-         #endif
+         #pragma omp for schedule(static)   
       #endif
    #endif
-      for (INDEXTYPE i = 0; i < m; i++)
+      for (INDEXTYPE t = 0; t < np; t++)
+      {
+         /* plan keeps scratch space for each partition */
+         VALUETYPE *T = (rowb && plan->work) ? plan->work + t * k : Tl; 
+         const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+
+         for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+            status += GenFusedMMRow(plan, pntrb[i], pntre[i], val, 
+                  x + i * ldx, y, ldy, z + i * ldz, T);
+      }
+   }
+   return status;
+}
+/*
+ * cost of a row relative to a nonzero, when partitioning rows among threads.
+ * 0 balances only the nonzeros, rows with no or few nonzeros still need to
+ * load/store a row of Z  
+ */
+#ifndef PART_ROW_COST
+   #define PART_ROW_COST 1 
+#endif
+/*
+ * prefix sum of cost of rows: ps[i] = cost of rows 0 to i-1, parallel scan 
+ * same as scan in test/include/utility.h 
+ */
+static void RowCostScan(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE rowcost, 
+      const INDEXTYPE nthreads, INDEXTYPE *ps)
+{
+   ps[0] = 0;
+#ifdef PTTIME
+   if (m >= (1<<17) && nthreads > 1) 
+   {
+      #pragma omp parallel num_threads(nthreads)
+      {
+         INDEXTYPE id = omp_get_thread_num();
+         INDEXTYPE nt = omp_get_num_threads(); 
+         INDEXTYPE chunk = (m + nt - 1) / nt;
+         INDEXTYPE rb = (id*chunk < m) ? id*chunk : m; 
+         INDEXTYPE re = (rb+chunk < m) ? rb+chunk : m;
+         INDEXTYPE sum = 0, offset = 0; 
+         
+         /* thread level prefix sum */
+         for (INDEXTYPE i = rb; i < re; i++)
+         {
+            sum += pntre[i] - pntrb[i] + rowcost;
+            ps[i+1] = sum; 
+         }
+         #pragma omp barrier
+         /* last element of each previous chunk is the sum of the chunk */
+         for (INDEXTYPE t = 0; t < id && t*chunk < m; t++)
+            offset += ps[((t+1)*chunk < m) ? (t+1)*chunk : m];
+         #pragma omp barrier
+         for (INDEXTYPE i = rb; i < re; i++)
+            ps[i+1] += offset;
+      }
+      return;
+   }
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+      ps[i+1] = ps[i] + pntre[i] - pntrb[i] + rowcost;
+}
+/*
+ * Partition rows of the sparse matrix among nthreads based on cost, 
+ * partition t gets the rows rowb[t] to rowb[t+1]-1. Start of partition t is 
+ * the first row where the prefix sum of cost reaches t/nthreads of the total
+ * cost. 
+ */
+void GetRowPartition(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE nthreads, 
+      const INDEXTYPE rowcost, INDEXTYPE *rowb)
+{
+   INDEXTYPE *ps = NULL, total; 
+/*
+ * pntrb is already the prefix sum of nonzeros when rows are stored 
+ * contiguously (pntre = pntrb+1), scan only otherwise    
+ */
+   #define ROWCOST_PS(i_) (ps ? ps[i_] : ((i_) < m ? pntrb[i_] : pntre[m-1]) \
+                                         - pntrb[0] + (i_)*rowcost)
+   rowb[0] = 0; 
+   rowb[nthreads] = m; 
+   if (m == 0 || nthreads == 1)
+   {
+      for (INDEXTYPE t = 1; t < nthreads; t++)
+         rowb[t] = m;
+      return;
+   }
+   if (pntre != pntrb+1)
+   {
+      ps = (INDEXTYPE*) malloc((m+1)*sizeof(INDEXTYPE));
+      if (!ps) /* not enough memory, partition rows evenly */
+      {
+         for (INDEXTYPE t = 1; t < nthreads; t++)
+            rowb[t] = (m * t) / nthreads;
+         return;
+      }
+      RowCostScan(m, pntrb, pntre, rowcost, nthreads, ps);
+   }
+   total = ROWCOST_PS(m);
+   for (INDEXTYPE t = 1; t < nthreads; t++)
+   {
+      INDEXTYPE target = (total * t) / nthreads;  
+      INDEXTYPE lo = rowb[t-1], hi = m; 
+      /* binary search: first row with prefix sum >= target */
+      while (lo < hi)
+      {
+         INDEXTYPE mid = lo + (hi - lo) / 2; 
+         if (ROWCOST_PS(mid) < target)
+            lo = mid + 1; 
+         else
+            hi = mid;
+      }
+      rowb[t] = lo; 
+   }
+   #undef ROWCOST_PS
+   if (ps)
+      free(ps);
+}
+/*
+ * Heavy rows: a row with more nonzeros than the threshold is removed from the
+ * row partition and split into chunks of at most threshold nonzeros. Chunks 
+ * are computed in parallel into private rows and combined in the order of 
+ * chunks (deterministic for a given number of threads), see ExecHeavyRows.
+ * threshold = max(nnz / (HEAVY_ROW_RATIO * nthreads), HEAVY_ROW_MIN)
+ * NO_SPLIT_HEAVY_ROW disables the split 
+ */
+#ifndef HEAVY_ROW_RATIO
+   #define HEAVY_ROW_RATIO 4 
+#endif
+#ifndef HEAVY_ROW_MIN
+   #define HEAVY_ROW_MIN 1024 
+#endif
+
+fusedMM_part_t *CreatePartition(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE nthreads)
+{
+   fusedMM_part_t *part; 
+   INDEXTYPE nnz = 0, maxdeg = 0, nheavy = 0, nchunk = 0, L = 0, *p; 
+
+   part = (fusedMM_part_t*) calloc(1, sizeof(fusedMM_part_t));
+   if (!part)
+      return NULL;
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(nthreads) schedule(static) \
+      reduction(+:nnz) reduction(max:maxdeg)
 #endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      const INDEXTYPE deg = pntre[i] - pntrb[i];
+      nnz += deg;
+      maxdeg = (deg > maxdeg) ? deg : maxdeg;
+   }
+   part->maxdeg = maxdeg; 
+#ifndef NO_SPLIT_HEAVY_ROW
+   if (nthreads > 1)
+   {
+      L = nnz / (HEAVY_ROW_RATIO * nthreads); 
+      L = (L > HEAVY_ROW_MIN) ? L : HEAVY_ROW_MIN; 
+   #ifdef PTTIME
+      #pragma omp parallel for num_threads(nthreads) schedule(static) \
+         reduction(+:nheavy, nchunk) 
+   #endif
+      for (INDEXTYPE i = 0; i < m; i++)
       {
-         const VALUETYPE *lhs = x + i * ldx; // Xi 
-         VALUETYPE *O = z + i * ldz;  // Zi
-#ifndef LOAD_BALANCE
-         // ASSUMPTION: feature dimension k is small enough to fit in stack, 
-         //    need to use some efficient allocator otherwise  
-         VALUETYPE T[k]; /* temporary space to hold result of vector compute */
+         const INDEXTYPE deg = pntre[i] - pntrb[i];
+         if (deg > L)
+         {
+            nheavy++;
+            nchunk += (deg + L - 1) / L;
+         }
+      }
+   }
 #endif
-         for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
+/*
+ * all arrays are allocated in a single block starting at rowb  
+ */
+   p = (INDEXTYPE*) malloc((2*(nthreads+1) + 2*nheavy + 1 + 3*nchunk 
+                            + (nheavy ? m : 0)) * sizeof(INDEXTYPE));
+   if (!p)
+   {
+      free(part);
+      return NULL;
+   }
+   part->nthreads = nthreads; 
+   part->nheavy = nheavy; 
+   part->rowb = p; p += nthreads + 1; 
+   GetRowPartition(m, pntrb, pntre, nthreads, PART_ROW_COST, part->rowb);
+   if (!nheavy)
+   {
+      part->lrowb = part->rowb; 
+      return part;
+   }
+   part->lrowb = p; p += nthreads + 1; 
+   part->hrow = p; p += nheavy; 
+   part->hchunk = p; p += nheavy + 1; 
+   part->crow = p; p += nchunk; 
+   part->cb = p; p += nchunk; 
+   part->ce = p; p += nchunk; 
+   part->pntre = p;
+   for (INDEXTYPE i = 0, h = 0, c = 0; i < m; i++)
+   {
+      part->pntre[i] = pntre[i];
+      if (pntre[i] - pntrb[i] > L)
+      {
+         part->pntre[i] = pntrb[i]; /* empty in the row partition */
+         part->hrow[h] = i; 
+         part->hchunk[h++] = c; 
+         for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j += L, c++)
          {
-            VALUETYPE scal, out; 
-            const VALUETYPE *cT = T; /* where T is const */ 
-            INDEXTYPE cid = indx[j];
-            const VALUETYPE *rhs = y + cid * ldy; 
-/*
- *          scal init with val be default to manage SPMM type operation
- *          It will be overwritten when ROP is used 
- *          HERE HERE, default value of out??? 
- */
-            scal = val[j];
-         #ifdef DEBUG
-            status += 
-         #endif
-               VOP_FUNC(k,lhs,k,rhs,k,T);
-         #ifdef DEBUG
-            status += 
-         #endif
-               ROP_FUNC(k,lhs,k,cT, &scal);
-         #ifdef DEBUG
-            status += 
-         #endif
-               SOP_FUNC(scal, &out);
-         #ifdef DEBUG
-            status += 
-         #endif
-               VSC_FUNC(k,T,out, k,T);
-         #ifdef DEBUG
-            status += 
-         #endif
-               AOP_FUNC(k, T, k, O);
+            part->crow[c] = i; 
+            part->cb[c] = j; 
+            part->ce[c] = (j + L < pntre[i]) ? j + L : pntre[i];
          }
       }
-#if defined(PTTIME) && defined(LOAD_BALANCE)
    }
+   part->hchunk[nheavy] = nchunk; 
+   GetRowPartition(m, pntrb, part->pntre, nthreads, PART_ROW_COST, 
+         part->lrowb);
+   return part;
+}
+
+void DestroyPartition(fusedMM_part_t *part)
+{
+   if (!part)
+      return;
+   if (part->rowb)
+      free(part->rowb);
+   free(part);
+}
+/*
+ * Cache of partitions, least recently used entry is replaced when full. 
+ * Entry can still be in use by other threads when it is replaced, it is 
+ * destroyed by the last release then  
+ */
+#ifndef PART_CACHE_SIZE
+   #define PART_CACHE_SIZE 8
+#endif
+static fusedMM_part_t *PartCache[PART_CACHE_SIZE];
+static uint64_t PartCacheClock = 0; 
+#ifdef PART_CHECKSUM
+/*
+ * checksum of the row pointers: each row is hashed with its index, so rows 
+ * swapped or moved are detected as well as updated degrees. It is O(m), so 
+ * only computed when cached partitions are validated (debug builds)
+ */
+static uint64_t RowPtrChecksum(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE nthreads)
+{
+   uint64_t sum = 0; 
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(nthreads) schedule(static) \
+      reduction(+:sum) if(m >= (1<<17))
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      uint64_t h = ((uint64_t) pntrb[i] * 0x9E3779B97F4A7C15ULL) 
+                   ^ (uint64_t) pntre[i]; 
+      sum += (h ^ (h >> 29)) * (2 * (uint64_t) i + 1); 
+   }
+   return sum;
+}
+#endif
+
+fusedMM_part_t *AcquirePartition(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE nthreads)
+{
+   fusedMM_part_t *part = NULL, *old = NULL; 
+   const INDEXTYPE nnz = m ? pntre[m-1] - pntrb[0] : 0;
+#ifdef PART_CHECKSUM
+   const uint64_t cksum = RowPtrChecksum(m, pntrb, pntre, nthreads);
+#else
+   const uint64_t cksum = 0; /* key only, see fusedMM_partition_cache_clear */
+#endif
+
+#ifdef PTTIME
+   #pragma omp critical(fusedMM_partition_cache)
+#endif
+   for (int e = 0; e < PART_CACHE_SIZE; e++)
+   {
+      fusedMM_part_t *cp = PartCache[e]; 
+      if (cp && cp->kpntrb == pntrb && cp->kpntre == pntre && cp->m == m 
+            && cp->nnz == nnz && cp->nthreads == nthreads 
+            && cp->cksum == cksum)
+      {
+         cp->refcnt++;
+         cp->stamp = ++PartCacheClock;
+         part = cp; 
+         break;
+      }
+   }
+   if (part)
+      return part;
+/*
+ * compute outside of critical section, it is parallel itself
+ */
+   part = CreatePartition(m, pntrb, pntre, nthreads);
+   if (!part) /* not enough memory, rows are scheduled by openmp */
+      return NULL;
+   part->kpntrb = pntrb; 
+   part->kpntre = pntre; 
+   part->m = m; 
+   part->nnz = nnz; 
+   part->cksum = cksum; 
+   part->refcnt = 1; 
+   part->cached = 1;
+#ifdef PTTIME
+   #pragma omp critical(fusedMM_partition_cache)
+#endif
+   {
+      int lru = -1; 
+      /* stale entry of the same rowptr (nnz or checksum changed) goes first */
+      for (int e = 0; e < PART_CACHE_SIZE; e++)
+         if (PartCache[e] && PartCache[e]->kpntrb == pntrb 
+               && PartCache[e]->kpntre == pntre && PartCache[e]->m == m 
+               && PartCache[e]->nthreads == nthreads)
+            lru = e; 
+      if (lru < 0)
+      {
+         lru = 0; 
+         for (int e = 0; e < PART_CACHE_SIZE; e++)
+            if (!PartCache[e] || (PartCache[lru] 
+                     && PartCache[e]->stamp < PartCache[lru]->stamp))
+               lru = e;
+      }
+      old = PartCache[lru]; 
+      if (old)
+      {
+         old->cached = 0; 
+         if (old->refcnt) /* destroyed by the last release */
+            old = NULL; 
+      }
+      part->stamp = ++PartCacheClock;
+      PartCache[lru] = part; 
+   }
+   DestroyPartition(old);
+   return part;
+}
+
+void ReleasePartition(fusedMM_part_t *part)
+{
+   int unused; 
+   if (!part)
+      return;
+#ifdef PTTIME
+   #pragma omp critical(fusedMM_partition_cache)
+#endif
+   {
+      part->refcnt--;
+      unused = !part->refcnt && !part->cached; 
+   }
+   if (unused)
+      DestroyPartition(part);
+}
+
+void fusedMM_partition_cache_clear(void)
+{
+#ifdef PTTIME
+   #pragma omp critical(fusedMM_partition_cache)
+#endif
+   for (int e = 0; e < PART_CACHE_SIZE; e++)
+   {
+      if (PartCache[e])
+      {
+         PartCache[e]->cached = 0; 
+         if (!PartCache[e]->refcnt)
+            DestroyPartition(PartCache[e]);
+      }
+      PartCache[e] = NULL; 
+   }
+}
+/*
+ * Heavy rows of the partition, the rows themselves are computed as empty rows
+ * by the kernel. Each chunk of nonzeros is computed as an one row sparse 
+ * matrix into a private row P, then the chunks of each row are combined to Z
+ * in order using AOP. Optimized max and min kernels compute 
+ * max(alpha * func, beta * Z): the chunks of a row are combined first, then 
+ * scaled by alpha and combined to Z (beta * Z, or replace it when beta = 0) 
+ */
+static int ExecHeavyRows
+(
+   const fusedMM_plan_t *plan,
+   const fusedMM_part_t *part,
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const VALUETYPE *val,      // value of non-zeros 
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X   
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y   
+   const VALUETYPE beta,      // beta value, used by max and min kernels 
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z 
+)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const INDEXTYPE nchunk = part->hchunk[part->nheavy];
+   VALUETYPE init = 0.0;      /* identity of AOP */
+   VALUETYPE *P; 
+   int maxmin = 0;            /* optimized max or min kernel */
+#ifdef ENABLE_OPT_FUSEDMM
+   /* chunk of optimized kernel: Pc = alpha * func + Pc, where Pc = 0 */
+   FP_OPT_KERN_FUNC kern = (alpha == 1.0) ? plan->kern_b1 : plan->kern_bx; 
+
+   maxmin = (plan->tkern == 'x' || plan->tkern == 'n'); 
+   if (maxmin) /* Pc = max(func, Pc) */
+      kern = plan->kern_b1; 
+#endif
+
+   if (GET_AOP_FLAG(plan->imessage) == AOP_MAX)
+      init = -HUGE_VAL;
+   else if (GET_AOP_FLAG(plan->imessage) == AOP_MIN)
+      init = HUGE_VAL;
+
+   P = (VALUETYPE*) malloc(nchunk*k*sizeof(VALUETYPE));
+   if (!P)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+#ifdef PTTIME
+   #pragma omp parallel num_threads(plan->nthreads) reduction(+:status)  
 #endif
+   {
+      // ASSUMPTION: feature dimension k is small enough to fit in stack, 
+      //    need to use some efficient allocator otherwise  
+      VALUETYPE T[k]; /* temporary space to hold result of vector compute */
+   #ifdef PTTIME
+      #pragma omp for schedule(dynamic)   
+   #endif
+      for (INDEXTYPE c = 0; c < nchunk; c++)
+      {
+         const INDEXTYPE i = part->crow[c];
+         VALUETYPE *Pc = P + c * k; 
+         
+         for (INDEXTYPE kk = 0; kk < k; kk++)
+            Pc[kk] = init; 
+      #ifdef ENABLE_OPT_FUSEDMM
+         if (plan->tkern)
+            kern(plan->tkern, 1, plan->n, k, alpha, 
+                  part->ce[c] - part->cb[c], 1, plan->cols, val, plan->indx,
+                  part->cb + c, part->ce + c, x + i * ldx, ldx, y, ldy, 1.0, 
+                  Pc, k, 1, NULL);
+         else
+      #endif
+         if (plan->spec_kern)
+            status += plan->spec_kern(0, 1, k, val, plan->indx, part->cb + c, 
+                  part->ce + c, x + i * ldx, ldx, y, ldy, Pc, k, T);
+         else
+            status += GenFusedMMRow(plan, part->cb[c], part->ce[c], val, 
+                  x + i * ldx, y, ldy, Pc, T);
+      }
+   #ifdef PTTIME
+      #pragma omp for schedule(dynamic)   
+   #endif
+      for (INDEXTYPE h = 0; h < part->nheavy; h++)
+      {
+         VALUETYPE *O = z + part->hrow[h] * ldz; 
+         if (maxmin)
+         {
+            VALUETYPE *P0 = P + part->hchunk[h] * k; 
+            for (INDEXTYPE c = part->hchunk[h]+1; c < part->hchunk[h+1]; c++)
+               plan->AOP_FUNC(k, P + c * k, k, P0);
+            if (alpha != 1.0)
+               for (INDEXTYPE kk = 0; kk < k; kk++)
+                  P0[kk] *= alpha; 
+            if (beta == 0.0)
+               memcpy(O, P0, k * sizeof(VALUETYPE));
+            else
+               plan->AOP_FUNC(k, P0, k, O);
+            continue;
+         }
+         for (INDEXTYPE c = part->hchunk[h]; c < part->hchunk[h+1]; c++)
+            plan->AOP_FUNC(k, P + c * k, k, O);
+      }
+   }
+   free(P);
    return status;
 }
 
-#ifdef __cplusplus
-   } // extern "C"
+int fusedMM_csr 
+(
+   const int32_t imessage,    // message to dictate the operations  
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix 
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix 
+   const VALUETYPE *val,      // value of non-zeros 
+   const COLINDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X   
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y   
+   const VALUETYPE beta,      // beta value 
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z 
+)
+{
+   int status;
+   fusedMM_plan_t pl; 
+
+   status = InitPlan(&pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb, 
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+#if defined(PTTIME) && defined(LOAD_BALANCE)
+/*
+ * partition rows among threads, computed once for the sparse matrix
+ */
+   pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
 #endif
+   status = fusedMM_plan_execute(&pl, alpha, val, x, ldx, y, ldy, beta, z, 
+         ldz);
+   ReleasePartition(pl.part);
+   return status;
+}
+
+int fusedMM_csc 
+(
+   const int32_t imessage,    // message to dictate the operations  
+   const INDEXTYPE m,         // number of row of X and Z
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix 
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix 
+   const VALUETYPE *val,      // value of non-zeros in CSC order
+   const COLINDEXTYPE *indx,  // rowids -> row indices 
+   const INDEXTYPE *pntrb,    // starting of colptr for each column
+   const INDEXTYPE *pntre,    // ending of colptr for each column
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X   
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y   
+   const VALUETYPE beta,      // beta value 
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z 
+)
+{
+/*
+ * CSC of A is the CSR of A^T (cols x rows): a column is a row of the kernels
+ */
+   return fusedMM_csr(imessage, m, n, k, alpha, nnz, cols, rows, val, indx, 
+         pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);
+}
+
+/*=============================================================================
+ * Half precision storage of X and Y, see fusedMM_csr_half in fusedMM.h
+ *============================================================================*/
+static uint16_t Fp32ToBf16(const float f)
+{
+   uint32_t u;
+
+   memcpy(&u, &f, sizeof(u));
+   if ((u & 0x7FFFFFFF) > 0x7F800000) /* nan, keep it quiet */
+      return (uint16_t) ((u >> 16) | 0x40);
+   u += 0x7FFF + ((u >> 16) & 1); /* round to nearest even */
+   return (uint16_t) (u >> 16);
+}
+
+static uint16_t Fp32ToFp16(const float f)
+{
+   uint32_t u, s, e, mt, h, r, half, sh;
+
+   memcpy(&u, &f, sizeof(u));
+   s = (u >> 16) & 0x8000;
+   e = (u >> 23) & 0xFF;
+   mt = u & 0x7FFFFF;
+   if (e == 0xFF) /* inf and nan */
+      return (uint16_t) (s | 0x7C00 | (mt ? 0x200 : 0));
+   if (e > 142) /* overflow */
+      return (uint16_t) (s | 0x7C00);
+   if (e >= 113) /* normal, carry of rounding may reach inf */
+   {
+      h = ((e - 112) << 10) | (mt >> 13);
+      r = mt & 0x1FFF;
+      if (r > 0x1000 || (r == 0x1000 && (h & 1)))
+         h++;
+      return (uint16_t) (s | h);
+   }
+   if (e < 102) /* less than half of the smallest subnormal */
+      return (uint16_t) s;
+/*
+ * subnormal: multiple of 2^-24
+ */
+   mt |= 0x800000;
+   sh = 126 - e;
+   h = mt >> sh;
+   r = mt & ((1U << sh) - 1);
+   half = 1U << (sh - 1);
+   if (r > half || (r == half && (h & 1)))
+      h++;
+   return (uint16_t) (s | h);
+}
 
+int fusedMM_cvt_half(const int dtype, const INDEXTYPE n, const VALUETYPE *in,
+      uint16_t *out)
+{
+   if (dtype == FUSEDMM_BF16)
+   {
+      for (INDEXTYPE i = 0; i < n; i++)
+         out[i] = Fp32ToBf16(in[i]);
+   }
+   else if (dtype == FUSEDMM_FP16)
+   {
+      for (INDEXTYPE i = 0; i < n; i++)
+         out[i] = Fp32ToFp16(in[i]);
+   }
+   else
+      return FUSEDMM_FAIL_RETURN;
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+int fusedMM_cvt_float(const int dtype, const INDEXTYPE n, const uint16_t *in,
+      VALUETYPE *out)
+{
+   if (dtype == FUSEDMM_BF16)
+   {
+      for (INDEXTYPE i = 0; i < n; i++)
+         out[i] = bf16_to_fp32(in[i]);
+   }
+   else if (dtype == FUSEDMM_FP16)
+   {
+      for (INDEXTYPE i = 0; i < n; i++)
+         out[i] = fp16_to_fp32(in[i]);
+   }
+   else
+      return FUSEDMM_FAIL_RETURN;
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+int fusedMM_quantize_i8(const INDEXTYPE n, const INDEXTYPE k, 
+      const VALUETYPE *y, const INDEXTYPE ldy, int8_t *q, const INDEXTYPE ldq,
+      VALUETYPE *yq)
+{
+   for (INDEXTYPE j = 0; j < n; j++)
+   {
+      const VALUETYPE *Yj = y + j * ldy; 
+      int8_t *Qj = q + j * ldq; 
+      VALUETYPE mn = 0, mx = 0, sc, zp; 
+
+      for (INDEXTYPE kk = 0; kk < k; kk++)
+      {
+         if (Yj[kk] < mn) mn = Yj[kk];
+         if (Yj[kk] > mx) mx = Yj[kk];
+      }
+      sc = (mx - mn) / 255; 
+      if (sc == 0)
+         sc = 1; 
+      zp = -128 - mn / sc; 
+      for (INDEXTYPE kk = 0; kk < k; kk++)
+      {
+         VALUETYPE v = Yj[kk] / sc + zp; 
+         v = v < -128 ? -128 : (v > 127 ? 127 : v); 
+         Qj[kk] = (int8_t) lrint(v); 
+      }
+      yq[2*j] = sc; 
+      yq[2*j+1] = zp; 
+   }
+   return FUSEDMM_SUCCESS_RETURN;
+}
+#ifdef ENABLE_OPT_FUSEDMM
+/*
+ * operation of each stage for the general fusedMM when InitPlan selected an 
+ * optimized kernel which has no variant for the storage of X and Y (or the 
+ * per-edge output) 
+ */
+static int SetStageFuncs(fusedMM_plan_t *pl, const int32_t imessage)
+{
+   pl->VOP_FUNC = GetVOPFunc(GET_VOP_FLAG(imessage));
+   pl->ROP_FUNC = GetROPFunc(GET_ROP_FLAG(imessage));
+   pl->SOP_FUNC = GetSOPFunc(GET_SOP_FLAG(imessage));
+   pl->VSC_FUNC = GetVSCFunc(GET_VSC_FLAG(imessage));
+   pl->AOP_FUNC = GetAOPFunc(GET_AOP_FLAG(imessage));
+   if (!pl->VOP_FUNC || !pl->ROP_FUNC || !pl->SOP_FUNC || !pl->VSC_FUNC
+         || !pl->AOP_FUNC)
+      return FUSEDMM_FAIL_RETURN;
+   return FUSEDMM_SUCCESS_RETURN;
+}
+#endif
+#ifndef DREAL
+/*
+ * row i of a dense matrix of dtype as VALUETYPE, converted into buf unless 
+ * dtype is 0 (VALUETYPE). pq: scale and zero-point of FUSEDMM_INT8 rows 
+ */
+static const VALUETYPE *LoadRow(const int dtype, const INDEXTYPE k, 
+      const void *p, const INDEXTYPE ld, const INDEXTYPE i, 
+      const VALUETYPE *pq, VALUETYPE *buf)
+{
+   if (dtype == FUSEDMM_BF16 || dtype == FUSEDMM_FP16)
+      fusedMM_cvt_float(dtype, k, (const uint16_t*) p + i * ld, buf);
+   else if (dtype == FUSEDMM_INT8)
+   {
+      const int8_t *q = (const int8_t*) p + i * ld; 
+      for (INDEXTYPE kk = 0; kk < k; kk++)
+         buf[kk] = pq[2*i] * (q[kk] - pq[2*i+1]); 
+   }
+   else
+      return (const VALUETYPE*) p + i * ld; 
+   return buf; 
+}
+/*
+ * General fusedMM of X and Y stored in xtype and ytype: Xi and each Yj are 
+ * converted to VALUETYPE and computed by the operation of each stage, same as
+ * GenFusedMM otherwise
+ */
+static int GenFusedMMCvt(const fusedMM_plan_t *plan, const int xtype,
+      const int ytype, const INDEXTYPE npart, const INDEXTYPE *rowb, 
+      const VALUETYPE *val, const void *x, const INDEXTYPE ldx, const void *y,
+      const INDEXTYPE ldy, const VALUETYPE *yq, VALUETYPE *z, 
+      const INDEXTYPE ldz)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const INDEXTYPE *pntrb = plan->pntrb;
+   const INDEXTYPE *pntre = plan->pntre;
+   const INDEXTYPE np = rowb ? npart : plan->m;
+
+#ifdef PTTIME
+   #pragma omp parallel num_threads(plan->nthreads) reduction(+:status)
+#endif
+   {
+      // ASSUMPTION: feature dimension k is small enough to fit in stack
+      VALUETYPE Xl[k], Yl[k], T[k];
+   #ifdef PTTIME
+      #ifdef DYNAMIC
+         #pragma omp for schedule(dynamic)
+      #else
+         #pragma omp for schedule(static)
+      #endif
+   #endif
+      for (INDEXTYPE t = 0; t < np; t++)
+      {
+         const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1;
+
+         for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+         {
+            VALUETYPE *O = z + i * ldz;
+            const VALUETYPE *Xi;
+
+            if (pntre[i] == pntrb[i])
+               continue;
+            Xi = LoadRow(xtype, k, x, ldx, i, NULL, Xl);
+            for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+            {
+               VALUETYPE scal = val[j], out;
+               const VALUETYPE *Yj = LoadRow(ytype, k, y, ldy, plan->indx[j],
+                     yq, Yl);
+
+               status += plan->VOP_FUNC(k, Xi, k, Yj, k, T);
+               status += plan->ROP_FUNC(k, Xi, k, T, &scal);
+               status += plan->SOP_FUNC(scal, &out);
+               status += plan->VSC_FUNC(k, T, out, k, T);
+               status += plan->AOP_FUNC(k, T, k, O);
+            }
+         }
+      }
+   }
+   return status;
+}
+#endif
+
+int fusedMM_csr_half
+(
+   const int32_t imessage,    // message to dictate the operations
+   const int dtype,           // FUSEDMM_[BF16,FP16]: type of X and Y
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix
+   const VALUETYPE *val,      // value of non-zeros
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const uint16_t *x,         // Dense X matrix of dtype
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const uint16_t *y,         // Dense Y matrix of dtype
+   const INDEXTYPE ldy,       // leading dimension of Y
+   const VALUETYPE beta,      // beta value
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z
+)
+{
+#ifdef DREAL
+   return FUSEDMM_NO_OPT_IMPL;
+#else
+   int status;
+   fusedMM_plan_t pl;
+   INDEXTYPE npart;
+   const INDEXTYPE *rowb;
+
+   if (dtype != FUSEDMM_BF16 && dtype != FUSEDMM_FP16)
+      return FUSEDMM_FAIL_RETURN;
+/* softmax of the edges of a row is only supported by fusedMM_csr */
+   if (GET_SOP_FLAG(imessage) == SOP_SOFTMAX)
+      return FUSEDMM_SOP_FAIL_RETURN;
+   status = InitPlan(&pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb,
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+#if defined(PTTIME) && defined(LOAD_BALANCE)
+   pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
+#endif
+   npart = pl.part ? pl.part->nthreads : pl.nthreads;
+   rowb = pl.part ? pl.part->rowb : NULL;
+#ifdef ENABLE_OPT_FUSEDMM
+   if (pl.tkern)
+   {
+      kern_sgfusedMM_half_t kern = sgfusedMM_half_getkern(dtype, pl.tkern, k,
+            alpha, beta);
+      if (kern)
+      {
+         kern(pl.tkern, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb,
+              pntre, x, ldx, y, ldy, beta, z, ldz, npart, rowb);
+         ReleasePartition(pl.part);
+         return FUSEDMM_SUCCESS_RETURN;
+      }
+/*
+ *    no half kernel for the message or k: general fusedMM of the message
+ */
+      if (SetStageFuncs(&pl, imessage) != FUSEDMM_SUCCESS_RETURN)
+      {
+         ReleasePartition(pl.part);
+         return FUSEDMM_FAIL_RETURN;
+      }
+   }
+#endif
+   status = GenFusedMMCvt(&pl, dtype, dtype, npart, rowb, val, x, ldx, y, 
+         ldy, NULL, z, ldz);
+   ReleasePartition(pl.part);
+   return status;
+#endif
+}
+
+int fusedMM_csr_i8
+(
+   const int32_t imessage,    // message to dictate the operations
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix
+   const VALUETYPE *val,      // value of non-zeros
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const int8_t *y,           // Dense Y matrix, quantized
+   const INDEXTYPE ldy,       // leading dimension of Y
+   const VALUETYPE *yq,       // scale and zero-point of each row of Y
+   const VALUETYPE beta,      // beta value
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z
+)
+{
+#ifdef DREAL
+   return FUSEDMM_NO_OPT_IMPL;
+#else
+   int status;
+   fusedMM_plan_t pl;
+   INDEXTYPE npart;
+   const INDEXTYPE *rowb;
+
+/* softmax of the edges of a row is only supported by fusedMM_csr */
+   if (GET_SOP_FLAG(imessage) == SOP_SOFTMAX)
+      return FUSEDMM_SOP_FAIL_RETURN;
+   status = InitPlan(&pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb,
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+#if defined(PTTIME) && defined(LOAD_BALANCE)
+   pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
+#endif
+   npart = pl.part ? pl.part->nthreads : pl.nthreads;
+   rowb = pl.part ? pl.part->rowb : NULL;
+#ifdef ENABLE_OPT_FUSEDMM
+   if (pl.tkern)
+   {
+      kern_sgfusedMM_i8_t kern = sgfusedMM_i8_getkern(pl.tkern, k, alpha, 
+            beta);
+      if (kern)
+      {
+         kern(pl.tkern, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb,
+              pntre, x, ldx, y, ldy, yq, beta, z, ldz, npart, rowb);
+         ReleasePartition(pl.part);
+         return FUSEDMM_SUCCESS_RETURN;
+      }
+      if (SetStageFuncs(&pl, imessage) != FUSEDMM_SUCCESS_RETURN)
+      {
+         ReleasePartition(pl.part);
+         return FUSEDMM_FAIL_RETURN;
+      }
+   }
+#endif
+   status = GenFusedMMCvt(&pl, 0, FUSEDMM_INT8, npart, rowb, val, x, ldx, y, 
+         ldy, yq, z, ldz);
+   ReleasePartition(pl.part);
+   return status;
+#endif
+}
+
+/*=============================================================================
+ * Multi-head fusedMM, see fusedMM_csr_mh in fusedMM.h 
+ *    optimized kernels keep all heads of a row in registers, otherwise the 
+ *    message is computed head by head when it has an optimized kernel, the 
+ *    general fusedMM applies the stages to each head of an edge  
+ *============================================================================*/
+/*
+ * General multi-head fusedMM: head h of an edge is elements h*dh to 
+ * (h+1)*dh-1 of Xi and Yj (dh = k/nhead), each head has its own scalar 
+ */
+static int GenFusedMMMh(const fusedMM_plan_t *plan, const INDEXTYPE nhead,
+      const INDEXTYPE npart, const INDEXTYPE *rowb, const VALUETYPE *val, 
+      const VALUETYPE *x, const INDEXTYPE ldx, const VALUETYPE *y, 
+      const INDEXTYPE ldy, VALUETYPE *z, const INDEXTYPE ldz)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const INDEXTYPE dh = k / nhead; 
+   const INDEXTYPE *pntrb = plan->pntrb;
+   const INDEXTYPE *pntre = plan->pntre;
+   const INDEXTYPE np = rowb ? npart : plan->m;
+
+#ifdef PTTIME
+   #pragma omp parallel num_threads(plan->nthreads) reduction(+:status)
+#endif
+   {
+      // ASSUMPTION: feature dimension k is small enough to fit in stack
+      VALUETYPE T[k];
+   #ifdef PTTIME
+      #ifdef DYNAMIC
+         #pragma omp for schedule(dynamic)
+      #else
+         #pragma omp for schedule(static)
+      #endif
+   #endif
+      for (INDEXTYPE t = 0; t < np; t++)
+      {
+         const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1;
+
+         for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+         {
+            const VALUETYPE *Xi = x + i * ldx;
+            VALUETYPE *O = z + i * ldz;
+
+            for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+            {
+               const VALUETYPE *Yj = y + plan->indx[j] * ldy;
+
+               for (INDEXTYPE h = 0; h < k; h += dh)
+               {
+                  VALUETYPE scal = val[j], out;
+
+                  status += plan->VOP_FUNC(dh, Xi+h, dh, Yj+h, dh, T+h);
+                  status += plan->ROP_FUNC(dh, Xi+h, dh, T+h, &scal);
+                  status += plan->SOP_FUNC(scal, &out);
+                  status += plan->VSC_FUNC(dh, T+h, out, dh, T+h);
+                  status += plan->AOP_FUNC(dh, T+h, dh, O+h);
+               }
+            }
+         }
+      }
+   }
+   return status;
+}
+
+int fusedMM_csr_mh
+(
+   const int32_t imessage,    // message to dictate the operations
+   const INDEXTYPE nhead,     // number of heads, divides k
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix
+   const VALUETYPE *val,      // value of non-zeros
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y
+   const VALUETYPE beta,      // beta value
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z
+)
+{
+   int status;
+   fusedMM_plan_t pl;
+   INDEXTYPE npart;
+   const INDEXTYPE *rowb;
+
+   if (nhead < 1 || k % nhead)
+      return FUSEDMM_FAIL_RETURN;
+/* softmax of the edges of a row is only supported by fusedMM_csr */
+   if (GET_SOP_FLAG(imessage) == SOP_SOFTMAX)
+      return FUSEDMM_SOP_FAIL_RETURN;
+/*
+ * without ROP every head gets the same scalar: same as a single head 
+ */
+   if (nhead == 1 || GET_ROP_FLAG(imessage) == ROP_NOOP)
+      return fusedMM_csr(imessage, m, n, k, alpha, nnz, rows, cols, val, 
+            indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);
+   status = InitPlan(&pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb,
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+#if defined(PTTIME) && defined(LOAD_BALANCE)
+   pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
+#endif
+   npart = pl.part ? pl.part->nthreads : pl.nthreads;
+   rowb = pl.part ? pl.part->rowb : NULL;
+#ifdef ENABLE_OPT_FUSEDMM
+   if (pl.tkern)
+   {
+   #ifdef DREAL
+      kern_dgfusedMM_mh_t kern = dgfusedMM_mh_getkern(pl.tkern, k, nhead, 
+            alpha, beta);
+   #else
+      kern_sgfusedMM_mh_t kern = sgfusedMM_mh_getkern(pl.tkern, k, nhead, 
+            alpha, beta);
+   #endif
+      if (kern)
+      {
+         kern(pl.tkern, m, n, k, nhead, alpha, nnz, rows, cols, val, indx, 
+              pntrb, pntre, x, ldx, y, ldy, beta, z, ldz, npart, rowb);
+         ReleasePartition(pl.part);
+         return FUSEDMM_SUCCESS_RETURN;
+      }
+/*
+ *    no register blocked kernel for k and nhead: optimized kernel of the 
+ *    message on each head, a head is a sub-view of k/nhead columns 
+ */
+      ReleasePartition(pl.part);
+      status = FUSEDMM_SUCCESS_RETURN; 
+      for (INDEXTYPE h = 0; h < k && status == FUSEDMM_SUCCESS_RETURN; 
+            h += k / nhead)
+         status = fusedMM_csr(imessage, m, n, k / nhead, alpha, nnz, rows, 
+               cols, val, indx, pntrb, pntre, x + h, ldx, y + h, ldy, beta, 
+               z + h, ldz);
+      return status;
+   }
+#endif
+   status = GenFusedMMMh(&pl, nhead, npart, rowb, val, x, ldx, y, ldy, z, 
+         ldz);
+   ReleasePartition(pl.part);
+   return status;
+}
+
+/*=============================================================================
+ * fusedMM with per-edge output, see fusedMM_csr_edge in fusedMM.h 
+ *    optimized kernels store the scalars of a block of edges after its SOP, 
+ *    z = NULL selects the SDDMM kernels which stop there  
+ *============================================================================*/
+/*
+ * General fusedMM with per-edge output: same as GenFusedMM, out is the scalar
+ * of ROP (or val) when SOP is NOOP. z = NULL: VSC and AOP are skipped 
+ */
+static int GenFusedMMEdge(const fusedMM_plan_t *plan, const INDEXTYPE npart,
+      const INDEXTYPE *rowb, const VALUETYPE *val, const VALUETYPE *x, 
+      const INDEXTYPE ldx, const VALUETYPE *y, const INDEXTYPE ldy, 
+      VALUETYPE *z, const INDEXTYPE ldz, VALUETYPE *eout)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const INDEXTYPE *pntrb = plan->pntrb;
+   const INDEXTYPE *pntre = plan->pntre;
+   const INDEXTYPE np = rowb ? npart : plan->m;
+
+#ifdef PTTIME
+   #pragma omp parallel num_threads(plan->nthreads) reduction(+:status)
+#endif
+   {
+      // ASSUMPTION: feature dimension k is small enough to fit in stack
+      VALUETYPE T[k];
+   #ifdef PTTIME
+      #ifdef DYNAMIC
+         #pragma omp for schedule(dynamic)
+      #else
+         #pragma omp for schedule(static)
+      #endif
+   #endif
+      for (INDEXTYPE t = 0; t < np; t++)
+      {
+         const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1;
+
+         for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+         {
+            const VALUETYPE *Xi = x + i * ldx;
+
+            for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+            {
+               const VALUETYPE *Yj = y + plan->indx[j] * ldy;
+               VALUETYPE scal = val[j], out;
+
+               status += plan->VOP_FUNC(k, Xi, k, Yj, k, T);
+               status += plan->ROP_FUNC(k, Xi, k, T, &scal);
+               out = scal; 
+               status += plan->SOP_FUNC(scal, &out);
+               eout[j] = out; 
+               if (z)
+               {
+                  status += plan->VSC_FUNC(k, T, out, k, T);
+                  status += plan->AOP_FUNC(k, T, k, z + i * ldz);
+               }
+            }
+         }
+      }
+   }
+   return status;
+}
+
+int fusedMM_csr_edge
+(
+   const int32_t imessage,    // message to dictate the operations
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix
+   const VALUETYPE *val,      // value of non-zeros
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y
+   const VALUETYPE beta,      // beta value
+   VALUETYPE *z,              // Dense matrix Z, NULL: SDDMM-only
+   const INDEXTYPE ldz,       // leading dimension size of z
+   VALUETYPE *edge_out        // OUT: scalar of nonzero j at edge_out[j]
+)
+{
+   int status;
+   fusedMM_plan_t pl;
+   INDEXTYPE npart;
+   const INDEXTYPE *rowb;
+
+   if (!edge_out)
+      return FUSEDMM_FAIL_RETURN;
+/* softmax of the edges of a row is only supported by fusedMM_csr */
+   if (GET_SOP_FLAG(imessage) == SOP_SOFTMAX)
+      return FUSEDMM_SOP_FAIL_RETURN;
+   status = InitPlan(&pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb,
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+#ifdef ENABLE_OPT_FUSEDMM
+/*
+ * spmm and gcn scale the rows of Y by val: the optimized kernel updates Z and
+ * the scalars are the values of the nonzeros 
+ */
+   if (pl.tkern == 'm' || pl.tkern == 'g')
+   {
+      if (z)
+         status = fusedMM_csr(imessage, m, n, k, alpha, nnz, rows, cols, val,
+               indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);
+      if (val)
+         memcpy(edge_out, val, nnz * sizeof(VALUETYPE));
+      else /* pattern only: each nonzero scales its row of Y by 1 */
+      {
+      #ifdef PTTIME
+         #pragma omp parallel for num_threads(pl.nthreads) schedule(static)
+      #endif
+         for (INDEXTYPE j = 0; j < nnz; j++)
+            edge_out[j] = 1.0;
+      }
+      return status;
+   }
+#endif
+#if defined(PTTIME) && defined(LOAD_BALANCE)
+   pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
+#endif
+   npart = pl.part ? pl.part->nthreads : pl.nthreads;
+   rowb = pl.part ? pl.part->rowb : NULL;
+#ifdef ENABLE_OPT_FUSEDMM
+   if (pl.tkern)
+   {
+   #ifdef DREAL
+      kern_dgfusedMM_edge_t kern = dgfusedMM_edge_getkern(pl.tkern, k, alpha,
+            beta, !z);
+   #else
+      kern_sgfusedMM_edge_t kern = sgfusedMM_edge_getkern(pl.tkern, k, alpha,
+            beta, !z);
+   #endif
+      if (kern)
+      {
+         kern(pl.tkern, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
+              pntre, x, ldx, y, ldy, beta, z, ldz, edge_out, npart, rowb);
+         ReleasePartition(pl.part);
+         return FUSEDMM_SUCCESS_RETURN;
+      }
+/*
+ *    no kernel with per-edge output for k: optimized kernel of the message 
+ *    updates Z, scalars are computed by the general fusedMM in another pass 
+ */
+      if (SetStageFuncs(&pl, imessage) != FUSEDMM_SUCCESS_RETURN)
+      {
+         ReleasePartition(pl.part);
+         return FUSEDMM_FAIL_RETURN;
+      }
+      if (z)
+      {
+         status = fusedMM_csr(imessage, m, n, k, alpha, nnz, rows, cols, val,
+               indx, pntrb, pntre, x, ldx, y, ldy, beta, z, ldz);
+         if (status != FUSEDMM_SUCCESS_RETURN)
+         {
+            ReleasePartition(pl.part);
+            return status;
+         }
+      }
+      status = GenFusedMMEdge(&pl, npart, rowb, val, x, ldx, y, ldy, NULL, 
+            ldz, edge_out);
+      ReleasePartition(pl.part);
+      return status;
+   }
+#endif
+   status = GenFusedMMEdge(&pl, npart, rowb, val, x, ldx, y, ldy, z, ldz, 
+         edge_out);
+   ReleasePartition(pl.part);
+   return status;
+}
+
+/*=============================================================================
+ * Degree normalization, see fusedMM_csr_norm in fusedMM.h 
+ *    gcn kernels scale the rows of Y by cs and the rows of Z by rs in 
+ *    registers, val is never read. Without such a kernel for k, spmm and gcn
+ *    messages run the spmm kernel on the values scaled by rs and cs 
+ *============================================================================*/
+int fusedMM_degree_scale(const int norm, const INDEXTYPE m, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, VALUETYPE *s)
+{
+   if (norm != FUSEDMM_NORM_SYM && norm != FUSEDMM_NORM_MEAN)
+      return FUSEDMM_FAIL_RETURN;
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      const INDEXTYPE deg = pntre[i] - pntrb[i];
+
+      if (!deg)
+         s[i] = 0.0; /* row without nonzeros is never aggregated */
+      else if (norm == FUSEDMM_NORM_SYM)
+         s[i] = 1.0 / sqrt((VALUETYPE) deg);
+      else
+         s[i] = 1.0 / deg;
+   }
+   return FUSEDMM_SUCCESS_RETURN;
+}
+/*
+ * General fusedMM with degree normalization: same as GenFusedMM, the vector 
+ * after VSC is scaled by rs[i] * cs[j] 
+ */
+static int GenFusedMMNorm(const fusedMM_plan_t *plan, const INDEXTYPE npart,
+      const INDEXTYPE *rowb, const VALUETYPE *val, const VALUETYPE *x, 
+      const INDEXTYPE ldx, const VALUETYPE *y, const INDEXTYPE ldy, 
+      VALUETYPE *z, const INDEXTYPE ldz, const VALUETYPE *rs, 
+      const VALUETYPE *cs)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const INDEXTYPE *pntrb = plan->pntrb;
+   const INDEXTYPE *pntre = plan->pntre;
+   const INDEXTYPE np = rowb ? npart : plan->m;
+   const FP_VSC_FUNC SCAL_FUNC = GetVSCFunc(VSC_MUL);
+
+#ifdef PTTIME
+   #pragma omp parallel num_threads(plan->nthreads) reduction(+:status)
+#endif
+   {
+      // ASSUMPTION: feature dimension k is small enough to fit in stack
+      VALUETYPE T[k];
+   #ifdef PTTIME
+      #ifdef DYNAMIC
+         #pragma omp for schedule(dynamic)
+      #else
+         #pragma omp for schedule(static)
+      #endif
+   #endif
+      for (INDEXTYPE t = 0; t < np; t++)
+      {
+         const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1;
+
+         for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+         {
+            const VALUETYPE *Xi = x + i * ldx;
+            const VALUETYPE ri = rs ? rs[i] : 1.0;
+
+            for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+            {
+               const INDEXTYPE cj = plan->indx[j];
+               const VALUETYPE *Yj = y + cj * ldy;
+               VALUETYPE scal = val ? val[j] : 1.0, out;
+
+               status += plan->VOP_FUNC(k, Xi, k, Yj, k, T);
+               status += plan->ROP_FUNC(k, Xi, k, T, &scal);
+               out = scal; 
+               status += plan->SOP_FUNC(scal, &out);
+               status += plan->VSC_FUNC(k, T, out, k, T);
+               status += SCAL_FUNC(k, T, cs ? ri * cs[cj] : ri, k, T);
+               status += plan->AOP_FUNC(k, T, k, z + i * ldz);
+            }
+         }
+      }
+   }
+   return status;
+}
+
+int fusedMM_csr_norm
+(
+   const int32_t imessage,    // message to dictate the operations
+   const int norm,            // FUSEDMM_NORM_SCALE, _SYM or _MEAN
+   const VALUETYPE *rs,       // scale of row i, NULL: see norm
+   const VALUETYPE *cs,       // scale of column j, NULL: see norm
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix
+   const VALUETYPE *val,      // value of non-zeros
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y
+   const VALUETYPE beta,      // beta value
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z
+)
+{
+   int status;
+   fusedMM_plan_t pl;
+   INDEXTYPE npart;
+   const INDEXTYPE *rowb;
+   VALUETYPE *ds = NULL;      // scales computed from degrees 
+
+   if (norm != FUSEDMM_NORM_SCALE && norm != FUSEDMM_NORM_SYM 
+         && norm != FUSEDMM_NORM_MEAN)
+      return FUSEDMM_FAIL_RETURN;
+/* column j is scaled by the degree of row j */
+   if (norm == FUSEDMM_NORM_SYM && !cs && cols > m)
+      return FUSEDMM_FAIL_RETURN;
+/* softmax of the edges of a row is only supported by fusedMM_csr */
+   if (GET_SOP_FLAG(imessage) == SOP_SOFTMAX)
+      return FUSEDMM_SOP_FAIL_RETURN;
+   status = InitPlan(&pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb,
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+   if (norm != FUSEDMM_NORM_SCALE && (!rs || (norm == FUSEDMM_NORM_SYM 
+         && !cs)))
+   {
+      ds = malloc(m * sizeof(VALUETYPE));
+      if (!ds)
+         return FUSEDMM_NOT_ENOUGH_MEM;
+      fusedMM_degree_scale(norm, m, pntrb, pntre, ds);
+      if (!rs)
+         rs = ds;
+      if (norm == FUSEDMM_NORM_SYM && !cs)
+         cs = ds;
+   }
+#ifdef ENABLE_OPT_FUSEDMM
+   if (pl.tkern == 'g' || pl.tkern == 'm')
+   {
+      VALUETYPE *sval;
+   #ifdef DREAL
+      kern_dgfusedMM_norm_t kern = dgfusedMM_norm_getkern(pl.tkern, k, alpha,
+            beta);
+   #else
+      kern_sgfusedMM_norm_t kern = sgfusedMM_norm_getkern(pl.tkern, k, alpha,
+            beta);
+   #endif
+      if (kern)
+      {
+      #if defined(PTTIME) && defined(LOAD_BALANCE)
+         pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
+      #endif
+         npart = pl.part ? pl.part->nthreads : pl.nthreads;
+         rowb = pl.part ? pl.part->rowb : NULL;
+         kern(pl.tkern, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
+              pntre, x, ldx, y, ldy, beta, z, ldz, rs, cs, npart, rowb);
+         ReleasePartition(pl.part);
+         free(ds);
+         return FUSEDMM_SUCCESS_RETURN;
+      }
+/*
+ *    no normalized kernel for k (or spmm): spmm kernel on the scaled values 
+ */
+      sval = malloc(nnz * sizeof(VALUETYPE));
+      if (!sval)
+      {
+         free(ds);
+         return FUSEDMM_NOT_ENOUGH_MEM;
+      }
+   #ifdef PTTIME
+      #pragma omp parallel for num_threads(pl.nthreads) schedule(static)
+   #endif
+      for (INDEXTYPE i = 0; i < m; i++)
+      {
+         const VALUETYPE ri = rs ? rs[i] : 1.0;
+
+         for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+            sval[j] = (pl.tkern == 'm' ? val[j] : 1.0) * ri 
+                      * (cs ? cs[indx[j]] : 1.0);
+      }
+      status = fusedMM_csr(VOP_COPY_RHS | ROP_NOOP | SOP_COPY | VSC_MUL 
+            | AOP_ADD, m, n, k, alpha, nnz, rows, cols, sval, indx, pntrb, 
+            pntre, x, ldx, y, ldy, beta, z, ldz);
+      free(sval);
+      free(ds);
+      return status;
+   }
+   if (pl.tkern && SetStageFuncs(&pl, imessage) != FUSEDMM_SUCCESS_RETURN)
+   {
+      free(ds);
+      return FUSEDMM_FAIL_RETURN;
+   }
+#endif
+#if defined(PTTIME) && defined(LOAD_BALANCE)
+   pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
+#endif
+   npart = pl.part ? pl.part->nthreads : pl.nthreads;
+   rowb = pl.part ? pl.part->rowb : NULL;
+   status = GenFusedMMNorm(&pl, npart, rowb, val, x, ldx, y, ldy, z, ldz, rs,
+         cs);
+   ReleasePartition(pl.part);
+   free(ds);
+   return status;
+}
+
+/*=============================================================================
+ * Max and min aggregation with arg output, see fusedMM_csr_arg in fusedMM.h 
+ *    rows are not split: arg of a heavy row would need the arg of each chunk
+ *============================================================================*/
+/*
+ * General fusedMM with AOP_MAX or AOP_MIN: same as GenFusedMM, each element of
+ * the vector after VSC replaces the one of Z when it is strictly greater 
+ * (less), arg gets the nonzero then 
+ */
+static int GenFusedMMArg(const fusedMM_plan_t *plan, const INDEXTYPE npart,
+      const INDEXTYPE *rowb, const VALUETYPE *val, const VALUETYPE *x, 
+      const INDEXTYPE ldx, const VALUETYPE *y, const INDEXTYPE ldy, 
+      VALUETYPE *z, const INDEXTYPE ldz, INDEXTYPE *arg)
+{
+   int status = 0;
+   const INDEXTYPE k = plan->k;
+   const INDEXTYPE *pntrb = plan->pntrb;
+   const INDEXTYPE *pntre = plan->pntre;
+   const INDEXTYPE np = rowb ? npart : plan->m;
+   const int amin = (GET_AOP_FLAG(plan->imessage) == AOP_MIN);
+
+#ifdef PTTIME
+   #pragma omp parallel num_threads(plan->nthreads) reduction(+:status)
+#endif
+   {
+      // ASSUMPTION: feature dimension k is small enough to fit in stack
+      VALUETYPE T[k];
+   #ifdef PTTIME
+      #ifdef DYNAMIC
+         #pragma omp for schedule(dynamic)
+      #else
+         #pragma omp for schedule(static)
+      #endif
+   #endif
+      for (INDEXTYPE t = 0; t < np; t++)
+      {
+         const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1;
+
+         for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+         {
+            const VALUETYPE *Xi = x + i * ldx;
+            VALUETYPE *Zi = z + i * ldz;
+            INDEXTYPE *Ai = arg + i * ldz;
+
+            for (INDEXTYPE kk = 0; kk < k; kk++)
+               Ai[kk] = -1;
+            for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+            {
+               const VALUETYPE *Yj = y + plan->indx[j] * ldy;
+               VALUETYPE scal = val[j], out;
+
+               status += plan->VOP_FUNC(k, Xi, k, Yj, k, T);
+               status += plan->ROP_FUNC(k, Xi, k, T, &scal);
+               out = scal; 
+               status += plan->SOP_FUNC(scal, &out);
+               status += plan->VSC_FUNC(k, T, out, k, T);
+               for (INDEXTYPE kk = 0; kk < k; kk++)
+               {
+                  if (amin ? T[kk] < Zi[kk] : T[kk] > Zi[kk])
+                  {
+                     Zi[kk] = T[kk];
+                     Ai[kk] = j;
+                  }
+               }
+            }
+         }
+      }
+   }
+   return status;
+}
+
+int fusedMM_csr_arg
+(
+   const int32_t imessage,    // message to dictate the operations
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix
+   const VALUETYPE *val,      // value of non-zeros
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y
+   const VALUETYPE beta,      // beta value
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz,       // leading dimension size of z and arg
+   INDEXTYPE *arg             // OUT: nonzero which gave z[i*ldz+kk]
+)
+{
+   int status;
+   fusedMM_plan_t pl;
+   INDEXTYPE npart;
+   const INDEXTYPE *rowb;
+
+   if (!arg)
+      return FUSEDMM_FAIL_RETURN;
+   if (GET_AOP_FLAG(imessage) != AOP_MAX && GET_AOP_FLAG(imessage) != AOP_MIN)
+      return FUSEDMM_AOP_FAIL_RETURN;
+   status = InitPlan(&pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb,
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+#if defined(PTTIME) && defined(LOAD_BALANCE)
+   pl.part = AcquirePartition(m, pntrb, pntre, pl.nthreads);
+#endif
+   npart = pl.part ? pl.part->nthreads : pl.nthreads;
+   rowb = pl.part ? pl.part->rowb : NULL;
+#ifdef ENABLE_OPT_FUSEDMM
+   if (pl.tkern)
+   {
+      INDEXTYPE maxdeg = 0;
+   #ifdef DREAL
+      kern_dgfusedMM_arg_t kern;
+   #else
+      kern_sgfusedMM_arg_t kern;
+   #endif
+      if (pl.part) /* computed once with the cached partition */
+         maxdeg = pl.part->maxdeg;
+      else
+      {
+      #ifdef PTTIME
+         #pragma omp parallel for num_threads(pl.nthreads) schedule(static) \
+            reduction(max:maxdeg)
+      #endif
+         for (INDEXTYPE i = 0; i < m; i++)
+            if (pntre[i] - pntrb[i] > maxdeg)
+               maxdeg = pntre[i] - pntrb[i];
+      }
+   #ifdef DREAL
+      kern = dgfusedMM_arg_getkern(pl.tkern, k, alpha, beta, maxdeg);
+   #else
+      kern = sgfusedMM_arg_getkern(pl.tkern, k, alpha, beta, maxdeg);
+   #endif
+      kern(pl.tkern, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
+           pntre, x, ldx, y, ldy, beta, z, ldz, arg, npart, rowb);
+      ReleasePartition(pl.part);
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+#endif
+   status = GenFusedMMArg(&pl, npart, rowb, val, x, ldx, y, ldy, z, ldz, arg);
+   ReleasePartition(pl.part);
+   return status;
+}
+
+/*=============================================================================
+ * SELL-C-sigma storage, see fusedMM_csr2sell in fusedMM.h
+ *    rows of a window are sorted by nonzeros, so the first row of a chunk is
+ *    the longest. A padded nonzero reuses the colid of the first row at the
+ *    same step: the row of Y is already being loaded for that row
+ *============================================================================*/
+#if FUSEDMM_SELL_C != SELL_C
+   #error "FUSEDMM_SELL_C of fusedMM.h doesn't match with SELL_C of kernels.h"
+#endif
+typedef struct sell_row
+{
+   INDEXTYPE len, row;
+} sell_row_t;
+/*
+ * nonzeros in descending order, row in ascending order for ties to keep the
+ * conversion deterministic
+ */
+static int SellRowCmp(const void *p0, const void *p1)
+{
+   const sell_row_t *r0 = (const sell_row_t*) p0;
+   const sell_row_t *r1 = (const sell_row_t*) p1;
+   if (r0->len != r1->len)
+      return (r0->len > r1->len) ? -1 : 1;
+   return (r0->row < r1->row) ? -1 : (r0->row > r1->row);
+}
+
+void fusedMM_sell_destroy(fusedMM_sell_t *sell)
+{
+   if (!sell)
+      return;
+   free(sell->cptr);
+   free(sell->rlen);
+   free(sell->perm);
+   free(sell->indx);
+   free(sell->val);
+   free(sell->vmap);
+   free(sell);
+}
+
+void fusedMM_sell_set_values(fusedMM_sell_t *sell, const VALUETYPE *val)
+{
+   const INDEXTYPE ne = sell->cptr[sell->nchunk];
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(fusedMM_get_num_threads()) \
+      schedule(static)
+#endif
+   for (INDEXTYPE e = 0; e < ne; e++)
+      sell->val[e] = (sell->vmap[e] >= 0) ? val[sell->vmap[e]] : 0.0;
+}
+
+int fusedMM_csr2sell
+(
+   fusedMM_sell_t **sell,     // OUT: created SELL-C-sigma matrix
+   const INDEXTYPE sigma,     // sorting window
+   const INDEXTYPE m,         // number of rows in sparse matrix
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *val       // value of non-zeros, can be NULL
+)
+{
+   const INDEXTYPE C = FUSEDMM_SELL_C;
+   const INDEXTYPE nchunk = (m + C - 1) / C;
+   INDEXTYPE sg, ne;
+   sell_row_t *rw;
+   fusedMM_sell_t *sl;
+
+   *sell = NULL;
+   sg = (sigma <= 0 || sigma > nchunk * C) ? nchunk * C : sigma;
+   sg = ((sg + C - 1) / C) * C; /* windows hold whole chunks */
+   sl = (fusedMM_sell_t*) calloc(1, sizeof(fusedMM_sell_t));
+   rw = (sell_row_t*) malloc((m+1)*sizeof(sell_row_t));
+   if (!sl || !rw)
+   {
+      free(sl);
+      free(rw);
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   }
+   sl->m = m;
+   sl->sigma = sg;
+   sl->nchunk = nchunk;
+   sl->cptr = (INDEXTYPE*) malloc((nchunk+1)*sizeof(INDEXTYPE));
+   sl->rlen = (INDEXTYPE*) malloc((nchunk*C+1)*sizeof(INDEXTYPE));
+   sl->perm = (INDEXTYPE*) malloc((nchunk*C+1)*sizeof(INDEXTYPE));
+   if (!sl->cptr || !sl->rlen || !sl->perm)
+   {
+      free(rw);
+      fusedMM_sell_destroy(sl);
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   }
+/*
+ * sort the rows of each window, rows of the last chunk beyond m are padding
+ */
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      rw[i].len = pntre[i] - pntrb[i];
+      rw[i].row = i;
+   }
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(fusedMM_get_num_threads()) \
+      schedule(dynamic)
+#endif
+   for (INDEXTYPE wb = 0; wb < m; wb += sg)
+      qsort(rw + wb, ((wb + sg < m) ? sg : m - wb), sizeof(sell_row_t),
+            SellRowCmp);
+   for (INDEXTYPE r = 0; r < nchunk * C; r++)
+   {
+      sl->rlen[r] = (r < m) ? rw[r].len : 0;
+      sl->perm[r] = (r < m) ? rw[r].row : -1;
+   }
+   free(rw);
+   sl->cptr[0] = 0;
+   for (INDEXTYPE c = 0; c < nchunk; c++)
+      sl->cptr[c+1] = sl->cptr[c] + sl->rlen[c*C] * C;
+   ne = sl->cptr[nchunk];
+   sl->indx = (COLINDEXTYPE*) malloc((ne+1)*sizeof(COLINDEXTYPE));
+   sl->val = (VALUETYPE*) malloc((ne+1)*sizeof(VALUETYPE));
+   sl->vmap = (INDEXTYPE*) malloc((ne+1)*sizeof(INDEXTYPE));
+   if (!sl->indx || !sl->val || !sl->vmap)
+   {
+      fusedMM_sell_destroy(sl);
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   }
+/*
+ * column-major chunks: nonzero j of row r at cptr[c] + j*C + r
+ */
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(fusedMM_get_num_threads()) \
+      schedule(static)
+#endif
+   for (INDEXTYPE c = 0; c < nchunk; c++)
+   {
+      const INDEXTYPE w = sl->rlen[c*C];
+      for (INDEXTYPE j = 0; j < w; j++)
+      {
+         const INDEXTYPE e0 = sl->cptr[c] + j * C;
+         for (INDEXTYPE r = 0; r < C; r++)
+         {
+            const INDEXTYPE e = e0 + r;
+            if (j < sl->rlen[c*C+r])
+            {
+               const INDEXTYPE p = pntrb[sl->perm[c*C+r]] + j;
+               sl->indx[e] = indx[p];
+               sl->vmap[e] = p;
+               sl->val[e] = val ? val[p] : 0.0;
+            }
+            else
+            {
+               sl->indx[e] = sl->indx[e0];
+               sl->vmap[e] = -1;
+               sl->val[e] = 0.0;
+            }
+         }
+      }
+   }
+   *sell = sl;
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+int fusedMM_sell
+(
+   const int32_t imessage,    // message to dictate the operations
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE alpha,     // alpha value
+   const fusedMM_sell_t *sell,// sparse matrix from fusedMM_csr2sell
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y
+   const VALUETYPE beta,      // beta value
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z
+)
+{
+#ifdef ENABLE_OPT_FUSEDMM
+   const char tkern = GetOptKern(imessage);
+   const INDEXTYPE nthreads = fusedMM_get_num_threads();
+   INDEXTYPE *rowb = NULL;
+   FP_OPT_SELLKERN_FUNC kern;
+
+   if (tkern != 'm' && tkern != 'g')
+      return FUSEDMM_NO_OPT_IMPL;
+   if (m != sell->m)
+      return FUSEDMM_FAIL_RETURN;
+   #ifdef DREAL
+      kern = dgfusedMM_sell_getkern(tkern, k, alpha, beta);
+   #else
+      kern = sgfusedMM_sell_getkern(tkern, k, alpha, beta);
+   #endif
+   if (!kern) /* k is wider than the lock-step kernels */
+      return FUSEDMM_NO_OPT_IMPL;
+   #if defined(PTTIME) && defined(LOAD_BALANCE)
+/*
+ * partition chunks among threads, cptr is the prefix sum of their nonzeros
+ */
+   rowb = (INDEXTYPE*) malloc((nthreads+1)*sizeof(INDEXTYPE));
+   if (rowb)
+      GetRowPartition(sell->nchunk, sell->cptr, sell->cptr+1, nthreads,
+            FUSEDMM_SELL_C*PART_ROW_COST, rowb);
+   #endif
+   kern(tkern, sell->m, n, k, alpha, sell->cptr[sell->nchunk], sell->m, n,
+        sell->val, sell->indx, sell->cptr, sell->rlen, sell->perm, x, ldx, y,
+        ldy, beta, z, ldz, nthreads, rowb);
+   free(rowb);
+   return FUSEDMM_SUCCESS_RETURN;
+#else
+   return FUSEDMM_NO_OPT_IMPL;
+#endif
+}
+
+/*
+ * CSC of the sparse matrix of plan: plan works on the CSR of the transpose,
+ * values are reordered by tmap in each execute 
+ */
+static int TransposePlan(fusedMM_plan_t *pl)
+{
+   const INDEXTYPE nnz = pl->nnz; 
+   const INDEXTYPE rows = pl->rows; 
+
+   pl->tindx = (COLINDEXTYPE*) malloc(nnz*sizeof(COLINDEXTYPE)+1);
+   pl->tptr = (INDEXTYPE*) malloc((pl->cols+1)*sizeof(INDEXTYPE));
+   pl->tmap = (INDEXTYPE*) malloc(nnz*sizeof(INDEXTYPE)+1);
+   pl->tval = (VALUETYPE*) malloc(nnz*sizeof(VALUETYPE)+1);
+   if (!pl->tindx || !pl->tptr || !pl->tmap || !pl->tval)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   if (fusedMM_csr2csc(rows, pl->cols, pl->indx, pl->pntrb, pl->pntre, NULL,
+            pl->tindx, pl->tptr, NULL, pl->tmap) != FUSEDMM_SUCCESS_RETURN)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   pl->rows = pl->cols; 
+   pl->cols = rows; 
+   pl->indx = pl->tindx; 
+   pl->pntrb = pl->tptr; 
+   pl->pntre = pl->tptr + 1; 
+   return FUSEDMM_SUCCESS_RETURN;
+}
+/*
+ * permute the sparse matrix of plan and allocate space for the permuted 
+ * operands (only values when the caller gives them permuted), see 
+ * fusedMM_plan_execute 
+ */
+static int ReorderPlan(fusedMM_plan_t *pl, const int method, 
+      const int permuted)
+{
+   int status;
+   const INDEXTYPE m = pl->m; 
+   const INDEXTYPE nnz = pl->nnz; 
+
+   pl->perm = (INDEXTYPE*) malloc(m*sizeof(INDEXTYPE));
+   pl->pmap = (INDEXTYPE*) malloc(nnz*sizeof(INDEXTYPE)+1);
+   pl->pindx = (COLINDEXTYPE*) malloc(nnz*sizeof(COLINDEXTYPE)+1);
+   pl->prowptr = (INDEXTYPE*) malloc((m+1)*sizeof(INDEXTYPE));
+   pl->permuted = permuted; 
+   pl->pbuf = (VALUETYPE*) malloc((nnz+(permuted ? 0 : 3*m*pl->k))
+                                  *sizeof(VALUETYPE)+1);
+   if (!pl->perm || !pl->pmap || !pl->pindx || !pl->prowptr || !pl->pbuf)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   status = fusedMM_reorder_csr(method, m, pl->indx, pl->pntrb, pl->pntre, 
+         pl->perm);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+   status = fusedMM_permute_csr(m, pl->perm, pl->indx, pl->pntrb, pl->pntre, 
+         NULL, pl->pindx, pl->prowptr, NULL, pl->pmap);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+   pl->indx = pl->pindx; 
+   pl->pntrb = pl->prowptr; 
+   pl->pntre = pl->prowptr + 1; 
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+/*
+ * bytes to store v in the compressed column indices, at least 1 
+ */
+static int VbidxBytes(uint64_t v)
+{
+   int nb = 1; 
+   for (v >>= 8; v; v >>= 8)
+      nb++; 
+   return nb; 
+}
+/*
+ * stores nb least significant bytes of v at p, little endian. returns p+nb
+ */
+static uint8_t *VbidxPut(uint8_t *p, uint64_t v, const int nb)
+{
+   for (int b = 0; b < nb; b++, v >>= 8)
+      *p++ = (uint8_t) (v & 0xFF); 
+   return p; 
+}
+/*
+ * compress the column indices of plan for the spmm and gcn kernels, see 
+ * VBIDX_NEXT in kernels/include/kernels.h. Plan is left unchanged when the 
+ * column indices of a row are not sorted 
+ */
+static int CompressPlan(fusedMM_plan_t *pl)
+{
+   const INDEXTYPE m = pl->m; 
+   const COLINDEXTYPE *indx = pl->indx; 
+   const INDEXTYPE *pntrb = pl->pntrb; 
+   const INDEXTYPE *pntre = pl->pntre; 
+   int sorted = 1; 
+   INDEXTYPE *cptr; 
+   uint8_t *cidx; 
+
+   cptr = (INDEXTYPE*) malloc((m+1)*sizeof(INDEXTYPE));
+   if (!cptr)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+/*
+ * bytes of each row: header, first colid and deltas at the width of largest
+ */
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(pl->nthreads) schedule(static) \
+      reduction(&&:sorted)
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      INDEXTYPE nb = 0; 
+      if (pntre[i] > pntrb[i])
+      {
+         uint64_t dmax = 0; 
+         for (INDEXTYPE j = pntrb[i]+1; j < pntre[i]; j++)
+         {
+            if (indx[j] < indx[j-1])
+               sorted = 0; 
+            else if ((uint64_t)(indx[j] - indx[j-1]) > dmax)
+               dmax = indx[j] - indx[j-1]; 
+         }
+         nb = 1 + VbidxBytes(indx[pntrb[i]]) 
+            + (pntre[i]-pntrb[i]-1) * VbidxBytes(dmax); 
+      }
+      cptr[i+1] = nb; 
+   }
+   if (!sorted)
+   {
+      free(cptr);
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+   cptr[0] = 0; 
+   for (INDEXTYPE i = 0; i < m; i++)
+      cptr[i+1] += cptr[i];
+   cidx = (uint8_t*) malloc(cptr[m]+VBIDX_PAD);
+   if (!cidx)
+   {
+      free(cptr);
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   }
+   memset(cidx+cptr[m], 0, VBIDX_PAD); 
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(pl->nthreads) schedule(static)
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      uint8_t *p = cidx + cptr[i]; 
+      uint64_t dmax = 0; 
+      int nb0, nbd; 
+      if (pntre[i] == pntrb[i])
+         continue; 
+      for (INDEXTYPE j = pntrb[i]+1; j < pntre[i]; j++)
+         if ((uint64_t)(indx[j] - indx[j-1]) > dmax)
+            dmax = indx[j] - indx[j-1]; 
+      nb0 = VbidxBytes(indx[pntrb[i]]); 
+      nbd = VbidxBytes(dmax); 
+      *p++ = (uint8_t) (nb0 | (nbd << 4)); 
+      p = VbidxPut(p, indx[pntrb[i]], nb0); 
+      for (INDEXTYPE j = pntrb[i]+1; j < pntre[i]; j++)
+         p = VbidxPut(p, indx[j] - indx[j-1], nbd); 
+   }
+   pl->cidx = cidx; 
+   pl->cptr = cptr; 
+#ifdef DREAL 
+   pl->vbkern_b0 = dgfusedMM_vbcsr_getkern(pl->tkern, pl->k, 1.0, 0.0);
+   pl->vbkern_b1 = dgfusedMM_vbcsr_getkern(pl->tkern, pl->k, 1.0, 1.0);
+   pl->vbkern_bx = dgfusedMM_vbcsr_getkern(pl->tkern, pl->k, 0.0, 0.0);
+#else
+   pl->vbkern_b0 = sgfusedMM_vbcsr_getkern(pl->tkern, pl->k, 1.0, 0.0);
+   pl->vbkern_b1 = sgfusedMM_vbcsr_getkern(pl->tkern, pl->k, 1.0, 1.0);
+   pl->vbkern_bx = sgfusedMM_vbcsr_getkern(pl->tkern, pl->k, 0.0, 0.0);
+#endif
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+/*
+ * SELL-C-sigma of the sparse matrix of plan and partition of its chunks among
+ * threads, values are copied in each execute. Plan is left unchanged when 
+ * there is no lock-step kernel for k 
+ */
+static int SellPlan(fusedMM_plan_t *pl, const INDEXTYPE sigma)
+{
+   int status; 
+
+#ifdef DREAL 
+   pl->sellkern_b0 = dgfusedMM_sell_getkern(pl->tkern, pl->k, 1.0, 0.0);
+   pl->sellkern_b1 = dgfusedMM_sell_getkern(pl->tkern, pl->k, 1.0, 1.0);
+   pl->sellkern_bx = dgfusedMM_sell_getkern(pl->tkern, pl->k, 0.0, 0.0);
+#else
+   pl->sellkern_b0 = sgfusedMM_sell_getkern(pl->tkern, pl->k, 1.0, 0.0);
+   pl->sellkern_b1 = sgfusedMM_sell_getkern(pl->tkern, pl->k, 1.0, 1.0);
+   pl->sellkern_bx = sgfusedMM_sell_getkern(pl->tkern, pl->k, 0.0, 0.0);
+#endif
+   if (!pl->sellkern_b0)
+      return FUSEDMM_SUCCESS_RETURN;
+   status = fusedMM_csr2sell(&pl->sell, sigma, pl->m, pl->indx, pl->pntrb, 
+         pl->pntre, NULL);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+      return status;
+   pl->sellb = (INDEXTYPE*) malloc((pl->nthreads+1)*sizeof(INDEXTYPE));
+   if (!pl->sellb)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   GetRowPartition(pl->sell->nchunk, pl->sell->cptr, pl->sell->cptr+1, 
+         pl->nthreads, FUSEDMM_SELL_C*PART_ROW_COST, pl->sellb);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+int fusedMM_plan_create_ex
+(
+   fusedMM_plan_t **plan,     // OUT: created plan  
+   const int32_t imessage,    // message to dictate the operations  
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix 
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix 
+   const COLINDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const fusedMM_plan_opts_t *opts // options, NULL: all 0
+)
+{
+   int status;
+   fusedMM_plan_t *pl; 
+   const fusedMM_plan_opts_t defopts = {0}; 
+   
+   *plan = NULL;
+   if (!opts)
+      opts = &defopts; 
+   pl = (fusedMM_plan_t*) malloc(sizeof(fusedMM_plan_t));
+   if (!pl)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   status = InitPlan(pl, imessage, m, n, k, nnz, rows, cols, indx, pntrb, 
+         pntre);
+   if (status != FUSEDMM_SUCCESS_RETURN)
+   {
+      free(pl);
+      return status;
+   }
+#ifdef PTTIME
+   if (opts->nthreads > 0)
+      pl->nthreads = opts->nthreads; 
+#endif
+/*
+ * transposed plan works on the CSC of the sparse matrix 
+ */
+   if (opts->transpose)
+   {
+      status = TransposePlan(pl);
+      if (status != FUSEDMM_SUCCESS_RETURN)
+      {
+         fusedMM_plan_destroy(pl);
+         return status;
+      }
+   }
+/*
+ * reorder the graph, plan works on the permuted sparse matrix 
+ */
+   if (opts->reorder != FUSEDMM_REORDER_NONE && m == n && rows == m 
+         && cols == n)
+   {
+      status = ReorderPlan(pl, opts->reorder, opts->permuted);
+      if (status != FUSEDMM_SUCCESS_RETURN)
+      {
+         fusedMM_plan_destroy(pl);
+         return status;
+      }
+   }
+/*
+ * SELL-C-sigma or compressed column indices of the (reordered) graph for spmm
+ * and gcn kernels
+ */
+   if (opts->sell > 0 && (pl->tkern == 'm' || pl->tkern == 'g'))
+   {
+      status = SellPlan(pl, opts->sell);
+      if (status != FUSEDMM_SUCCESS_RETURN)
+      {
+         fusedMM_plan_destroy(pl);
+         return status;
+      }
+   }
+   if (!pl->sell && opts->vbidx && (pl->tkern == 'm' || pl->tkern == 'g'))
+   {
+      status = CompressPlan(pl);
+      if (status != FUSEDMM_SUCCESS_RETURN)
+      {
+         fusedMM_plan_destroy(pl);
+         return status;
+      }
+   }
+/*
+ * partition rows among threads, used by all kernels but SELL which has its 
+ * partition of chunks 
+ */
+   if (!pl->sell)
+      pl->part = CreatePartition(m, pl->pntrb, pl->pntre, pl->nthreads);
+   if (!pl->part && !pl->sell)
+   {
+      fusedMM_plan_destroy(pl);
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   }
+/*
+ * allocate scratch space T for each partition of general fusedMM 
+ */
+   if (!pl->tkern)
+   {
+      pl->work = (VALUETYPE*) malloc(pl->nthreads*k*sizeof(VALUETYPE));
+      if (!pl->work)
+      {
+         fusedMM_plan_destroy(pl);
+         return FUSEDMM_NOT_ENOUGH_MEM;
+      }
+   }
+   *plan = pl; 
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+int fusedMM_plan_create
+(
+   fusedMM_plan_t **plan,     // OUT: created plan  
+   const int32_t imessage,    // message to dictate the operations  
+   const INDEXTYPE m,         // number of row of X
+   const INDEXTYPE n,         // number of row of Y
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const INDEXTYPE nnz,       // nonzeros in sparse matrix 
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix 
+   const COLINDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre     // ending of rowptr for each row
+)
+{
+   return fusedMM_plan_create_ex(plan, imessage, m, n, k, nnz, rows, cols, 
+         indx, pntrb, pntre, NULL);
+}
+
+static int ExecPlan
+(
+   fusedMM_plan_t *plan,      // plan created by fusedMM_plan_create
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const VALUETYPE *val,      // value of non-zeros 
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X   
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y   
+   const VALUETYPE beta,      // beta value 
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z 
+)
+{
+   int status = 0;
+   const fusedMM_part_t *part = plan->part; 
+   const INDEXTYPE npart = part ? part->nthreads : plan->nthreads; 
+   const INDEXTYPE *rowb = part ? part->rowb : NULL; 
+   const INDEXTYPE *pntre = plan->pntre; 
+/*
+ * heavy rows are computed separately, kernels see them as empty rows 
+ */
+   const int split = part && part->nheavy && plan->splitok; 
+
+   if (split)
+   {
+      rowb = part->lrowb; 
+      pntre = part->pntre; 
+   }
+#ifdef ENABLE_OPT_FUSEDMM
+   if (plan->sell)
+   {
+      const fusedMM_sell_t *sell = plan->sell; 
+      FP_OPT_SELLKERN_FUNC kern = plan->sellkern_bx; 
+      if (alpha == 1.0 && beta == 0.0)
+         kern = plan->sellkern_b0; 
+      else if (alpha == 1.0 && beta == 1.0)
+         kern = plan->sellkern_b1; 
+      if (plan->tkern == 'm' && val) /* values in SELL order */
+         fusedMM_sell_set_values(plan->sell, val);
+      kern(plan->tkern, plan->m, plan->n, plan->k, alpha, 
+           sell->cptr[sell->nchunk], plan->rows, plan->cols, sell->val, 
+           sell->indx, sell->cptr, sell->rlen, sell->perm, x, ldx, y, ldy, 
+           beta, z, ldz, plan->nthreads, plan->sellb);
+   }
+   else if (plan->cidx)
+   {
+      FP_OPT_VBKERN_FUNC kern = plan->vbkern_bx; 
+      if (alpha == 1.0 && beta == 0.0)
+         kern = plan->vbkern_b0; 
+      else if (alpha == 1.0 && beta == 1.0)
+         kern = plan->vbkern_b1; 
+      kern(plan->tkern, plan->m, plan->n, plan->k, alpha, plan->nnz, 
+           plan->rows, plan->cols, val, plan->cidx, plan->cptr, plan->pntrb, 
+           pntre, x, ldx, y, ldy, beta, z, ldz, npart, rowb);
+   }
+   else if (plan->tkern)
+   {
+      FP_OPT_KERN_FUNC kern = plan->kern_bx; 
+      if (alpha == 1.0 && beta == 0.0)
+         kern = plan->kern_b0; 
+      else if (alpha == 1.0 && beta == 1.0)
+         kern = plan->kern_b1; 
+      kern(plan->tkern, plan->m, plan->n, plan->k, alpha, plan->nnz, 
+           plan->rows, plan->cols, val, plan->indx, plan->pntrb, pntre, x, 
+           ldx, y, ldy, beta, z, ldz, npart, rowb);
+   }
+   else
+#endif
+   if (plan->spec_kern)
+      status = fusedMM_spec_csr(plan->spec_kern, plan->m, plan->k, val, 
+            plan->indx, plan->pntrb, pntre, x, ldx, y, ldy, z, ldz, npart, 
+            rowb, plan->work);
+   else
+      status = GenFusedMM(plan, npart, rowb, pntre, val, x, ldx, y, ldy, z, 
+            ldz);
+   if (split)
+      status += ExecHeavyRows(plan, part, alpha, val, x, ldx, y, ldy, beta, z, 
+            ldz);
+   return status;
+}
+
+int fusedMM_plan_execute
+(
+   fusedMM_plan_t *plan,      // plan created by fusedMM_plan_create
+   const VALUETYPE alpha,     // alpha, not used yet in general fusedMM
+   const VALUETYPE *val,      // value of non-zeros 
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X   
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y   
+   const VALUETYPE beta,      // beta value 
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz        // leading dimension size of z 
+)
+{
+   int status;
+   const INDEXTYPE m = plan->m; 
+   const INDEXTYPE k = plan->k; 
+   VALUETYPE *pv, *px, *py, *pz; 
+
+   if (plan->tmap && val) /* values in the order of the transpose */
+   {
+   #ifdef PTTIME
+      #pragma omp parallel for num_threads(plan->nthreads) schedule(static)
+   #endif
+      for (INDEXTYPE j = 0; j < plan->nnz; j++)
+         plan->tval[j] = val[plan->tmap[j]];
+      val = plan->tval; 
+   }
+   if (!plan->perm)
+      return ExecPlan(plan, alpha, val, x, ldx, y, ldy, beta, z, ldz);
+/*
+ * reordered graph: operands are permuted to the new order, Z back. With 
+ * opts.permuted, X, Y and Z are already in the new order, only values are 
+ * permuted  
+ */
+   pv = plan->pbuf; 
+   if (val)
+   {
+   #ifdef PTTIME
+      #pragma omp parallel for num_threads(plan->nthreads) schedule(static)
+   #endif
+      for (INDEXTYPE j = 0; j < plan->nnz; j++)
+         pv[j] = val[plan->pmap[j]];
+   }
+   if (plan->permuted)
+      return ExecPlan(plan, alpha, val ? pv : NULL, x, ldx, y, ldy, beta, z, 
+                      ldz);
+   px = pv + plan->nnz; 
+   py = px + m * k; 
+   pz = py + m * k; 
+   fusedMM_permute_dense(0, m, k, plan->perm, x, ldx, px, k);
+   if (y == x && ldy == ldx)
+      py = px; 
+   else
+      fusedMM_permute_dense(0, m, k, plan->perm, y, ldy, py, k);
+   fusedMM_permute_dense(0, m, k, plan->perm, z, ldz, pz, k);
+   status = ExecPlan(plan, alpha, val ? pv : NULL, px, k, py, k, beta, pz, k);
+   fusedMM_permute_dense(1, m, k, plan->perm, pz, k, z, ldz);
+   return status;
+}
+
+const INDEXTYPE *fusedMM_plan_perm(const fusedMM_plan_t *plan)
+{
+   return plan->perm; 
+}
+
+void fusedMM_plan_destroy(fusedMM_plan_t *plan)
+{
+   if (!plan)
+      return;
+   DestroyPartition(plan->part);
+   if (plan->work)
+      free(plan->work);
+   free(plan->perm);
+   free(plan->pmap);
+   free(plan->pindx);
+   free(plan->prowptr);
+   free(plan->pbuf);
+   free(plan->cidx);
+   free(plan->cptr);
+   free(plan->tindx);
+   free(plan->tptr);
+   free(plan->tmap);
+   free(plan->tval);
+   fusedMM_sell_destroy(plan->sell);
+   free(plan->sellb);
+   free(plan);
+}
+
+#ifdef __cplusplus
+   } // extern "C"
+#endif
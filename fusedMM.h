@@ -5,6 +5,14 @@
    extern "C"
    {
 #endif 
+/*
+ * indx (column indices of the sparse matrix) is of type COLINDEXTYPE, which 
+ * is INDEXTYPE unless the library is built with a narrower one, e.g., 
+ * -DCOLINDEXTYPE=uint32_t for graphs with less than 2^32 vertices 
+ */
+#ifndef COLINDEXTYPE
+   #define COLINDEXTYPE INDEXTYPE
+#endif
 /*
  * Messages for different operations
  *    VOP message :        x0~xF
@@ -45,6 +53,14 @@
 /* SOP : Scalar operation */
 #define SOP_NOOP 0x000        /* NO OP */
 #define SOP_COPY 0x100        /* Scalar copy */ 
+#define SOP_SOFTMAX 0x200     /* softmax of the scalars of a row's edges */
+/*
+ * SOP_SOFTMAX: scalar of edge j of row i is exp(s_j - max) / sum of the row, 
+ * where s_j is the output of ROP. VOP_COPY_RHS|ROP_DOT|SOP_SOFTMAX|VSC_MUL|
+ * AOP_ADD is the attention aggregation, optimized kernels compute it in one 
+ * pass (running max and sum). Rows are never split among threads then, and 
+ * fusedMM_csr (and plans) is the only API supporting it 
+ */
 #define SOP_UDEF 0xF00        /* USER DEFINE FUNC */ 
 #define SOP_CLEAR(bvec) ((bvec) & (~((int32_t)0xF00)))  
 #define SOP_MASK(bvec) ((bvec) & 0xF00)  
@@ -72,21 +88,234 @@
 #define SET_AOP_FLAG(imsg, vflag)  (imsg = (AOP_CLEAR(imsg) | vflag)) 
 #define GET_AOP_FLAG(imsg) AOP_MASK(imsg)
 
-
+/*
+ * sigmoid and t-dist messages with tiny K use an edge-vectorized optimized 
+ * kernel (edges in the SIMD lanes instead of features). It only applies for 
+ * K <= VLEN/8: K <= 2 on AVX512 and K = 1 on AVX2 in single precision, K = 1
+ * on AVX512 in double precision. Wider K uses the generated kernels, which 
+ * were as fast or faster at K = 3..8, see SMALLK_MAXK in kernels/src/kernels.c
+ */
 int fusedMM_csr 
 (
    const int32_t imessage,    /* message to dictate the operations */
    const INDEXTYPE m,         /* number of row of X */
    const INDEXTYPE n,         /* number of row of Y */
    const INDEXTYPE k,         /* feature dimension (col of X or Y) */
-   const VALUETYPE alpha,     /* not used yet in general fusedMM */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const VALUETYPE *y,        /* Dense Y matrix */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz        /* leading dimension size of Z */
+);
+
+/*
+ * Number of threads used by fusedMM_csr and by plans created afterward. 
+ * nthreads <= 0 resets to the default: FUSEDMM_NUM_THREADS environment 
+ * variable if set, otherwise the default number of threads of openmp 
+ * (omp_get_max_threads). The library never changes the number of threads of 
+ * the application, call it with 1 to run inside your own thread pool.  
+ */
+void fusedMM_set_num_threads(const int nthreads);
+int fusedMM_get_num_threads(void);
+
+/*
+ * Persistent execution plan of fusedMM_csr: 
+ *    Message is decoded, optimized kernel is selected, rows of the sparse 
+ *    matrix are partitioned among threads and scratch space is allocated once 
+ *    in fusedMM_plan_create. fusedMM_plan_execute runs only the edge loop. 
+ *    Plan keeps the number of threads at creation, see fusedMM_set_num_threads
+ *    and fusedMM_plan_create_ex 
+ *    Useful when same message is applied on the same graph many times (e.g., 
+ *    each epoch of graph embedding).   
+ *    NOTE: plan keeps the pointers of sparse structure (indx, pntrb, pntre), 
+ *    user must not update or free them before destroying the plan. Values of 
+ *    nonzeros and dense matrices can be changed in each execute call. 
+ *    NOTE: same plan should not be executed concurrently, it owns the scratch 
+ *    space.
+ */
+typedef struct fusedMM_plan fusedMM_plan_t;
+
+int fusedMM_plan_create
+(
+   fusedMM_plan_t **plan,     /* OUT: created plan */
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
    const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
    const INDEXTYPE rows,      /* number of rows in sparse matrix */
    const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre     /* ending of rowptr for each row: rowptr+1 */
+);
+/*
+ * Options of a plan, given to fusedMM_plan_create_ex. All 0 (e.g., 
+ * fusedMM_plan_opts_t opts = {0}) is the plan of fusedMM_plan_create. Options
+ * are kept in the plan: plans with different options can be created and 
+ * executed from different threads. A single plan is not re-entrant: execute 
+ * writes the values in CSC/permuted order and the permuted X, Y, Z into the 
+ * scratch of the plan, so executes of the same plan must be serialized, or 
+ * each thread creates its own plan.  
+ */
+typedef struct fusedMM_plan_opts
+{
+   int nthreads;     /* threads (PTTIME), 0: fusedMM_get_num_threads() */
+   int reorder;      /* reordering of the graph, see FUSEDMM_REORDER_NONE */
+   int transpose;    /* 1: transposed plan, see fusedMM_csc */
+   int vbidx;        /* 1: compressed column indices of spmm and gcn */
+   INDEXTYPE sell;   /* sigma > 0: SELL-C-sigma storage, see fusedMM_sell */
+   int permuted;     /* 1: X, Y, Z of execute in order of fusedMM_plan_perm */
+} fusedMM_plan_opts_t;
+
+int fusedMM_plan_create_ex
+(
+   fusedMM_plan_t **plan,     /* OUT: created plan */
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const fusedMM_plan_opts_t *opts /* options, NULL: all 0 */
+);
+
+int fusedMM_plan_execute
+(
+   fusedMM_plan_t *plan,      /* plan created by fusedMM_plan_create */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
    const VALUETYPE *val,      /* value of non-zeros */
-   const INDEXTYPE *indx,     /* colids -> column indices */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const VALUETYPE *y,        /* Dense Y matrix */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz        /* leading dimension size of Z */
+);
+
+void fusedMM_plan_destroy(fusedMM_plan_t *plan);
+
+/*
+ * With LOAD_BALANCE, fusedMM_csr partitions the rows of the sparse matrix 
+ * among threads once and caches the partition for the sparse matrix (keyed 
+ * by pntrb, pntre, m, nonzeros) and number of threads. The rowptr itself is 
+ * not rescanned on each call: 
+ *    NOTE: call this function to free the cached partitions, and after 
+ *    updating pntrb/pntre in place or reusing them for another graph of the 
+ *    same size. Such callers better use the plan API (fusedMM_plan_create), 
+ *    which owns its partition. Build with -DPART_CHECKSUM to validate cached 
+ *    partitions against a checksum of pntrb and pntre (O(m) per call). 
+ */
+void fusedMM_partition_cache_clear(void);
+
+/*
+ * Graph reordering: vertices are renumbered so that rows of Y accessed by
+ * nearby rows of the sparse matrix are nearby in memory. Sparse matrix must be
+ * square (adjacency of a graph), X, Y and Z are indexed by the same vertices.
+ *    perm[i] is the original id of the vertex i in the new order
+ */
+#define FUSEDMM_REORDER_NONE 0    /* identity */
+#define FUSEDMM_REORDER_RCM 1     /* reverse Cuthill-McKee */
+#define FUSEDMM_REORDER_DEGREE 2  /* sorted by degree (descending) */
+#define FUSEDMM_REORDER_HUB 3     /* hub clustering: high degree vertices first */
+
+int fusedMM_reorder_csr
+(
+   const int method,          /* FUSEDMM_REORDER_[NONE,RCM,DEGREE,HUB] */
+   const INDEXTYPE m,         /* number of rows (= cols) of sparse matrix */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   INDEXTYPE *perm            /* OUT: permutation, m elements */
+);
+/*
+ * Permuted sparse matrix P*A*P^T in CSR, column indices are sorted in each
+ * row. pmap[j] (when not NULL) is the position of the nonzero j in the
+ * original matrix, use it to permute the updated values later
+ */
+int fusedMM_permute_csr
+(
+   const INDEXTYPE m,         /* number of rows (= cols) of sparse matrix */
+   const INDEXTYPE *perm,     /* permutation from fusedMM_reorder_csr */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
    const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
    const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *val,      /* value of non-zeros, can be NULL */
+   COLINDEXTYPE *pindx,       /* OUT: colids of permuted matrix, nnz elements */
+   INDEXTYPE *prowptr,        /* OUT: rowptr of permuted matrix, m+1 elements */
+   VALUETYPE *pval,           /* OUT: values of permuted matrix if val given */
+   INDEXTYPE *pmap            /* OUT: original position of nonzeros, or NULL */
+);
+/*
+ * Permute rows of dense matrix: out[i] = in[perm[i]] to the new order or
+ * out[perm[i]] = in[i] back to the original order (inverse = 1)
+ */
+void fusedMM_permute_dense
+(
+   const int inverse,         /* 0: to new order, 1: to original order */
+   const INDEXTYPE m,         /* number of rows */
+   const INDEXTYPE k,         /* number of columns */
+   const INDEXTYPE *perm,     /* permutation from fusedMM_reorder_csr */
+   const VALUETYPE *in,       /* Dense input matrix */
+   const INDEXTYPE ldin,      /* leading dimension of in */
+   VALUETYPE *out,            /* Dense output matrix */
+   const INDEXTYPE ldout      /* leading dimension of out */
+);
+/*
+ * Plans with opts.reorder (fusedMM_plan_opts_t) reorder the graph with the 
+ * method: sparse matrix is permuted once in fusedMM_plan_create_ex, X, Y, Z 
+ * and values of nonzeros are permuted in each execute and Z is permuted back,
+ * so the caller sees the original order. Permutation of the dense matrices 
+ * costs O(m*k) in each execute: with opts.permuted = 1, X, Y and Z given to 
+ * fusedMM_plan_execute are in the new order (only values of nonzeros are 
+ * permuted), permute them once with fusedMM_permute_dense and the perm of the
+ * plan and Z back after the last execute. Ignored when the sparse matrix is 
+ * not square or m != n. fusedMM_csr never reorders.
+ */
+/*
+ * permutation of a reordered plan, perm[i] is the original id of the vertex 
+ * i. NULL: plan does not reorder, X, Y and Z are always in the original order
+ */
+const INDEXTYPE *fusedMM_plan_perm(const fusedMM_plan_t *plan);
+/*
+ * Transposed fusedMM for the backward pass (e.g., gradient of Y): sparse
+ * matrix A (rows x cols) is given in CSC, indx are the row indices and
+ * pntrb/pntre the colptr. Z has a row for each column of A:
+ *    Zj = AOP over the nonzeros a_ij of column j of message(Xj, Yi, a_ij)
+ * X and Z have m (<= cols) rows, Y has n (>= rows) rows. CSC of A is the CSR
+ * of A^T: columns are partitioned among threads and each output row is
+ * written by one thread (no atomics), optimized kernels of the message are
+ * used as in fusedMM_csr.
+ */
+int fusedMM_csc
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE m,         /* number of row of X and Z */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros in CSC order */
+   const COLINDEXTYPE *indx,  /* rowids -> row indices */
+   const INDEXTYPE *pntrb,    /* starting of colptr for each column: colptr */
+   const INDEXTYPE *pntre,    /* ending of colptr for each column: colptr+1 */
    const VALUETYPE *x,        /* Dense X matrix */
    const INDEXTYPE ldx,       /* 1eading dimension of X */
    const VALUETYPE *y,        /* Dense Y matrix */
@@ -95,6 +324,335 @@ int fusedMM_csr
    VALUETYPE *z,              /* Dense matrix Z */
    const INDEXTYPE ldz        /* leading dimension size of Z */
 );
+/*
+ * CSC of the sparse matrix in CSR, row indices are sorted in each column.
+ * cmap[j] (when not NULL) is the position of the nonzero j in the CSR, use it
+ * to reorder the updated values later
+ */
+int fusedMM_csr2csc
+(
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *val,      /* value of non-zeros, can be NULL */
+   COLINDEXTYPE *cindx,       /* OUT: rowids of CSC, nnz elements */
+   INDEXTYPE *colptr,         /* OUT: colptr of CSC, cols+1 elements */
+   VALUETYPE *cval,           /* OUT: values of CSC if val given */
+   INDEXTYPE *cmap            /* OUT: position of nonzeros in CSR, or NULL */
+);
+/*
+ * Plans with opts.transpose = 1 compute fusedMM_csc of the CSR matrix given 
+ * to fusedMM_plan_create_ex, m and n are the rows of X (Z) and Y of the
+ * transposed operation. The CSC is built once in fusedMM_plan_create_ex and
+ * values are reordered in each execute, so the forward and backward plans
+ * share the single CSR copy of the caller. Applied before reordering.
+ */
+/*
+ * Plans with opts.vbidx = 1 compress the column indices when the message has
+ * an optimized spmm or gcn kernel and column indices are sorted in each row:
+ * indices of a row are delta encoded with the fewest bytes for the row and 
+ * decoded by the kernels, which reduces index traffic at small K. Built once
+ * in fusedMM_plan_create_ex, heavy rows split among threads still use indx. 
+ * fusedMM_csr never compresses.
+ */
+/*
+ * SELL-C-sigma storage of the sparse matrix for graphs with short rows (road
+ * networks, meshes) where a CSR row is too short to keep the SIMD units busy:
+ * rows are sorted by nonzeros (descending) within windows of sigma rows and
+ * packed in chunks of FUSEDMM_SELL_C rows. Nonzeros of a chunk are stored
+ * column-major and padded to its longest row, spmm and gcn kernels run the
+ * rows of a chunk in lock-step. Larger sigma pads less, but rows of a chunk
+ * come from farther apart. sigma is rounded up to a multiple of
+ * FUSEDMM_SELL_C, sigma <= 0 sorts all rows.
+ */
+#define FUSEDMM_SELL_C 8          /* rows of a chunk */
+
+typedef struct fusedMM_sell
+{
+   INDEXTYPE m;               /* number of rows of sparse matrix */
+   INDEXTYPE sigma;           /* rows are sorted within windows of sigma */
+   INDEXTYPE nchunk;          /* number of chunks */
+   INDEXTYPE *cptr;           /* chunk c: nonzeros cptr[c] to cptr[c+1]-1 */
+   INDEXTYPE *rlen;           /* nonzeros of row r in SELL order */
+   INDEXTYPE *perm;           /* row r in SELL order is row perm[r], -1: pad */
+   COLINDEXTYPE *indx;        /* colids, nonzero j of row r of chunk c at
+                                 cptr[c] + j*FUSEDMM_SELL_C + r */
+   VALUETYPE *val;            /* values, 0 on padding */
+   INDEXTYPE *vmap;           /* vmap[e]: position in CSR, -1 on padding */
+} fusedMM_sell_t;
+
+int fusedMM_csr2sell
+(
+   fusedMM_sell_t **sell,     /* OUT: created SELL-C-sigma matrix */
+   const INDEXTYPE sigma,     /* sorting window */
+   const INDEXTYPE m,         /* number of rows in sparse matrix */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *val       /* value of non-zeros, can be NULL */
+);
+/*
+ * copies the values of the nonzeros of the CSR matrix to sell
+ */
+void fusedMM_sell_set_values(fusedMM_sell_t *sell, const VALUETYPE *val);
+void fusedMM_sell_destroy(fusedMM_sell_t *sell);
+/*
+ * fusedMM on SELL-C-sigma, only spmm and gcn messages with k up to the SIMD
+ * vector length (a row of Z per register), returns FUSEDMM_NO_OPT_IMPL 
+ * otherwise. m must be sell->m. spmm uses the values of sell
+ */
+int fusedMM_sell
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const fusedMM_sell_t *sell,/* sparse matrix from fusedMM_csr2sell */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const VALUETYPE *y,        /* Dense Y matrix */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz        /* leading dimension size of Z */
+);
+/*
+ * Plans with opts.sell = sigma > 0 store the sparse matrix in SELL-C-sigma 
+ * when fusedMM_sell supports the message and k, values are copied in each 
+ * execute. Takes precedence over opts.vbidx. fusedMM_csr never uses it.
+ */
+/*
+ * Half precision storage of X and Y: elements are 16 bit bf16 or IEEE fp16,
+ * kernels convert them to float and accumulate in float, Z is float. spmm,
+ * gcn and sigmoid have generated kernels, other messages convert the rows and
+ * use the general fusedMM. Only for single precision (VALUETYPE = float),
+ * returns FUSEDMM_NO_OPT_IMPL otherwise.
+ */
+#define FUSEDMM_BF16 1            /* bfloat16: upper half of a float */
+#define FUSEDMM_FP16 2            /* IEEE 754 half precision */
+
+int fusedMM_csr_half
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const int dtype,           /* FUSEDMM_[BF16,FP16]: type of X and Y */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const uint16_t *x,         /* Dense X matrix of dtype */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const uint16_t *y,         /* Dense Y matrix of dtype */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz        /* leading dimension size of Z */
+);
+/*
+ * conversion of n elements between VALUETYPE and dtype, to half rounds to
+ * nearest even (fp16 overflows to inf)
+ */
+int fusedMM_cvt_half(const int dtype, const INDEXTYPE n, const VALUETYPE *in,
+      uint16_t *out);
+int fusedMM_cvt_float(const int dtype, const INDEXTYPE n, const uint16_t *in,
+      VALUETYPE *out);
+/*
+ * int8 storage of Y with a scale and zero-point per row: row j of Y is 
+ * yq[2*j] * (q - yq[2*j+1]) with q the int8 elements of the row. Scale and 
+ * zero-point are interleaved so that an edge reads them in one cache line. X 
+ * and Z are float. spmm, gcn and sigmoid have generated kernels which convert Y in 
+ * registers, other messages use the general fusedMM on the dequantized rows.
+ * Only for single precision, returns FUSEDMM_NO_OPT_IMPL otherwise.
+ */
+#define FUSEDMM_INT8 3            /* int8 Y, see fusedMM_csr_i8 */
+
+int fusedMM_csr_i8
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const int8_t *y,           /* Dense Y matrix, quantized */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE *yq,       /* scale and zero-point of each row of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz        /* leading dimension size of Z */
+);
+/*
+ * quantizes n rows of y to q: range [min, max] of a row (including 0) maps to
+ * [-128, 127], scale and zero-point of row j in yq[2*j] and yq[2*j+1]
+ */
+int fusedMM_quantize_i8(const INDEXTYPE n, const INDEXTYPE k, 
+      const VALUETYPE *y, const INDEXTYPE ldy, int8_t *q, const INDEXTYPE ldq,
+      VALUETYPE *yq);
+/*
+ * Multi-head message (e.g., GAT): k is split in nhead heads of k/nhead 
+ * consecutive features. ROP of an edge is computed on each head and gives a 
+ * scalar per head, SOP and VSC are applied to each head with its own scalar, 
+ * AOP is unchanged. sigmoid and t-dist messages have optimized kernels which
+ * traverse the graph once with all heads in registers when k/nhead is a 
+ * power of 2 multiple of the vector length. Otherwise, messages with an 
+ * optimized kernel call it on each head, others use the general fusedMM on 
+ * each head of an edge. nhead = 1 or a message without ROP is same as 
+ * fusedMM_csr. returns FUSEDMM_FAIL_RETURN when nhead doesn't divide k.
+ */
+int fusedMM_csr_mh
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE nhead,     /* number of heads, divides k */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const VALUETYPE *y,        /* Dense Y matrix */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz        /* leading dimension size of Z */
+);
+/*
+ * Same as fusedMM_csr, but the scalar of each nonzero after SOP (e.g., 
+ * attention logit with SOP_COPY, sigmoid probability or distance) is also 
+ * stored in edge_out[nnz], in order of the nonzeros of the CSR. A message 
+ * without ROP gives val[j] (1 when val is NULL), SOP_NOOP gives the output of
+ * ROP. z = NULL is the SDDMM-only mode: VSC and AOP are skipped and Z is not 
+ * accessed. sigmoid and t-dist messages have optimized kernels which store a
+ * block of edges right after its SOP, in the same pass as the update of Z. 
+ */
+int fusedMM_csr_edge
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const VALUETYPE *y,        /* Dense Y matrix */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z, NULL: SDDMM-only */
+   const INDEXTYPE ldz,       /* leading dimension size of Z */
+   VALUETYPE *edge_out        /* OUT: scalar of nonzero j at edge_out[j] */
+);
+
+/*
+ * Degree normalization of the aggregation: the message vector of nonzero j 
+ * of row i (after VSC) is scaled by rs[i] * cs[indx[j]] before AOP. NULL rs 
+ * or cs means no scaling, unless computed from degrees by norm: 
+ *    FUSEDMM_NORM_SCALE: rs and cs are used as given
+ *    FUSEDMM_NORM_SYM: D^-1/2 A D^-1/2, NULL rs and cs are deg^-1/2, where 
+ *       deg[i] = pntre[i] - pntrb[i] (cs needs a square sparse matrix)  
+ *    FUSEDMM_NORM_MEAN: D^-1 A (GraphSAGE mean), NULL rs is 1/deg, cs is not
+ *       computed 
+ * The gcn message (VOP_COPY_RHS|ROP_NOOP|SOP_NOOP|VSC_NOOP|AOP_ADD) never 
+ * reads val: optimized kernels scale the rows of Y and Z in registers. 
+ */
+#define FUSEDMM_NORM_SCALE 0
+#define FUSEDMM_NORM_SYM 1
+#define FUSEDMM_NORM_MEAN 2
+/*
+ * s[i] = deg[i]^-1/2 (FUSEDMM_NORM_SYM) or 1/deg[i] (FUSEDMM_NORM_MEAN) for 
+ * i=0..m-1, 0 for rows without nonzeros 
+ */
+int fusedMM_degree_scale(const int norm, const INDEXTYPE m, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, VALUETYPE *s);
+
+int fusedMM_csr_norm
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const int norm,            /* FUSEDMM_NORM_SCALE, _SYM or _MEAN */
+   const VALUETYPE *rs,       /* scale of row i, NULL: see norm */
+   const VALUETYPE *cs,       /* scale of column j, NULL: see norm */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros, not used by gcn */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const VALUETYPE *y,        /* Dense Y matrix */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, Z = alpha*func(X,Y,A) + beta*Z */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz        /* leading dimension size of Z */
+);
+
+/*
+ * Same as fusedMM_csr for AOP_MAX and AOP_MIN messages, but arg[i*ldz+kk] 
+ * also gets the nonzero of row i (index in val and indx) which gave 
+ * Z[i*ldz+kk], -1 when Z keeps its value or row i has no nonzeros, so the 
+ * gradient is routed without recomputing the forward. Ties keep the first 
+ * nonzero. Max (min) pooling, VOP_COPY_RHS|ROP_NOOP|SOP_NOOP|VSC_NOOP with 
+ * AOP_MAX (AOP_MIN), has optimized kernels which compute 
+ * Z = max(alpha * max_j Yj, beta * Z), Z wins ties then. returns 
+ * FUSEDMM_AOP_FAIL_RETURN for other AOP. 
+ */
+int fusedMM_csr_arg
+(
+   const int32_t imessage,    /* message to dictate the operations */
+   const INDEXTYPE m,         /* number of row of X */
+   const INDEXTYPE n,         /* number of row of Y */
+   const INDEXTYPE k,         /* feature dimension (col of X or Y) */
+   const VALUETYPE alpha,     /* used by optimized kernels only */
+   const INDEXTYPE nnz,       /* nonzeros in sparse matrix */
+   const INDEXTYPE rows,      /* number of rows in sparse matrix */
+   const INDEXTYPE cols,      /* number of columns in sparse matrix */
+   const VALUETYPE *val,      /* value of non-zeros */
+   const COLINDEXTYPE *indx,  /* colids -> column indices */
+   const INDEXTYPE *pntrb,    /* starting of rowptr for each row: rowptr */
+   const INDEXTYPE *pntre,    /* ending of rowptr for each row: rowptr+1 */
+   const VALUETYPE *x,        /* Dense X matrix */
+   const INDEXTYPE ldx,       /* 1eading dimension of X */
+   const VALUETYPE *y,        /* Dense Y matrix */
+   const INDEXTYPE ldy,       /* leading dimension of Y */
+   const VALUETYPE beta,      /* beta value, used by optimized kernels only */
+   VALUETYPE *z,              /* Dense matrix Z */
+   const INDEXTYPE ldz,       /* leading dimension size of Z and arg */
+   INDEXTYPE *arg             /* OUT: nonzero which gave Z[i*ldz+kk] */
+);
 
 /*
  * Function prototype for user defined functions 
@@ -129,6 +687,7 @@ int fusedMM_csr
 //#define VOP_UDEF_IMPL 1 
 //#define ROP_UDEF_IMPL 1 
 #define SOP_UDEF_IMPL 1 
+#define SOP_UDEF_BATCH_IMPL 1 
 //#define VSC_UDEF_IMPL 1 
 //#define AOP_UDEF_IMPL 1 
 
@@ -137,6 +696,13 @@ int VOP_UDEF_FUNC(INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim,
 int ROP_UDEF_FUNC(INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim, 
       const VALUETYPE *rhs, VALUETYPE *out); 
 int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out); 
+/*
+ * Batched SOP: out[i] = SOP(in[i]) for i=0..n-1, in and out may be the same 
+ * array. Optimized kernels apply SOP on a block of edges with a single call 
+ * of this function. When SOP_UDEF_BATCH_IMPL is not defined, the default one 
+ * calls SOP_UDEF_FUNC for each element.  
+ */
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out); 
 int VSC_UDEF_FUNC(INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE scal, 
       INDEXTYPE out_dim, VALUETYPE *out); 
 int AOP_UDEF_FUNC(INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
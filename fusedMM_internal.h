@@ -43,46 +43,159 @@ typedef int (*FP_VSC_FUNC)(INDEXTYPE rhs_dim, const VALUETYPE *rhs,
 typedef int (*FP_AOP_FUNC)(INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
       VALUETYPE *out); 
 /*
- * USER DEFINE FUNC IMPLEMENTATION 
- * DUMMY function, always return error when not implemented by user but used in
- * message using UDEF
+ * function pointer of optimized kernel in kernels/include/kernels.h 
  */
-#ifndef VOP_UDEF_IMPL 
-int VOP_UDEF_FUNC(INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim, 
-      const VALUETYPE *rhs, INDEXTYPE out_dim, VALUETYPE *out)
-{
-   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
-}
+#ifdef DREAL 
+   typedef kern_dgfusedMM_t FP_OPT_KERN_FUNC; 
+   typedef kern_dgfusedMM_vb_t FP_OPT_VBKERN_FUNC;
+   typedef kern_dgfusedMM_sell_t FP_OPT_SELLKERN_FUNC;
+#else
+   typedef kern_sgfusedMM_t FP_OPT_KERN_FUNC;
+   typedef kern_sgfusedMM_vb_t FP_OPT_VBKERN_FUNC;
+   typedef kern_sgfusedMM_sell_t FP_OPT_SELLKERN_FUNC;
 #endif
-#ifndef ROP_UDEF_IMPL 
-int ROP_UDEF_FUNC(INDEXTYPE lhs_dim, const VALUETYPE *lhs, INDEXTYPE rhs_dim, 
-      const VALUETYPE *rhs, VALUETYPE *out) 
+/*
+ * general fusedMM specialized for the message at compile time, see 
+ * fusedMM_spec.h: computes rows rowb to rowe-1 using scratch space T 
+ */
+typedef int (*FP_SPEC_KERN_FUNC)(const INDEXTYPE rowb, const INDEXTYPE rowe, 
+      const INDEXTYPE k, const VALUETYPE *val, const COLINDEXTYPE *indx, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const VALUETYPE *x, 
+      const INDEXTYPE ldx, const VALUETYPE *y, const INDEXTYPE ldy, 
+      VALUETYPE *z, const INDEXTYPE ldz, VALUETYPE *T);
+/* returns NULL when there is no instantiation for the message */
+FP_SPEC_KERN_FUNC GetSpecKern(int32_t imessage);
+/*
+ * parallel driver of the specialized kernel: 
+ *    rowb = NULL: rows are scheduled by openmp  
+ *    otherwise: partition t has rows rowb[t] to rowb[t+1]-1, t < nthreads
+ *    work: scratch space of nthreads*k elements, allocated when NULL
+ */
+int fusedMM_spec_csr(FP_SPEC_KERN_FUNC kern, const INDEXTYPE m, 
+      const INDEXTYPE k, const VALUETYPE *val, const COLINDEXTYPE *indx, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const VALUETYPE *x, 
+      const INDEXTYPE ldx, const VALUETYPE *y, const INDEXTYPE ldy, 
+      VALUETYPE *z, const INDEXTYPE ldz, const INDEXTYPE nthreads, 
+      const INDEXTYPE *rowb, VALUETYPE *work);
+/*
+ * partition rows among nthreads based on cost: rowb[0..nthreads], cost of a 
+ * row is its nonzeros + rowcost  
+ */
+void GetRowPartition(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE nthreads, 
+      const INDEXTYPE rowcost, INDEXTYPE *rowb);
+/*
+ * Partition of rows among threads, rows with too many nonzeros (heavy rows) 
+ * are split into chunks of nonzeros, see CreatePartition in fusedMM.c 
+ */
+typedef struct fusedMM_part 
 {
-   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
-}
-#endif
+   INDEXTYPE nthreads;        /* number of partitions of rows */
+   INDEXTYPE *rowb;           /* partition t: rows rowb[t] to rowb[t+1]-1 */  
+   INDEXTYPE *lrowb;          /* rowb when heavy rows are split */
+   INDEXTYPE nheavy;          /* number of heavy rows, 0: no split */
+   INDEXTYPE *hrow;           /* heavy row h is row hrow[h] */
+   INDEXTYPE *hchunk;         /* chunks of heavy row h: hchunk[h..h+1]-1 */
+   INDEXTYPE *crow;           /* chunk c belongs to row crow[c] */
+   INDEXTYPE *cb, *ce;        /* chunk c: nonzeros cb[c] to ce[c]-1 */
+   INDEXTYPE *pntre;          /* ending of rowptr, heavy rows are empty */
+   INDEXTYPE maxdeg;          /* most nonzeros in a row */
+/*
+ * cache entry, see AcquirePartition 
+ */
+   const INDEXTYPE *kpntrb, *kpntre; /* key of the sparse matrix */
+   INDEXTYPE m, nnz;
+   uint64_t cksum;            /* checksum of rowptr with PART_CHECKSUM */
+   int refcnt;                /* number of users of the partition */
+   int cached;                /* still in the cache */
+   uint64_t stamp;            /* last use */
+} fusedMM_part_t;
 
-#ifndef SOP_UDEF_IMPL 
-int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out) 
-{
-   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
-}
-#endif
-#ifndef VSC_UDEF_IMPL 
-int VSC_UDEF_FUNC(INDEXTYPE rhs_dim, const VALUETYPE *rhs, VALUETYPE scal, 
-      INDEXTYPE out_dim, VALUETYPE *out) 
-{
-   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
-}
-#endif
-#ifndef AOP_UDEF_IMPL /* func prototype */
-int AOP_UDEF_FUNC(INDEXTYPE rhs_dim, const VALUETYPE *rhs, INDEXTYPE out_dim, 
-      VALUETYPE *out) 
+fusedMM_part_t *CreatePartition(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE nthreads);
+void DestroyPartition(fusedMM_part_t *part);
+/*
+ * same as CreatePartition, but the partition is computed once for a sparse 
+ * matrix and nthreads, and shared from a cache afterward (looked up by the 
+ * key, with PART_CHECKSUM also by the checksum of pntrb and pntre). Release 
+ * after use. see fusedMM_partition_cache_clear in fusedMM.h 
+ */
+fusedMM_part_t *AcquirePartition(const INDEXTYPE m, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const INDEXTYPE nthreads);
+void ReleasePartition(fusedMM_part_t *part);
+/*
+ * Execution plan, see fusedMM_plan_create in fusedMM.h 
+ */
+struct fusedMM_plan 
 {
-   return FUSEDMM_UNDEFINED_USER_FUNCTION;  
-}
-#endif
-
+   int32_t imessage;          /* message to dictate the operations */
+   INDEXTYPE m, n, k;         /* dimensions of X(mxk), Y(nxk), Z(mxk) */
+   INDEXTYPE nnz, rows, cols; /* sparse matrix */
+   const COLINDEXTYPE *indx;  /* colids, owned by user */
+   const INDEXTYPE *pntrb;    /* starting of rowptr, owned by user */
+   const INDEXTYPE *pntre;    /* ending of rowptr, owned by user */
+/*
+ * selected optimized kernel, tkern = 0 means no optimized kernel for message 
+ */
+   char tkern;                
+   FP_OPT_KERN_FUNC kern_b0;  /* kernel for alpha = 1, beta = 0 */
+   FP_OPT_KERN_FUNC kern_b1;  /* kernel for alpha = 1, beta = 1 */
+   FP_OPT_KERN_FUNC kern_bx;  /* kernel for general alpha and beta */
+/*
+ * general fusedMM: specialized kernel, NULL means use operation of each stage 
+ */
+   FP_SPEC_KERN_FUNC spec_kern; 
+   FP_VOP_FUNC VOP_FUNC;
+   FP_ROP_FUNC ROP_FUNC;
+   FP_SOP_FUNC SOP_FUNC;
+   FP_VSC_FUNC VSC_FUNC;
+   FP_AOP_FUNC AOP_FUNC;      /* also combines chunks of heavy rows */
+   int splitok;               /* AOP can combine chunks of heavy rows */
+/*
+ * thread partition and scratch space 
+ */
+   INDEXTYPE nthreads;        /* number of threads */
+   fusedMM_part_t *part;      /* NULL: rows are scheduled by openmp */
+   VALUETYPE *work;           /* scratch space T, k elements per partition */
+/*
+ * transposed plan, see transpose of fusedMM_plan_opts_t. tmap = NULL: not 
+ * transposed, otherwise indx, pntrb and pntre point to the CSC of the sparse
+ * matrix
+ */
+   COLINDEXTYPE *tindx;       /* row indices of CSC, owned by plan */
+   INDEXTYPE *tptr;           /* colptr of CSC */
+   INDEXTYPE *tmap;           /* tmap[j]: position of nonzero j in the CSR */
+   VALUETYPE *tval;           /* values in CSC order */
+/*
+ * reordered graph, see reorder of fusedMM_plan_opts_t. perm = NULL: not 
+ * reordered, otherwise indx, pntrb and pntre point to the permuted sparse 
+ * matrix
+ */
+   INDEXTYPE *perm;           /* perm[i]: original id of vertex i */
+   INDEXTYPE *pmap;           /* pmap[j]: original position of nonzero j */
+   COLINDEXTYPE *pindx;       /* permuted sparse matrix, owned by plan */
+   INDEXTYPE *prowptr;
+   VALUETYPE *pbuf;           /* permuted values, X, Y and Z */
+   int permuted;              /* X, Y and Z are given in the new order */
+/*
+ * compressed column indices, see vbidx of fusedMM_plan_opts_t. cidx = NULL: 
+ * not used 
+ */
+   uint8_t *cidx;             /* varint stream of deltas, owned by plan */
+   INDEXTYPE *cptr;           /* row i starts at byte cptr[i] */
+   FP_OPT_VBKERN_FUNC vbkern_b0; 
+   FP_OPT_VBKERN_FUNC vbkern_b1; 
+   FP_OPT_VBKERN_FUNC vbkern_bx;
+/*
+ * SELL-C-sigma sparse matrix, see sell of fusedMM_plan_opts_t. sell = NULL: 
+ * not used
+ */
+   fusedMM_sell_t *sell;      /* owned by plan */
+   INDEXTYPE *sellb;          /* partition t: chunks sellb[t] to sellb[t+1]-1 */
+   FP_OPT_SELLKERN_FUNC sellkern_b0;
+   FP_OPT_SELLKERN_FUNC sellkern_b1;
+   FP_OPT_SELLKERN_FUNC sellkern_bx;
+};
 #ifdef __cplusplus
    } // extern "C"
 #endif
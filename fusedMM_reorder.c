@@ -0,0 +1,389 @@
+#ifdef __cplusplus
+   extern "C"
+   {
+#endif
+#include<stdint.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include <omp.h>
+#include"kernels/include/kernels.h"
+#ifdef DREAL
+   #define VALUETYPE double
+#else
+   #define VALUETYPE float
+#endif
+#include "fusedMM.h"
+
+/*=============================================================================
+ * Graph reordering:
+ *    Rows of Y are accessed by the column indices of the sparse matrix. When
+ *    the neighbors of nearby rows have nearby ids, rows of Y loaded for a row
+ *    are reused by the next rows from cache. Vertices are renumbered by:
+ *    RCM: reverse Cuthill-McKee, BFS from a minimum degree vertex of each
+ *       connected component visiting the neighbors in increasing degree,
+ *       reduces the bandwidth of the matrix
+ *    DEGREE: vertices sorted by degree (descending), rows of hubs are packed
+ *       together at the beginning of Y
+ *    HUB: hub clustering, vertices with degree above the average first,
+ *       relative order of the vertices is kept in both groups so that the
+ *       locality of the original numbering is not lost
+ *    Sparse matrix is treated as the adjacency of the graph (rows = cols),
+ *    only the out-edges (row i) are followed by RCM
+ *    perm[i] is the original id of the vertex i in the new order
+ *============================================================================*/
+/*
+ * heap sort of v[0:n-1] by key[v[i]] in ascending order
+ */
+static void SortByKey(const INDEXTYPE n, INDEXTYPE *v, const INDEXTYPE *key)
+{
+   INDEXTYPE i, p, c, t;
+
+   for (i = n/2; i > 0; i--) /* heapify */
+   {
+      for (p = i-1; (c = 2*p+1) < n; p = c)
+      {
+         if (c+1 < n && key[v[c+1]] > key[v[c]]) c++;
+         if (key[v[p]] >= key[v[c]]) break;
+         t = v[p]; v[p] = v[c]; v[c] = t;
+      }
+   }
+   for (i = n-1; i > 0; i--)
+   {
+      t = v[0]; v[0] = v[i]; v[i] = t;
+      for (p = 0; (c = 2*p+1) < i; p = c)
+      {
+         if (c+1 < i && key[v[c+1]] > key[v[c]]) c++;
+         if (key[v[p]] >= key[v[c]]) break;
+         t = v[p]; v[p] = v[c]; v[c] = t;
+      }
+   }
+}
+/*
+ * heap sort of key[0:n-1] in ascending order, pos is moved with the key
+ */
+static void SortPairs(const INDEXTYPE n, COLINDEXTYPE *key, INDEXTYPE *pos)
+{
+   INDEXTYPE i, p, c, t;
+   COLINDEXTYPE tk;
+
+   for (i = n/2; i > 0; i--) /* heapify */
+   {
+      for (p = i-1; (c = 2*p+1) < n; p = c)
+      {
+         if (c+1 < n && key[c+1] > key[c]) c++;
+         if (key[p] >= key[c]) break;
+         tk = key[p]; key[p] = key[c]; key[c] = tk;
+         t = pos[p]; pos[p] = pos[c]; pos[c] = t;
+      }
+   }
+   for (i = n-1; i > 0; i--)
+   {
+      tk = key[0]; key[0] = key[i]; key[i] = tk;
+      t = pos[0]; pos[0] = pos[i]; pos[i] = t;
+      for (p = 0; (c = 2*p+1) < i; p = c)
+      {
+         if (c+1 < i && key[c+1] > key[c]) c++;
+         if (key[p] >= key[c]) break;
+         tk = key[p]; key[p] = key[c]; key[c] = tk;
+         t = pos[p]; pos[p] = pos[c]; pos[c] = t;
+      }
+   }
+}
+/*
+ * stable counting sort of the vertices by degree
+ */
+static int DegreeSort(const INDEXTYPE m, const INDEXTYPE *deg,
+      const int descending, INDEXTYPE *perm)
+{
+   INDEXTYPE maxd = 0, *cnt;
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(fusedMM_get_num_threads()) \
+      reduction(max:maxd)
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+      if (deg[i] > maxd) maxd = deg[i];
+
+   cnt = (INDEXTYPE*) calloc(maxd+2, sizeof(INDEXTYPE));
+   if (!cnt)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   for (INDEXTYPE i = 0; i < m; i++)
+      cnt[descending ? maxd - deg[i] + 1 : deg[i] + 1]++;
+   for (INDEXTYPE d = 1; d <= maxd + 1; d++)
+      cnt[d] += cnt[d-1];
+   for (INDEXTYPE i = 0; i < m; i++)
+      perm[cnt[descending ? maxd - deg[i] : deg[i]]++] = i;
+   free(cnt);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+static int ReorderRCM(const INDEXTYPE m, const COLINDEXTYPE *indx,
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const INDEXTYPE *deg,
+      INDEXTYPE *perm)
+{
+   int status;
+   INDEXTYPE head = 0, tail = 0, *order;
+   char *mark;
+
+   order = (INDEXTYPE*) malloc(m*sizeof(INDEXTYPE));
+   mark = (char*) calloc(m, sizeof(char));
+   if (!order || !mark)
+   {
+      free(order);
+      free(mark);
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   }
+/*
+ * each component starts from its unvisited vertex with minimum degree
+ */
+   status = DegreeSort(m, deg, 0, order);
+   for (INDEXTYPE s = 0; s < m && status == FUSEDMM_SUCCESS_RETURN; s++)
+   {
+      if (mark[order[s]])
+         continue;
+      mark[order[s]] = 1;
+      perm[tail++] = order[s];
+      while (head < tail)
+      {
+         const INDEXTYPE v = perm[head++];
+         const INDEXTYPE qb = tail;
+         for (INDEXTYPE j = pntrb[v]; j < pntre[v]; j++)
+         {
+            const INDEXTYPE u = indx[j];
+            if (u < m && !mark[u])
+            {
+               mark[u] = 1;
+               perm[tail++] = u;
+            }
+         }
+         SortByKey(tail-qb, perm+qb, deg);
+      }
+   }
+/*
+ * reverse the Cuthill-McKee order
+ */
+   for (INDEXTYPE i = 0; i < m/2; i++)
+   {
+      const INDEXTYPE t = perm[i];
+      perm[i] = perm[m-1-i];
+      perm[m-1-i] = t;
+   }
+   free(order);
+   free(mark);
+   return status;
+}
+
+static int ReorderHub(const INDEXTYPE m, const INDEXTYPE *deg,
+      INDEXTYPE *perm)
+{
+   INDEXTYPE nnz = 0, avg, nhub = 0, h = 0, l;
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(fusedMM_get_num_threads()) \
+      reduction(+:nnz)
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+      nnz += deg[i];
+   avg = m ? nnz / m : 0;
+   for (INDEXTYPE i = 0; i < m; i++)
+      if (deg[i] > avg) nhub++;
+   l = nhub;
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      if (deg[i] > avg)
+         perm[h++] = i;
+      else
+         perm[l++] = i;
+   }
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+int fusedMM_reorder_csr
+(
+   const int method,          // FUSEDMM_REORDER_[NONE,RCM,DEGREE,HUB]
+   const INDEXTYPE m,         // number of rows (= cols) of sparse matrix
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   INDEXTYPE *perm            // OUT: perm[i] = original id of vertex i
+)
+{
+   int status;
+   INDEXTYPE *deg;
+
+   if (method == FUSEDMM_REORDER_NONE)
+   {
+   #ifdef PTTIME
+      #pragma omp parallel for num_threads(fusedMM_get_num_threads())
+   #endif
+      for (INDEXTYPE i = 0; i < m; i++)
+         perm[i] = i;
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+   deg = (INDEXTYPE*) malloc(m*sizeof(INDEXTYPE));
+   if (!deg)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(fusedMM_get_num_threads())
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+      deg[i] = pntre[i] - pntrb[i];
+
+   switch(method)
+   {
+      case FUSEDMM_REORDER_RCM:
+         status = ReorderRCM(m, indx, pntrb, pntre, deg, perm);
+         break;
+      case FUSEDMM_REORDER_DEGREE:
+         status = DegreeSort(m, deg, 1, perm);
+         break;
+      case FUSEDMM_REORDER_HUB:
+         status = ReorderHub(m, deg, perm);
+         break;
+      default:
+         status = FUSEDMM_FAIL_RETURN;
+   }
+   free(deg);
+   return status;
+}
+
+int fusedMM_permute_csr
+(
+   const INDEXTYPE m,         // number of rows (= cols) of sparse matrix
+   const INDEXTYPE *perm,     // perm[i] = original id of vertex i
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *val,      // value of non-zeros, can be NULL
+   COLINDEXTYPE *pindx,       // OUT: colids of permuted matrix
+   INDEXTYPE *prowptr,        // OUT: rowptr of permuted matrix, m+1 elements
+   VALUETYPE *pval,           // OUT: values of permuted matrix if val != NULL
+   INDEXTYPE *pmap            // OUT: original position of nonzeros, can be NULL
+)
+{
+   INDEXTYPE *iperm, *map;
+   const int nthreads = fusedMM_get_num_threads();
+
+   iperm = (INDEXTYPE*) malloc(m*sizeof(INDEXTYPE));
+   if (!iperm)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(nthreads)
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      iperm[perm[i]] = i;
+      prowptr[i+1] = pntre[perm[i]] - pntrb[perm[i]];
+   }
+   prowptr[0] = 0;
+   for (INDEXTYPE i = 0; i < m; i++)
+      prowptr[i+1] += prowptr[i];
+
+   map = pmap ? pmap : (INDEXTYPE*) malloc(prowptr[m]*sizeof(INDEXTYPE)+1);
+   if (!map)
+   {
+      free(iperm);
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   }
+/*
+ * column indices are renumbered and sorted within each row
+ */
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      const INDEXTYPE jb = pntrb[perm[i]];
+      const INDEXTYPE pb = prowptr[i];
+      const INDEXTYPE nj = prowptr[i+1] - pb;
+      for (INDEXTYPE j = 0; j < nj; j++)
+      {
+         pindx[pb+j] = iperm[indx[jb+j]];
+         map[pb+j] = jb + j;
+      }
+      SortPairs(nj, pindx+pb, map+pb);
+      if (val)
+         for (INDEXTYPE j = 0; j < nj; j++)
+            pval[pb+j] = val[map[pb+j]];
+   }
+   if (!pmap)
+      free(map);
+   free(iperm);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+void fusedMM_permute_dense
+(
+   const int inverse,         // 0: to new order, 1: back to original order
+   const INDEXTYPE m,         // number of rows
+   const INDEXTYPE k,         // number of columns
+   const INDEXTYPE *perm,     // perm[i] = original id of vertex i
+   const VALUETYPE *in,       // Dense input matrix
+   const INDEXTYPE ldin,      // leading dimension of in
+   VALUETYPE *out,            // Dense output matrix
+   const INDEXTYPE ldout      // leading dimension of out
+)
+{
+#ifdef PTTIME
+   #pragma omp parallel for num_threads(fusedMM_get_num_threads())
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      const VALUETYPE *I = in + (inverse ? i : perm[i]) * ldin;
+      VALUETYPE *O = out + (inverse ? perm[i] : i) * ldout;
+      for (INDEXTYPE kk = 0; kk < k; kk++)
+         O[kk] = I[kk];
+   }
+}
+
+/*=============================================================================
+ * Transpose: CSC of the sparse matrix, which is the CSR of its transpose.
+ *    Counting sort of the nonzeros by column, rows are visited in order so
+ *    the row indices of each column come out sorted
+ *============================================================================*/
+int fusedMM_csr2csc
+(
+   const INDEXTYPE rows,      // number of rows in sparse matrix
+   const INDEXTYPE cols,      // number of columns in sparse matrix
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *val,      // value of non-zeros, can be NULL
+   COLINDEXTYPE *cindx,       // OUT: row indices of CSC
+   INDEXTYPE *colptr,         // OUT: colptr of CSC, cols+1 elements
+   VALUETYPE *cval,           // OUT: values of CSC if val != NULL
+   INDEXTYPE *cmap            // OUT: position of nonzeros in CSR, can be NULL
+)
+{
+   INDEXTYPE *next;
+
+   next = (INDEXTYPE*) malloc((cols+1)*sizeof(INDEXTYPE));
+   if (!next)
+      return FUSEDMM_NOT_ENOUGH_MEM;
+   for (INDEXTYPE j = 0; j <= cols; j++)
+      colptr[j] = 0;
+   for (INDEXTYPE i = 0; i < rows; i++)
+      for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+         colptr[indx[j]+1]++;
+   for (INDEXTYPE j = 0; j < cols; j++)
+      colptr[j+1] += colptr[j];
+   for (INDEXTYPE j = 0; j < cols; j++)
+      next[j] = colptr[j];
+   for (INDEXTYPE i = 0; i < rows; i++)
+   {
+      for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+      {
+         const INDEXTYPE p = next[indx[j]]++;
+         cindx[p] = i;
+         if (cmap)
+            cmap[p] = j;
+         if (val)
+            cval[p] = val[j];
+      }
+   }
+   free(next);
+   return FUSEDMM_SUCCESS_RETURN;
+}
+
+#ifdef __cplusplus
+   } // extern "C"
+#endif
@@ -0,0 +1,114 @@
+#include<stdint.h>
+#include<stdio.h>
+#include"kernels/include/kernels.h"
+#ifdef DREAL
+   #define VALUETYPE double
+#else
+   #define VALUETYPE float
+#endif
+#include "fusedMM.h"
+#include "fusedMM_internal.h"
+#include "fusedMM_spec.h"
+
+/*=============================================================================
+ * Dispatch table: maps imessage to the instantiation of fusedMM_spec_rows
+ *    Each stage is selected one after another, the stages selected so far are
+ *    carried as template parameters. To keep the number of instantiations 
+ *    (and compile time) reasonable, the message is canonicalized first: 
+ *    1. SOP_NOOP is same as SOP_COPY (scalar passes through) 
+ *    2. VSC_NOOP doesn't use the scalar, so ROP and SOP are skipped 
+ *    3. AOP_NOOP and UDEF of VOP, ROP, VSC and AOP are not instantiated: 
+ *       user defined vector functions are called through pointer anyway, 
+ *       C++ applications can instantiate fusedMM_spec_rows with their own 
+ *       functors instead, see fusedMM_spec.h 
+ *    returns NULL when there is no instantiation for the message 
+ *============================================================================*/
+template <class VOP, class ROP, class SOP, class VSC>
+static FP_SPEC_KERN_FUNC GetSpecKernAOP(int32_t msg)
+{
+   switch(GET_AOP_FLAG(msg))
+   {
+      case AOP_ADD:
+         return fusedMM_spec_rows<VOP, ROP, SOP, VSC, AOP_SPEC<AOP_ADD> >;
+      case AOP_MAX:
+         return fusedMM_spec_rows<VOP, ROP, SOP, VSC, AOP_SPEC<AOP_MAX> >;
+      case AOP_MIN:
+         return fusedMM_spec_rows<VOP, ROP, SOP, VSC, AOP_SPEC<AOP_MIN> >;
+   }
+   return NULL;
+}
+
+template <class ROP, class SOP, class VSC>
+static FP_SPEC_KERN_FUNC GetSpecKernVOP(int32_t msg)
+{
+   switch(GET_VOP_FLAG(msg))
+   {
+      /* VOP_NOOP is not supported, see GetVOPFunc */
+      case VOP_COPY_LHS:
+         return GetSpecKernAOP<VOP_SPEC<VOP_COPY_LHS>, ROP, SOP, VSC>(msg);
+      case VOP_COPY_RHS:
+         return GetSpecKernAOP<VOP_SPEC<VOP_COPY_RHS>, ROP, SOP, VSC>(msg);
+      case VOP_ADD:
+         return GetSpecKernAOP<VOP_SPEC<VOP_ADD>, ROP, SOP, VSC>(msg);
+      case VOP_SUBL:
+         return GetSpecKernAOP<VOP_SPEC<VOP_SUBL>, ROP, SOP, VSC>(msg);
+      case VOP_SUBR:
+         return GetSpecKernAOP<VOP_SPEC<VOP_SUBR>, ROP, SOP, VSC>(msg);
+      case VOP_MAX:
+         return GetSpecKernAOP<VOP_SPEC<VOP_MAX>, ROP, SOP, VSC>(msg);
+      case VOP_MIN:
+         return GetSpecKernAOP<VOP_SPEC<VOP_MIN>, ROP, SOP, VSC>(msg);
+   }
+   return NULL;
+}
+
+template <class SOP, class VSC>
+static FP_SPEC_KERN_FUNC GetSpecKernROP(int32_t msg)
+{
+   switch(GET_ROP_FLAG(msg))
+   {
+      case ROP_NOOP:
+         return GetSpecKernVOP<ROP_SPEC<ROP_NOOP>, SOP, VSC>(msg);
+      case ROP_DOT:
+         return GetSpecKernVOP<ROP_SPEC<ROP_DOT>, SOP, VSC>(msg);
+      case ROP_ADD_LHS:
+         return GetSpecKernVOP<ROP_SPEC<ROP_ADD_LHS>, SOP, VSC>(msg);
+      case ROP_ADD_RHS:
+         return GetSpecKernVOP<ROP_SPEC<ROP_ADD_RHS>, SOP, VSC>(msg);
+      case ROP_NORML:
+         return GetSpecKernVOP<ROP_SPEC<ROP_NORML>, SOP, VSC>(msg);
+      case ROP_NORMR:
+         return GetSpecKernVOP<ROP_SPEC<ROP_NORMR>, SOP, VSC>(msg);
+   }
+   return NULL;
+}
+
+template <class VSC>
+static FP_SPEC_KERN_FUNC GetSpecKernSOP(int32_t msg)
+{
+   switch(GET_SOP_FLAG(msg))
+   {
+      case SOP_NOOP:
+      case SOP_COPY:
+         return GetSpecKernROP<SOP_SPEC<SOP_COPY>, VSC>(msg);
+      case SOP_UDEF:
+         return GetSpecKernROP<SOP_SPEC<SOP_UDEF>, VSC>(msg);
+   }
+   return NULL;
+}
+
+extern "C"
+FP_SPEC_KERN_FUNC GetSpecKern(int32_t imessage)
+{
+   switch(GET_VSC_FLAG(imessage))
+   {
+      case VSC_NOOP: /* scalar is not used, skip ROP and SOP */
+         return GetSpecKernVOP<ROP_SPEC<ROP_NOOP>, SOP_SPEC<SOP_COPY>, 
+                VSC_SPEC<VSC_NOOP> >(imessage);
+      case VSC_MUL:
+         return GetSpecKernSOP<VSC_SPEC<VSC_MUL> >(imessage);
+      case VSC_ADD:
+         return GetSpecKernSOP<VSC_SPEC<VSC_ADD> >(imessage);
+   }
+   return NULL;
+}
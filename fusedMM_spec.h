@@ -0,0 +1,400 @@
+#ifndef FUSEDMM_SPEC_H
+#define FUSEDMM_SPEC_H
+/*
+ * NOTE:
+ * C++ template engine for the general fusedMM. Each stage of the message is a
+ * functor and the edge loop is instantiated for each combination of the
+ * stages. Unlike the function pointer loop in fusedMM.c, the compiler can
+ * inline all the stages and fuse elementwise stages into a single loop
+ * without writing T back to memory.
+ *
+ * See fusedMM_spec.cpp for the dispatch table (GetSpecKern) which maps
+ * imessage to the instantiation.
+ *
+ * User defined functors:
+ *    UDEF slots of the dispatch table call the *_UDEF_FUNC of fusedMM.h.
+ *    C++ applications can instead include this header (after fusedMM.h and
+ *    fusedMM_internal.h) and instantiate fusedMM_spec_rows with their own 
+ *    functors which follow the format of the stage:
+ *       VOP: enum {EWISE=1}; static VALUETYPE op(VALUETYPE lhs, VALUETYPE rhs)
+ *       ROP: enum {EWISE=1, NOOP=0}; static VALUETYPE op(VALUETYPE lhs,
+ *                VALUETYPE t)    // terms are summed
+ *       SOP: static int op(VALUETYPE val, VALUETYPE *out)
+ *       VSC: enum {EWISE=1}; static VALUETYPE op(VALUETYPE scal, VALUETYPE t)
+ *       AOP: enum {EWISE=1}; static VALUETYPE op(VALUETYPE out, VALUETYPE t)
+ *    When EWISE=0, the functor must provide static int vec(...) with the same
+ *    arguments as the user defined function of the stage (without dims of
+ *    lhs/rhs/out), see *_SPEC<*_UDEF> below.
+ *    Example:
+ *       struct MySOP { static inline int op(VALUETYPE v, VALUETYPE *out)
+ *                      { *out = 1.0 - 1.0/(1.0+exp(-v)); return 0; } };
+ *       fusedMM_spec_csr(fusedMM_spec_rows<VOP_SPEC<VOP_COPY_RHS>, 
+ *          ROP_SPEC<ROP_DOT>, MySOP, VSC_SPEC<VSC_MUL>, AOP_SPEC<AOP_ADD> >,
+ *          m, k, val, indx, ...);
+ */
+#include <type_traits>
+
+/*============================================================================
+ *    VOP (Vector-vector operation)
+ *       format: T = lhs op rhs
+ *============================================================================*/
+template <class VOP>
+struct VOP_EWISE
+{
+   enum {EWISE = 1};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *lhs,
+         const VALUETYPE *rhs, VALUETYPE *out)
+   {
+      #pragma omp simd
+      for (INDEXTYPE i = 0; i < k; i++)
+         out[i] = VOP::op(lhs[i], rhs[i]);
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+};
+template <int32_t MSG> struct VOP_SPEC;
+
+template <> struct VOP_SPEC<VOP_COPY_LHS> : VOP_EWISE<VOP_SPEC<VOP_COPY_LHS> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return l; }
+};
+template <> struct VOP_SPEC<VOP_COPY_RHS> : VOP_EWISE<VOP_SPEC<VOP_COPY_RHS> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return r; }
+};
+template <> struct VOP_SPEC<VOP_ADD> : VOP_EWISE<VOP_SPEC<VOP_ADD> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return l + r; }
+};
+template <> struct VOP_SPEC<VOP_SUBL> : VOP_EWISE<VOP_SPEC<VOP_SUBL> >
+{
+   /* subtract lhs from rhs */
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return r - l; }
+};
+template <> struct VOP_SPEC<VOP_SUBR> : VOP_EWISE<VOP_SPEC<VOP_SUBR> >
+{
+   /* subtract rhs from lhs */
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return l - r; }
+};
+template <> struct VOP_SPEC<VOP_MAX> : VOP_EWISE<VOP_SPEC<VOP_MAX> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) {return l > r ? l : r;}
+};
+template <> struct VOP_SPEC<VOP_MIN> : VOP_EWISE<VOP_SPEC<VOP_MIN> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) {return l < r ? l : r;}
+};
+template <> struct VOP_SPEC<VOP_UDEF>
+{
+   enum {EWISE = 0};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *lhs,
+         const VALUETYPE *rhs, VALUETYPE *out)
+   {
+      return VOP_UDEF_FUNC(k, lhs, k, rhs, k, out);
+   }
+};
+
+/*============================================================================
+ *    ROP (Reduction operation): scal = sum of op(lhs[i], T[i])
+ *       NOTE: ROP_NOOP keeps scal = val of the nonzero
+ *============================================================================*/
+template <class ROP>
+struct ROP_EWISE
+{
+   enum {EWISE = 1, NOOP = 0};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *lhs,
+         const VALUETYPE *rhs, VALUETYPE *out)
+   {
+      VALUETYPE acc = 0.0;
+      #pragma omp simd reduction(+:acc)
+      for (INDEXTYPE i = 0; i < k; i++)
+         acc += ROP::op(lhs[i], rhs[i]);
+      *out = acc;
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+};
+template <int32_t MSG> struct ROP_SPEC;
+
+template <> struct ROP_SPEC<ROP_NOOP>
+{
+   enum {EWISE = 0, NOOP = 1};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *lhs,
+         const VALUETYPE *rhs, VALUETYPE *out)
+   {
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+};
+template <> struct ROP_SPEC<ROP_DOT> : ROP_EWISE<ROP_SPEC<ROP_DOT> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return l * r; }
+};
+template <> struct ROP_SPEC<ROP_ADD_LHS> : ROP_EWISE<ROP_SPEC<ROP_ADD_LHS> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return l; }
+};
+template <> struct ROP_SPEC<ROP_ADD_RHS> : ROP_EWISE<ROP_SPEC<ROP_ADD_RHS> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return r; }
+};
+template <> struct ROP_SPEC<ROP_NORML> : ROP_EWISE<ROP_SPEC<ROP_NORML> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return l * l; }
+};
+template <> struct ROP_SPEC<ROP_NORMR> : ROP_EWISE<ROP_SPEC<ROP_NORMR> >
+{
+   static inline VALUETYPE op(VALUETYPE l, VALUETYPE r) { return r * r; }
+};
+template <> struct ROP_SPEC<ROP_UDEF>
+{
+   enum {EWISE = 0, NOOP = 0};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *lhs,
+         const VALUETYPE *rhs, VALUETYPE *out)
+   {
+      return ROP_UDEF_FUNC(k, lhs, k, rhs, out);
+   }
+};
+
+/*============================================================================
+ *    SOP (Scalar operation)
+ *       NOTE: SOP_NOOP passes the scalar through
+ *============================================================================*/
+template <int32_t MSG> struct SOP_SPEC;
+
+template <> struct SOP_SPEC<SOP_NOOP>
+{
+   static inline int op(VALUETYPE val, VALUETYPE *out)
+   {
+      *out = val;
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+};
+template <> struct SOP_SPEC<SOP_COPY>
+{
+   static inline int op(VALUETYPE val, VALUETYPE *out)
+   {
+      *out = val;
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+};
+template <> struct SOP_SPEC<SOP_UDEF>
+{
+   static inline int op(VALUETYPE val, VALUETYPE *out)
+   {
+      return SOP_UDEF_FUNC(val, out);
+   }
+};
+
+/*============================================================================
+ *    VSC (Vector scaling): T = scal op T
+ *============================================================================*/
+template <class VSC>
+struct VSC_EWISE
+{
+   enum {EWISE = 1};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *rhs, VALUETYPE scal,
+         VALUETYPE *out)
+   {
+      #pragma omp simd
+      for (INDEXTYPE i = 0; i < k; i++)
+         out[i] = VSC::op(scal, rhs[i]);
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+};
+template <int32_t MSG> struct VSC_SPEC;
+
+template <> struct VSC_SPEC<VSC_NOOP> : VSC_EWISE<VSC_SPEC<VSC_NOOP> >
+{
+   static inline VALUETYPE op(VALUETYPE s, VALUETYPE r) { return r; }
+};
+template <> struct VSC_SPEC<VSC_MUL> : VSC_EWISE<VSC_SPEC<VSC_MUL> >
+{
+   static inline VALUETYPE op(VALUETYPE s, VALUETYPE r) { return s * r; }
+};
+template <> struct VSC_SPEC<VSC_ADD> : VSC_EWISE<VSC_SPEC<VSC_ADD> >
+{
+   static inline VALUETYPE op(VALUETYPE s, VALUETYPE r) { return s + r; }
+};
+template <> struct VSC_SPEC<VSC_UDEF>
+{
+   enum {EWISE = 0};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *rhs, VALUETYPE scal,
+         VALUETYPE *out)
+   {
+      return VSC_UDEF_FUNC(k, rhs, scal, k, out);
+   }
+};
+
+/*============================================================================
+ *    AOP (Accumulate operation): Z = Z op T
+ *============================================================================*/
+template <class AOP>
+struct AOP_EWISE
+{
+   enum {EWISE = 1};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *rhs, VALUETYPE *out)
+   {
+      #pragma omp simd
+      for (INDEXTYPE i = 0; i < k; i++)
+         out[i] = AOP::op(out[i], rhs[i]);
+      return FUSEDMM_SUCCESS_RETURN;
+   }
+};
+template <int32_t MSG> struct AOP_SPEC;
+
+template <> struct AOP_SPEC<AOP_NOOP> : AOP_EWISE<AOP_SPEC<AOP_NOOP> >
+{
+   static inline VALUETYPE op(VALUETYPE o, VALUETYPE r) { return o; }
+};
+template <> struct AOP_SPEC<AOP_ADD> : AOP_EWISE<AOP_SPEC<AOP_ADD> >
+{
+   static inline VALUETYPE op(VALUETYPE o, VALUETYPE r) { return o + r; }
+};
+template <> struct AOP_SPEC<AOP_MAX> : AOP_EWISE<AOP_SPEC<AOP_MAX> >
+{
+   static inline VALUETYPE op(VALUETYPE o, VALUETYPE r) {return o > r ? o : r;}
+};
+template <> struct AOP_SPEC<AOP_MIN> : AOP_EWISE<AOP_SPEC<AOP_MIN> >
+{
+   static inline VALUETYPE op(VALUETYPE o, VALUETYPE r) {return o < r ? o : r;}
+};
+template <> struct AOP_SPEC<AOP_UDEF>
+{
+   enum {EWISE = 0};
+   static inline int vec(INDEXTYPE k, const VALUETYPE *rhs, VALUETYPE *out)
+   {
+      return AOP_UDEF_FUNC(k, rhs, k, out);
+   }
+};
+
+/*============================================================================
+ *    Fused edge:
+ *       Each phase is fused into a single loop when all of its stages are
+ *       elementwise (selected at compile time by tag dispatch), otherwise
+ *       the stages are applied one after another through T
+ *============================================================================*/
+/*
+ * phase 1: T = VOP(lhs, rhs); scal = ROP(lhs, T)
+ */
+template <class VOP, class ROP>
+static inline int fusedMM_spec_vrop(std::true_type, INDEXTYPE k,
+      const VALUETYPE *lhs, const VALUETYPE *rhs, VALUETYPE *T,
+      VALUETYPE *scal)
+{
+   VALUETYPE acc = 0.0;
+   #pragma omp simd reduction(+:acc)
+   for (INDEXTYPE i = 0; i < k; i++)
+   {
+      VALUETYPE t = VOP::op(lhs[i], rhs[i]);
+      T[i] = t;
+      acc += ROP::op(lhs[i], t);
+   }
+   *scal = acc;
+   return FUSEDMM_SUCCESS_RETURN;
+}
+template <class VOP, class ROP>
+static inline int fusedMM_spec_vrop(std::false_type, INDEXTYPE k,
+      const VALUETYPE *lhs, const VALUETYPE *rhs, VALUETYPE *T,
+      VALUETYPE *scal)
+{
+   int status;
+   status = VOP::vec(k, lhs, rhs, T);
+   status += ROP::vec(k, lhs, T, scal);
+   return status;
+}
+/*
+ * phase 2: Z = AOP(Z, VSC(scal, T))
+ */
+template <class VSC, class AOP>
+static inline int fusedMM_spec_vsaop(std::true_type, INDEXTYPE k,
+      VALUETYPE scal, VALUETYPE *T, VALUETYPE *O)
+{
+   #pragma omp simd
+   for (INDEXTYPE i = 0; i < k; i++)
+      O[i] = AOP::op(O[i], VSC::op(scal, T[i]));
+   return FUSEDMM_SUCCESS_RETURN;
+}
+template <class VSC, class AOP>
+static inline int fusedMM_spec_vsaop(std::false_type, INDEXTYPE k,
+      VALUETYPE scal, VALUETYPE *T, VALUETYPE *O)
+{
+   int status;
+   status = VSC::vec(k, T, scal, T);
+   status += AOP::vec(k, T, O);
+   return status;
+}
+/*
+ * all stages are elementwise and no reduction: no need of T at all
+ */
+template <class VOP, class ROP, class SOP, class VSC, class AOP>
+static inline int fusedMM_spec_edge(std::true_type, INDEXTYPE k,
+      const VALUETYPE *lhs, const VALUETYPE *rhs, VALUETYPE val, VALUETYPE *T,
+      VALUETYPE *O)
+{
+   int status;
+   VALUETYPE out;
+
+   status = SOP::op(val, &out);
+   #pragma omp simd
+   for (INDEXTYPE i = 0; i < k; i++)
+      O[i] = AOP::op(O[i], VSC::op(out, VOP::op(lhs[i], rhs[i])));
+   return status;
+}
+template <class VOP, class ROP, class SOP, class VSC, class AOP>
+static inline int fusedMM_spec_edge(std::false_type, INDEXTYPE k,
+      const VALUETYPE *lhs, const VALUETYPE *rhs, VALUETYPE val, VALUETYPE *T,
+      VALUETYPE *O)
+{
+   int status;
+   VALUETYPE scal, out;
+
+   scal = val; /* overwritten when ROP is used */
+   status = fusedMM_spec_vrop<VOP, ROP>(
+         std::integral_constant<bool, VOP::EWISE && ROP::EWISE>(),
+         k, lhs, rhs, T, &scal);
+   status += SOP::op(scal, &out);
+   status += fusedMM_spec_vsaop<VSC, AOP>(
+         std::integral_constant<bool, VSC::EWISE && AOP::EWISE>(),
+         k, out, T, O);
+   return status;
+}
+
+/*============================================================================
+ *    General fusedMM specialized for the stages: rows rowb to rowe-1
+ *       T: scratch space of k elements
+ *       NOTE: only the edge loop is instantiated, the parallel driver is 
+ *       fusedMM_spec_csr in fusedMM.c 
+ *============================================================================*/
+template <class VOP, class ROP, class SOP, class VSC, class AOP>
+int fusedMM_spec_rows
+(
+   const INDEXTYPE rowb,      // first row  
+   const INDEXTYPE rowe,      // last row + 1 
+   const INDEXTYPE k,         // dimension (col of X or Y)
+   const VALUETYPE *val,      // value of non-zeros
+   const COLINDEXTYPE *indx,  // colids -> column indices
+   const INDEXTYPE *pntrb,    // starting of rowptr for each row
+   const INDEXTYPE *pntre,    // ending of rowptr for each row
+   const VALUETYPE *x,        // Dense X matrix
+   const INDEXTYPE ldx,       // 1eading dimension of X
+   const VALUETYPE *y,        // Dense Y matrix
+   const INDEXTYPE ldy,       // leading dimension of Y
+   VALUETYPE *z,              // Dense matrix Z
+   const INDEXTYPE ldz,       // leading dimension size of z
+   VALUETYPE *T               // scratch space 
+)
+{
+   int status = 0;
+   typedef std::integral_constant<bool, VOP::EWISE && ROP::NOOP && VSC::EWISE
+      && AOP::EWISE> FUSE_ALL;
+
+   for (INDEXTYPE i = rowb; i < rowe; i++)
+   {
+      const VALUETYPE *lhs = x + i * ldx; // Xi
+      VALUETYPE *O = z + i * ldz;  // Zi
+      for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+         status += fusedMM_spec_edge<VOP, ROP, SOP, VSC, AOP>(FUSE_ALL(), k,
+               lhs, y + indx[j] * ldy, val[j], T, O);
+   }
+   return status;
+}
+
+#endif /* end of FUSEDMM_SPEC_H */
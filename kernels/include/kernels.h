@@ -3,6 +3,8 @@
 /*
  * Header file for API 
  */
+#include<stdint.h>
+#include<string.h>
 
 #ifdef __cplusplus 
    extern "C"
@@ -12,36 +14,406 @@
  * NOTE: You need to define INDEXTYPE as your appropriate int type, the kernel
  * implementation does not depend on int type 
  */
+/*
+ * COLINDEXTYPE is the type of column indices (indx) of the sparse matrix, 
+ * INDEXTYPE when not defined. A 32-bit type (e.g., uint32_t) with 64-bit 
+ * INDEXTYPE halves the index traffic of matrices with less than 2^32 columns 
+ * but more nonzeros than INDEXTYPE=int32_t can count 
+ */
+#ifndef COLINDEXTYPE
+   #define COLINDEXTYPE INDEXTYPE
+#endif
+
+/*
+ * function pointer type of kernels, same prototype for generated and trusted 
+ * kernels 
+ * rows of the sparse matrix are split in npart partitions, partition t has 
+ * rows rowb[t] to rowb[t+1]-1 and is computed by one thread. When rowb is 
+ * NULL, rows are scheduled by openmp among npart threads (0: default number 
+ * of threads of openmp). Kernels never change the number of threads of the 
+ * application (omp_set_num_threads) 
+ */
+typedef void (*kern_dgfusedMM_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const double alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const double *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const double *A, const INDEXTYPE lda, 
+      const double *B, const INDEXTYPE ldb, const double beta, double *C, 
+      const INDEXTYPE ldc, const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+typedef void (*kern_sgfusedMM_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const float *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const float *A, const INDEXTYPE lda, 
+      const float *B, const INDEXTYPE ldb, const float beta, float *C, 
+      const INDEXTYPE ldc, const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+/*
+ * Compressed column indices (vbidx) for rows with sorted column indices: 
+ * colids of a row are delta encoded (first one from 0) with a byte width per 
+ * row. Row i starts at byte cidx + cptr[i] with a header byte, low nibble: 
+ * bytes of the first colid, high nibble: bytes of each following delta (1 to 
+ * 8, little endian). Empty rows have no bytes. Decoding needs no branch: a 
+ * delta is an unaligned 8-byte load masked to its width, stream is padded by 
+ * VBIDX_PAD bytes for it. Row i still has nonzeros pntrb[i] to pntre[i]-1, 
+ * values are not compressed. Used by spmm and gcn kernels ('m' and 'g') only, 
+ * see fusedMM_plan_opts_t in fusedMM.h 
+ */
+#define VBIDX_PAD 8
+#define VBIDX_MASK(nb_) \
+   ((nb_) >= 8 ? ~(uint64_t)0 : ((uint64_t)1 << ((nb_) << 3)) - 1)
+/* decoding state of a row */
+typedef struct vbidx_cur 
+{
+   const uint8_t *p;          /* next delta */
+   uint64_t msk, mskd;        /* mask of next delta and of following deltas */
+   int nb, nbd;               /* bytes of next delta and of following deltas */
+} vbidx_cur_t;
+static inline uint64_t vbidx_load(const uint8_t *p)
+{
+   uint64_t v; 
+   memcpy(&v, p, sizeof(v));  /* unaligned load */
+   return v; 
+}
+#define VBIDX_ROW(s_, p_) /* starts row of stream p_ in state s_ */ \
+{ \
+   const int h_ = *(p_); \
+   (s_).p = (p_) + 1; \
+   (s_).nb = h_ & 0xF; \
+   (s_).nbd = h_ >> 4; \
+   (s_).msk = VBIDX_MASK((s_).nb); \
+   (s_).mskd = VBIDX_MASK((s_).nbd); \
+}
+#define VBIDX_NEXT(s_, c_) /* adds next delta of row state s_ to colid c_ */ \
+{ \
+   (c_) += (INDEXTYPE) (vbidx_load((s_).p) & (s_).msk); \
+   (s_).p += (s_).nb; \
+   (s_).msk = (s_).mskd; \
+   (s_).nb = (s_).nbd; \
+}
+
+typedef void (*kern_dgfusedMM_vb_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const double alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const double *val, const uint8_t *cidx, const INDEXTYPE *cptr, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const double *A, 
+      const INDEXTYPE lda, const double *B, const INDEXTYPE ldb, 
+      const double beta, double *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+typedef void (*kern_sgfusedMM_vb_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const float *val, const uint8_t *cidx, const INDEXTYPE *cptr, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const float *A, 
+      const INDEXTYPE lda, const float *B, const INDEXTYPE ldb, 
+      const float beta, float *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+/*
+ * SELL-C-sigma storage of the sparse matrix: rows are packed in chunks of
+ * SELL_C rows, chunk c stores its nonzeros column-major from cptr[c]:
+ * nonzero j of row r of the chunk is at cptr[c] + j*SELL_C + r. Rows shorter
+ * than the longest row of the chunk are padded with value 0 and a valid colid.
+ * Row r (in SELL order) has rlen[r] nonzeros and is row perm[r] of C, rows
+ * with perm[r] < 0 pad the last chunk. The kernels run the rows of a chunk
+ * in lock-step (spmm and gcn, 'm' and 'g'), rowb partitions the chunks.
+ * see fusedMM_csr2sell in fusedMM.h
+ */
+#define SELL_C 8
+
+typedef void (*kern_dgfusedMM_sell_t) (const char tkern, const INDEXTYPE m,
+      const INDEXTYPE n, const INDEXTYPE k,const double alpha,
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols,
+      const double *val, const COLINDEXTYPE *indx, const INDEXTYPE *cptr,
+      const INDEXTYPE *rlen, const INDEXTYPE *perm, const double *A,
+      const INDEXTYPE lda, const double *B, const INDEXTYPE ldb,
+      const double beta, double *C, const INDEXTYPE ldc,
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+typedef void (*kern_sgfusedMM_sell_t) (const char tkern, const INDEXTYPE m,
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha,
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols,
+      const float *val, const COLINDEXTYPE *indx, const INDEXTYPE *cptr,
+      const INDEXTYPE *rlen, const INDEXTYPE *perm, const float *A,
+      const INDEXTYPE lda, const float *B, const INDEXTYPE ldb,
+      const float beta, float *C, const INDEXTYPE ldc,
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+/*
+ * Multi-head kernels (sigmoid and tdist, 't' and 's'): k is split in nhead 
+ * heads of k/nhead consecutive elements. ROP gives a scalar per head of an 
+ * edge, SOP is applied to each of them and VSC scales each head of the row of
+ * B with its own scalar. Heads are register blocked: k is the dimension of a 
+ * generated kernel and a head is a power of 2 vectors 
+ */
+typedef void (*kern_dgfusedMM_mh_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k, const INDEXTYPE nhead, 
+      const double alpha, const INDEXTYPE nnz, const INDEXTYPE rows, 
+      const INDEXTYPE cols, const double *val, const COLINDEXTYPE *indx, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const double *A, 
+      const INDEXTYPE lda, const double *B, const INDEXTYPE ldb, 
+      const double beta, double *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+typedef void (*kern_sgfusedMM_mh_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k, const INDEXTYPE nhead, 
+      const float alpha, const INDEXTYPE nnz, const INDEXTYPE rows, 
+      const INDEXTYPE cols, const float *val, const COLINDEXTYPE *indx, 
+      const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const float *A, 
+      const INDEXTYPE lda, const float *B, const INDEXTYPE ldb, 
+      const float beta, float *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+/*
+ * Kernels with per-edge output (sigmoid and tdist, 't' and 's'): the scalar 
+ * of nonzero j after SOP is stored at eout[j] in the same pass as the update 
+ * of C. SDDMM kernels stop after SOP: C, alpha and beta are not accessed 
+ */
+typedef void (*kern_dgfusedMM_edge_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const double alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const double *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const double *A, const INDEXTYPE lda, 
+      const double *B, const INDEXTYPE ldb, const double beta, double *C, 
+      const INDEXTYPE ldc, double *eout, const INDEXTYPE npart, 
+      const INDEXTYPE *rowb);
+
+typedef void (*kern_sgfusedMM_edge_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const float *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const float *A, const INDEXTYPE lda, 
+      const float *B, const INDEXTYPE ldb, const float beta, float *C, 
+      const INDEXTYPE ldc, float *eout, const INDEXTYPE npart, 
+      const INDEXTYPE *rowb);
+
+/*
+ * Normalized gcn kernels ('g'): row j of B is scaled by cs[j] and the sum of 
+ * row i by rs[i] before alpha and beta are applied, NULL: no scaling. 
+ * e.g., rs = cs = D^-1/2 for the symmetric normalization, val is not read
+ */
+typedef void (*kern_dgfusedMM_norm_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const double alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const double *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const double *A, const INDEXTYPE lda, 
+      const double *B, const INDEXTYPE ldb, const double beta, double *C, 
+      const INDEXTYPE ldc, const double *rs, const double *cs, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+typedef void (*kern_sgfusedMM_norm_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const float *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const float *A, const INDEXTYPE lda, 
+      const float *B, const INDEXTYPE ldb, const float beta, float *C, 
+      const INDEXTYPE ldc, const float *rs, const float *cs, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+/*
+ * max and min aggregation kernels ('x' and 'n') with arg output: arg[i*ldc+kk]
+ * is the nonzero of row i whose row of B gave C[i*ldc+kk], -1 when it comes 
+ * from beta * C or row i has no edges. C = max(alpha * max_j Bj, beta * C), 
+ * ties keep the first nonzero and C wins ties with the edges 
+ */
+typedef void (*kern_dgfusedMM_arg_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const double alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const double *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const double *A, const INDEXTYPE lda, 
+      const double *B, const INDEXTYPE ldb, const double beta, double *C, 
+      const INDEXTYPE ldc, INDEXTYPE *arg, const INDEXTYPE npart, 
+      const INDEXTYPE *rowb);
+
+typedef void (*kern_sgfusedMM_arg_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const float *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const float *A, const INDEXTYPE lda, 
+      const float *B, const INDEXTYPE ldb, const float beta, float *C, 
+      const INDEXTYPE ldc, INDEXTYPE *arg, const INDEXTYPE npart, 
+      const INDEXTYPE *rowb);
+
+/*
+ * Half precision storage of A and B (X and Y) for single precision kernels: 
+ * rows are bf16 (dtype 1: upper half of fp32) or fp16 (dtype 2: IEEE half) 
+ * and converted to fp32 when loaded, products are accumulated in fp32 and C 
+ * is fp32. Generated for spmm, gcn and sigmoid ('m', 'g' and 's'), see 
+ * fusedMM_csr_half in fusedMM.h 
+ */
+#define KERN_BF16 1
+#define KERN_FP16 2
+static inline float bf16_to_fp32(const uint16_t h)
+{
+   const uint32_t u = (uint32_t) h << 16; 
+   float f; 
+   memcpy(&f, &u, sizeof(f));
+   return f; 
+}
+static inline float fp16_to_fp32(const uint16_t h)
+{
+   const uint32_t s = (uint32_t) (h & 0x8000) << 16; 
+   uint32_t e = (h >> 10) & 0x1F, mt = h & 0x3FF, u; 
+   float f; 
+
+   if (e == 0x1F) /* inf and nan */
+      u = s | 0x7F800000 | (mt << 13); 
+   else if (e) 
+      u = s | ((e + 112) << 23) | (mt << 13); 
+   else if (!mt) /* zero */
+      u = s; 
+   else /* subnormal, normalized in fp32 */
+   {
+      for (e = 113; !(mt & 0x400); e--)
+         mt <<= 1; 
+      u = s | (e << 23) | ((mt & 0x3FF) << 13); 
+   }
+   memcpy(&f, &u, sizeof(f));
+   return f; 
+}
+
+typedef void (*kern_sgfusedMM_half_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const float *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const uint16_t *A, const INDEXTYPE lda, 
+      const uint16_t *B, const INDEXTYPE ldb, const float beta, float *C, 
+      const INDEXTYPE ldc, const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+/*
+ * int8 storage of B (Y) for single precision kernels: row j of B is 
+ * bq[2*j] * (q - bq[2*j+1]) with q the int8 elements of the row. Rows are 
+ * converted to fp32 when loaded, A and C are fp32. Generated for spmm, gcn 
+ * and sigmoid, see fusedMM_csr_i8 in fusedMM.h 
+ */
+typedef void (*kern_sgfusedMM_i8_t) (const char tkern, const INDEXTYPE m, 
+      const INDEXTYPE n, const INDEXTYPE k,const float alpha, 
+      const INDEXTYPE nnz, const INDEXTYPE rows, const INDEXTYPE cols, 
+      const float *val, const COLINDEXTYPE *indx, const INDEXTYPE *pntrb, 
+      const INDEXTYPE *pntre, const float *A, const INDEXTYPE lda, 
+      const int8_t *B, const INDEXTYPE ldb, const float *bq, 
+      const float beta, float *C, const INDEXTYPE ldc, const INDEXTYPE npart, 
+      const INDEXTYPE *rowb);
 
 /* double precision function prototypes  */
 void dgfusedMM_csr (const char tkern, const INDEXTYPE m, const INDEXTYPE n, 
       const INDEXTYPE k,const double alpha, const INDEXTYPE nnz, 
-      const INDEXTYPE rows, const INDEXTYPE cols, const double *val, const INDEXTYPE *indx, 
+      const INDEXTYPE rows, const INDEXTYPE cols, const double *val, const COLINDEXTYPE *indx, 
       const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const double *A, 
       const INDEXTYPE lda, const double *B, const INDEXTYPE ldb, 
-      const double beta, double *C, const INDEXTYPE ldc);
+      const double beta, double *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+/*
+ * returns the kernel which dgfusedMM_csr would call for tkern, k, alpha and 
+ * beta. Useful to select the kernel once and call it many times. Kernel 
+ * selected for alpha = 1 and beta = 0 or 1 ignores alpha and beta, any other 
+ * value selects the kernel which computes C = alpha * func + beta * C, or
+ * C = max(alpha * func, beta * C) for max and min ('x' and 'n', min alike).
+ * returns NULL for unknown tkern
+ */
+kern_dgfusedMM_t dgfusedMM_csr_getkern (const char tkern, const INDEXTYPE k, 
+      const double alpha, const double beta);
+/*
+ * same as dgfusedMM_csr_getkern for compressed column indices (vbidx), returns
+ * NULL for tkern other than 'm' and 'g' 
+ */
+kern_dgfusedMM_vb_t dgfusedMM_vbcsr_getkern (const char tkern, 
+      const INDEXTYPE k, const double alpha, const double beta);
+/*
+ * same for SELL-C-sigma, returns NULL for tkern other than 'm' and 'g' and 
+ * when k is wider than a vector (MAXDIM_SELL_SPMM): the rows of a chunk would 
+ * not keep their accumulators in registers 
+ */
+kern_dgfusedMM_sell_t dgfusedMM_sell_getkern (const char tkern, 
+      const INDEXTYPE k, const double alpha, const double beta);
+/*
+ * same for multi-head kernels, returns NULL for tkern other than 't' and 's'
+ * and when k and nhead have no register blocked kernel 
+ */
+kern_dgfusedMM_mh_t dgfusedMM_mh_getkern (const char tkern, 
+      const INDEXTYPE k, const INDEXTYPE nhead, const double alpha, 
+      const double beta);
+/*
+ * same for kernels with per-edge output, sddmm = 1 selects the SDDMM kernel. 
+ * returns NULL for tkern other than 't' and 's' and when there is no 
+ * generated kernel for k 
+ */
+kern_dgfusedMM_edge_t dgfusedMM_edge_getkern (const char tkern, 
+      const INDEXTYPE k, const double alpha, const double beta, 
+      const int sddmm);
+/*
+ * same for normalized gcn kernels, returns NULL for tkern other than 'g' and 
+ * when there is no generated kernel for k 
+ */
+kern_dgfusedMM_norm_t dgfusedMM_norm_getkern (const char tkern, 
+      const INDEXTYPE k, const double alpha, const double beta);
+/*
+ * same for max and min kernels with arg output, maxdeg is the max nonzeros 
+ * of a row: generated kernels keep the offset of the edge in the row in the 
+ * lanes of a vector, the trusted kernel is returned when it's not exact 
+ * (maxdeg > 2^53 in double, 2^24 in single) or there is no generated kernel 
+ * for k. returns NULL for tkern other than 'x' and 'n' 
+ */
+kern_dgfusedMM_arg_t dgfusedMM_arg_getkern (const char tkern, 
+      const INDEXTYPE k, const double alpha, const double beta, 
+      const INDEXTYPE maxdeg);
 
 void trusted_dgfusedMM_csr (const char tkern, const INDEXTYPE m, const INDEXTYPE n, 
       const INDEXTYPE k,const double alpha, const INDEXTYPE nnz, 
-      const INDEXTYPE rows, const INDEXTYPE cols, const double *val, const INDEXTYPE *indx, 
+      const INDEXTYPE rows, const INDEXTYPE cols, const double *val, const COLINDEXTYPE *indx, 
       const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const double *A, 
       const INDEXTYPE lda, const double *B, const INDEXTYPE ldb, 
-      const double beta, double *C, const INDEXTYPE ldc);
+      const double beta, double *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
 
 /* single precision function prototypes  */
 void sgfusedMM_csr (const char tkern, const INDEXTYPE m, const INDEXTYPE n, 
       const INDEXTYPE k,const float alpha, const INDEXTYPE nnz, 
-      const INDEXTYPE rows, const INDEXTYPE cols, const float *val, const INDEXTYPE *indx, 
+      const INDEXTYPE rows, const INDEXTYPE cols, const float *val, const COLINDEXTYPE *indx, 
       const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const float *A, 
       const INDEXTYPE lda, const float *B, const INDEXTYPE ldb, 
-      const float beta, float *C, const INDEXTYPE ldc);
+      const float beta, float *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
+
+kern_sgfusedMM_t sgfusedMM_csr_getkern (const char tkern, const INDEXTYPE k, 
+      const float alpha, const float beta);
+kern_sgfusedMM_vb_t sgfusedMM_vbcsr_getkern (const char tkern, 
+      const INDEXTYPE k, const float alpha, const float beta);
+kern_sgfusedMM_sell_t sgfusedMM_sell_getkern (const char tkern, 
+      const INDEXTYPE k, const float alpha, const float beta);
+kern_sgfusedMM_mh_t sgfusedMM_mh_getkern (const char tkern, 
+      const INDEXTYPE k, const INDEXTYPE nhead, const float alpha, 
+      const float beta);
+kern_sgfusedMM_edge_t sgfusedMM_edge_getkern (const char tkern, 
+      const INDEXTYPE k, const float alpha, const float beta, 
+      const int sddmm);
+kern_sgfusedMM_norm_t sgfusedMM_norm_getkern (const char tkern, 
+      const INDEXTYPE k, const float alpha, const float beta);
+kern_sgfusedMM_arg_t sgfusedMM_arg_getkern (const char tkern, 
+      const INDEXTYPE k, const float alpha, const float beta, 
+      const INDEXTYPE maxdeg);
+/*
+ * same selection for half precision A and B, dtype: KERN_BF16 or KERN_FP16. 
+ * returns NULL when there is no generated kernel for tkern and k 
+ */
+kern_sgfusedMM_half_t sgfusedMM_half_getkern (const int dtype, 
+      const char tkern, const INDEXTYPE k, const float alpha, const float beta);
+/*
+ * same selection for int8 B, returns NULL when there is no generated kernel 
+ */
+kern_sgfusedMM_i8_t sgfusedMM_i8_getkern (const char tkern, const INDEXTYPE k, 
+      const float alpha, const float beta);
 
 void trusted_sgfusedMM_csr (const char tkern, const INDEXTYPE m, const INDEXTYPE n, 
       const INDEXTYPE k,const float alpha, const INDEXTYPE nnz, 
-      const INDEXTYPE rows, const INDEXTYPE cols, const float *val, const INDEXTYPE *indx, 
+      const INDEXTYPE rows, const INDEXTYPE cols, const float *val, const COLINDEXTYPE *indx, 
       const INDEXTYPE *pntrb, const INDEXTYPE *pntre, const float *A, 
       const INDEXTYPE lda, const float *B, const INDEXTYPE ldb, 
-      const float beta, float *C, const INDEXTYPE ldc);
+      const float beta, float *C, const INDEXTYPE ldc, 
+      const INDEXTYPE npart, const INDEXTYPE *rowb);
 
 #ifdef __cplusplus 
    }  // extern "C"
@@ -14,12 +14,32 @@
 #ifndef BLC_ARCH
 #define BLC_X86   
    /*#define BLC_AVXZ*/ 
-   #define BLC_AVX2
+   /*#define BLC_AVX2*/
    /* #define BLC_AVX */
    /*#define BLC_SSE4_2*/
    /* #define BLC_SSE4_1 */
    /* #define BLC_SSE3 */
    /* #define BLC_SSE1 */
+#endif
+/*
+ * SIMD unit is not set (e.g., sources outside the kernel generator compiled 
+ * with -march=native): figure it out from the target flags of the compiler 
+ */
+#if defined(BLC_X86) && !defined(BLC_AVXZ) && !defined(BLC_AVX512) \
+   && !defined(BLC_AVX2) && !defined(BLC_AVXMAC) && !defined(BLC_AVX) \
+   && !defined(BLC_SSE4_2) && !defined(BLC_SSE4_1) && !defined(BLC_SSE3) \
+   && !defined(BLC_SSE2) && !defined(BLC_SSE1)
+   #if defined(__AVX512F__) && defined(__AVX512DQ__)
+      #define BLC_AVXZ
+   #elif defined(__AVX2__) && defined(__FMA__)
+      #define BLC_AVX2
+   #elif defined(__AVX__)
+      #define BLC_AVX
+   #elif defined(__SSE2__)
+      #define BLC_SSE2
+   #else
+      #define BLC_SSE1
+   #endif
 #endif
  /*
   *   inst format: inst(dist, src1, src2)
@@ -51,6 +71,8 @@
          #define BCL_vmac(d_, s1_, s2_) d_ = _mm512_fmadd_pd(s1_, s2_, d_)
          #define BCL_vmax(d_, s1_, s2_) d_ = _mm512_max_pd(s1_, s2_)
          #define BCL_vmin(d_, s1_, s2_) d_ = _mm512_min_pd(s1_, s2_)
+         #define BCL_vselgt(d_, s1_, s2_, t_, f_) d_ = _mm512_mask_blend_pd( \
+            _mm512_cmp_pd_mask(s1_, s2_, _CMP_GT_OQ), f_, t_)
          #define BCL_vrcp(d_, s1_) d_ = _mm512_rcp14_pd(s1_); // reciprocal 
          #define BCL_maskz_vrcp(d_, k_, s_) d_ = _mm512_rcp14_pd(k_, s_); // reciprocal 
          #define BCL_imaskz_vrcp(d_, ik_, s_) \
@@ -58,6 +80,11 @@
             d_ = _mm512_maskz_rcp14_pd(k0_, s_);\
          }
          #define BCL_cvtint2mask(k_, ik) k_ = _cvtu32_mask8(ik_) 
+         /* mask of first n_ (< VLEN) elements, used for the remainder loop */
+         #define MTYPE __mmask8
+         #define BCL_tailmask(k_, n_) k_ = (__mmask8)((1U << (n_)) - 1)
+         #define BCL_maskz_vldu(v_, k_, p_) v_ = _mm512_maskz_loadu_pd(k_, p_)
+         #define BCL_mask_vstu(p_, k_, v_) _mm512_mask_storeu_pd(p_, k_, v_)
 /*
  *       VVRSUM codes from ATLAS 
  */
@@ -91,12 +118,76 @@
          #define BCL_vmac(d_, s1_, s2_) d_ = _mm512_fmadd_ps(s1_, s2_, d_)
          #define BCL_vmax(d_, s1_, s2_) d_ = _mm512_max_ps(s1_, s2_)
          #define BCL_vmin(d_, s1_, s2_) d_ = _mm512_min_ps(s1_, s2_)
+         #define BCL_vselgt(d_, s1_, s2_, t_, f_) d_ = _mm512_mask_blend_ps( \
+            _mm512_cmp_ps_mask(s1_, s2_, _CMP_GT_OQ), f_, t_)
          #define BCL_vrcp(d_, s1_) d_ = _mm512_rcp14_ps(s1_); /* reciprocal */
          #define BCL_maskz_vrcp(d_, k_, s_) d_ = _mm512_maskz_rcp14_ps(k_, s_); 
          #define BCL_imaskz_vrcp(d_, ik_, s_) \
          {  __mmask8 k0_ = _cvtu32_mask8(ik_); \
             d_ = _mm512_maskz_rcp14_ps(k0_, s_);\
          }
+         /* mask of first n_ (< VLEN) elements, used for the remainder loop */
+         #define MTYPE __mmask16
+         #define BCL_tailmask(k_, n_) k_ = (__mmask16)((1U << (n_)) - 1)
+         #define BCL_maskz_vldu(v_, k_, p_) v_ = _mm512_maskz_loadu_ps(k_, p_)
+         #define BCL_mask_vstu(p_, k_, v_) _mm512_mask_storeu_ps(p_, k_, v_)
+         /* 
+          * half precision storage: VLEN bf16 (upper half of fp32) or fp16 
+          * elements at p_ converted to fp32 
+          */
+         #define BCL_vldu_bf16(v_, p_) \
+            v_ = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(\
+                 _mm256_loadu_si256((const __m256i*)(p_))), 16))
+         #define BCL_vldu_f16(v_, p_) \
+            v_ = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)(p_)))
+         #if defined(__AVX512BW__) && defined(__AVX512VL__)
+            #define BCL_HALF_MASK /* masked half loads with MTYPE */
+            #define BCL_maskz_vldu_bf16(v_, k_, p_) \
+               v_ = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(\
+                    _mm256_maskz_loadu_epi16(k_, p_)), 16))
+            #define BCL_maskz_vldu_f16(v_, k_, p_) \
+               v_ = _mm512_cvtph_ps(_mm256_maskz_loadu_epi16(k_, p_))
+         #else /* partial tail (lower bits of k_) through zero filled buffer */
+            #define BCL_HALF_MASK
+            #define BCL_maskz_vldu_bf16(v_, k_, p_) \
+            {  if ((k_) == 0xFFFF) \
+                  BCL_vldu_bf16(v_, p_); \
+               else \
+               {  uint16_t bcl_h_[16] = {0}; \
+                  memcpy(bcl_h_, p_, __builtin_popcount(k_)*sizeof(uint16_t));\
+                  BCL_vldu_bf16(v_, bcl_h_); \
+               } \
+            }
+            #define BCL_maskz_vldu_f16(v_, k_, p_) \
+            {  if ((k_) == 0xFFFF) \
+                  BCL_vldu_f16(v_, p_); \
+               else \
+               {  uint16_t bcl_h_[16] = {0}; \
+                  memcpy(bcl_h_, p_, __builtin_popcount(k_)*sizeof(uint16_t));\
+                  BCL_vldu_f16(v_, bcl_h_); \
+               } \
+            }
+         #endif
+         /* int8 storage: VLEN signed bytes at p_ converted to fp32 */
+         #define BCL_vldu_s8(v_, p_) \
+            v_ = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(\
+                 _mm_loadu_si128((const __m128i*)(p_))))
+         #define BCL_S8_MASK /* masked int8 loads with MTYPE */
+         #if defined(__AVX512BW__) && defined(__AVX512VL__)
+            #define BCL_maskz_vldu_s8(v_, k_, p_) \
+               v_ = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(\
+                    _mm_maskz_loadu_epi8(k_, p_)))
+         #else
+            #define BCL_maskz_vldu_s8(v_, k_, p_) \
+            {  if ((k_) == 0xFFFF) \
+                  BCL_vldu_s8(v_, p_); \
+               else \
+               {  int8_t bcl_q_[16] = {0}; \
+                  memcpy(bcl_q_, p_, __builtin_popcount(k_)); \
+                  BCL_vldu_s8(v_, bcl_q_); \
+               } \
+            }
+         #endif
          
          /* vector reduced to a variable: from ATLAS */
          #define BCL_vrsum1(d_, s_) \
@@ -137,6 +228,8 @@
          #define BCL_vdiv(d_, s1_, s2_) d_ = _mm256_div_pd(s1_, s2_)
          #define BCL_vmax(d_, s1_, s2_) d_ = _mm256_max_pd(s1_, s2_)
          #define BCL_vmin(d_, s1_, s2_) d_ = _mm256_min_pd(s1_, s2_)
+         #define BCL_vselgt(d_, s1_, s2_, t_, f_) d_ = _mm256_blendv_pd(f_, t_, \
+            _mm256_cmp_pd(s1_, s2_, _CMP_GT_OQ))
          #ifdef ArchHasMAC
             #define BCL_vmac(d_, s1_, s2_) d_ = _mm256_fmadd_pd(s1_, s2_, d_)
          #else
@@ -162,6 +255,15 @@
             d_ = _mm256_blend_pd(d_, v0_, ik_); \
          }
          /*#define BCL_cvtint2mask(k_, ik) k_ = _cvtu32_mask8(ik_) */
+         /* mask of first n_ (< VLEN) elements, int compare needs AVX2 */
+         #ifdef BLC_AVX2
+            #define MTYPE __m256i
+            #define BCL_tailmask(k_, n_) \
+               k_ = _mm256_cmpgt_epi64(_mm256_set1_epi64x(n_), \
+                                       _mm256_setr_epi64x(0, 1, 2, 3))
+            #define BCL_maskz_vldu(v_, k_, p_) v_ = _mm256_maskload_pd(p_, k_)
+            #define BCL_mask_vstu(p_, k_, v_) _mm256_maskstore_pd(p_, k_, v_)
+         #endif
       
         /* vector reduced to a variable: from ATLAS */
 	#define BCL_vrsum1(d_, s_) \
@@ -187,6 +289,8 @@
          #define BCL_vdiv(d_, s1_, s2_) d_ = _mm256_div_ps(s1_, s2_)
          #define BCL_vmax(d_, s1_, s2_) d_ = _mm256_max_ps(s1_, s2_)
          #define BCL_vmin(d_, s1_, s2_) d_ = _mm256_min_ps(s1_, s2_)
+         #define BCL_vselgt(d_, s1_, s2_, t_, f_) d_ = _mm256_blendv_ps(f_, t_, \
+            _mm256_cmp_ps(s1_, s2_, _CMP_GT_OQ))
          #ifdef ArchHasMAC
             #define BCL_vmac(d_, s1_, s2_) d_ = _mm256_fmadd_ps(s1_, s2_, d_)
          #else
@@ -224,6 +328,34 @@
                d_ = _mm256_blend_ps(d_, v0_, ik_); \
             }
          #endif
+         /* mask of first n_ (< VLEN) elements, int compare needs AVX2 */
+         #ifdef BLC_AVX2
+            #define MTYPE __m256i
+            #define BCL_tailmask(k_, n_) \
+               k_ = _mm256_cmpgt_epi32(_mm256_set1_epi32(n_), \
+                                       _mm256_setr_epi32(0,1,2,3,4,5,6,7))
+            #define BCL_maskz_vldu(v_, k_, p_) v_ = _mm256_maskload_ps(p_, k_)
+            #define BCL_mask_vstu(p_, k_, v_) _mm256_maskstore_ps(p_, k_, v_)
+         #endif
+         /* 
+          * half precision storage: VLEN bf16 (upper half of fp32) or fp16 
+          * elements at p_ converted to fp32, fp16 needs F16C 
+          */
+         #ifdef BLC_AVX2
+            #define BCL_vldu_bf16(v_, p_) \
+               v_ = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(\
+                    _mm_loadu_si128((const __m128i*)(p_))), 16))
+         #endif
+         #ifdef __F16C__
+            #define BCL_vldu_f16(v_, p_) \
+               v_ = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(p_)))
+         #endif
+         /* int8 storage: VLEN signed bytes at p_ converted to fp32 */
+         #ifdef BLC_AVX2
+            #define BCL_vldu_s8(v_, p_) \
+               v_ = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(\
+                    _mm_loadl_epi64((const __m128i*)(p_))))
+         #endif
       
 	 #define BCL_vrsum1(d_, s0_) \
       	 {  VTYPE t1_; \
@@ -245,7 +377,7 @@
  */
    #elif defined(BLC_SSE2) || defined(BLC_SSE3) || defined(BLC_SSE4_1) \
          || defined(BLC_SSE4_2)
-      #include<xmmintrin.h>
+      #include<emmintrin.h>
       #define VLENb 16
       #if defined(DREAL)
          #define VLEN 2
@@ -440,6 +572,7 @@
    #define BCL_vmac(d_, s1_, s2_) d_ =  vec_madd(s1_, s2_, d_) 
    #define BCL_vmax(d_, s1_, s2_) d_ =  vec_max(s1_, s2_) 
    #define BCL_vmin(d_, s1_, s2_) d_ =  vec_min(s1_, s2_) 
+   #define BCL_vselgt(d_, s1_, s2_, t_, f_) d_ = vec_sel(f_, t_, vec_cmpgt(s1_, s2_))
    #define BCL_vrcp(d_, s_) d_ = vec_re(s_); /* reciprocal */
    /* FIXME: need to use vec_se to implement masked rcp  
    //#define BCL_imaskz_vrcp(d_, ik_) \ */
@@ -486,6 +619,7 @@
          #define BCL_vmac(d_, s1_, s2_) d_ = vfmaq_f64(d_, s1_, s2_)
          #define BCL_vmax(d_, s1_, s2_) d_ = vmaxq_f64(s1_, s2_)
          #define BCL_vmin(d_, s1_, s2_) d_ = vminq_f64(s1_, s2_)
+         #define BCL_vselgt(d_, s1_, s2_, t_, f_) d_ = vbslq_f64(vcgtq_f64(s1_, s2_), t_, f_)
          #define BCL_vrcp(d_, s_) d_ = vrecpeq_f64(s_)
          #define BCL_vrsum1(d_, s_) \
 	 {  VTYPE t0_; \
@@ -508,6 +642,7 @@
          #define BCL_vmac(d_, s1_, s2_) d_ = vmlaq_f32(d_, s1_, s2_)
          #define BCL_vmax(d_, s1_, s2_) d_ = vmaxq_f32(s1_, s2_)
          #define BCL_vmin(d_, s1_, s2_) d_ = vminq_f32(s1_, s2_)
+         #define BCL_vselgt(d_, s1_, s2_, t_, f_) d_ = vbslq_f32(vcgtq_f32(s1_, s2_), t_, f_)
          #define BCL_vrcp(d_, s_) d_ = vrecpeq_f32(s_)
          #define BCL_vrsum1(d_, s_) \
          {  VTYPE t4_; float32x2_t t2_, t1_; \
@@ -538,5 +673,100 @@
          d_ += mem_[i_]; \
    }
 #endif
+/*
+ * Lane select d_ = (s1_ > s2_) ? t_ : f_, used to keep the argmax of max/min 
+ * aggregation. If not defined, lanes are selected in an aligned buffer 
+ */
+#ifndef BCL_vselgt
+   #define BCL_vselgt(d_, s1_, s2_, t_, f_) \
+   {  VALUETYPE bcl_m1_[VLEN] __attribute__ ((aligned (VLENb)));\
+      VALUETYPE bcl_m2_[VLEN] __attribute__ ((aligned (VLENb)));\
+      VALUETYPE bcl_mt_[VLEN] __attribute__ ((aligned (VLENb)));\
+      VALUETYPE bcl_mf_[VLEN] __attribute__ ((aligned (VLENb)));\
+      int bcl_i_; \
+      BCL_vst(bcl_m1_, s1_); \
+      BCL_vst(bcl_m2_, s2_); \
+      BCL_vst(bcl_mt_, t_); \
+      BCL_vst(bcl_mf_, f_); \
+      for (bcl_i_=0; bcl_i_ < VLEN; bcl_i_++) \
+         if (bcl_m1_[bcl_i_] > bcl_m2_[bcl_i_]) \
+            bcl_mf_[bcl_i_] = bcl_mt_[bcl_i_]; \
+      BCL_vld(d_, bcl_mf_); \
+   }
+#endif
+/*
+ * Software prefetch of the cache line at p_ to all levels of cache, used to 
+ * bring the rows of the dense matrix accessed by upcoming edges. BCL_CLEN is 
+ * the cache line size in bytes 
+ */
+#ifndef BCL_CLEN
+   #define BCL_CLEN 64
+#endif
+#ifndef BCL_prefetch
+   #ifdef BLC_X86
+      #define BCL_prefetch(p_) _mm_prefetch((const char*)(p_), _MM_HINT_T0)
+   #else
+      #define BCL_prefetch(p_) __builtin_prefetch((p_), 0, 3)
+   #endif
+#endif
+/*
+ * Half precision (bf16, fp16) and int8 loads of single precision vectors: if 
+ * not defined, elements are converted one by one to an aligned buffer in 
+ * memory, see bf16_to_fp32 and fp16_to_fp32 in kernels/include/kernels.h. 
+ * Masked loads are defined only with BCL_HALF_MASK and BCL_S8_MASK 
+ */
+#ifndef BCL_vldu_bf16
+   #define BCL_vldu_bf16(v_, p_) \
+   {  float bcl_mem_[VLEN] __attribute__ ((aligned (VLENb)));\
+      int bcl_i_; \
+      for (bcl_i_=0; bcl_i_ < VLEN; bcl_i_++) \
+         bcl_mem_[bcl_i_] = bf16_to_fp32((p_)[bcl_i_]); \
+      BCL_vld(v_, bcl_mem_); \
+   }
+#endif
+#ifndef BCL_vldu_f16
+   #define BCL_vldu_f16(v_, p_) \
+   {  float bcl_mem_[VLEN] __attribute__ ((aligned (VLENb)));\
+      int bcl_i_; \
+      for (bcl_i_=0; bcl_i_ < VLEN; bcl_i_++) \
+         bcl_mem_[bcl_i_] = fp16_to_fp32((p_)[bcl_i_]); \
+      BCL_vld(v_, bcl_mem_); \
+   }
+#endif
+#ifndef BCL_vldu_s8
+   #define BCL_vldu_s8(v_, p_) \
+   {  float bcl_mem_[VLEN] __attribute__ ((aligned (VLENb)));\
+      int bcl_i_; \
+      for (bcl_i_=0; bcl_i_ < VLEN; bcl_i_++) \
+         bcl_mem_[bcl_i_] = (float) (p_)[bcl_i_]; \
+      BCL_vld(v_, bcl_mem_); \
+   }
+#endif
+/*
+ * Masked load/store for the remainder loop: if not defined, go through an 
+ * aligned buffer in memory. mask is the number of elements in that case.
+ * NOTE: locals are prefixed to not capture the caller's variables in p_ 
+ */
+#ifndef BCL_mask_vstu
+   #define BCL_MASK_EMULATED /* no masked load/store instructions */
+   #define MTYPE int 
+   #define BCL_tailmask(k_, n_) k_ = (n_)
+   #define BCL_maskz_vldu(v_, k_, p_) \
+   {  VALUETYPE bcl_mem_[VLEN] __attribute__ ((aligned (VLENb)));\
+      int bcl_i_; \
+      for (bcl_i_=0; bcl_i_ < (k_); bcl_i_++) \
+         bcl_mem_[bcl_i_] = (p_)[bcl_i_]; \
+      for (; bcl_i_ < VLEN; bcl_i_++) \
+         bcl_mem_[bcl_i_] = 0.0; \
+      BCL_vld(v_, bcl_mem_); \
+   }
+   #define BCL_mask_vstu(p_, k_, v_) \
+   {  VALUETYPE bcl_mem_[VLEN] __attribute__ ((aligned (VLENb)));\
+      int bcl_i_; \
+      BCL_vst(bcl_mem_, v_); \
+      for (bcl_i_=0; bcl_i_ < (k_); bcl_i_++) \
+         (p_)[bcl_i_] = bcl_mem_[bcl_i_]; \
+   }
+#endif
 
 #endif
@@ -5,6 +5,8 @@
 #include<stdio.h>
 #include<stdlib.h>
 #include<stdint.h>
+#include<unistd.h>
+#include<math.h>
 #ifdef PTTIME
    #include<omp.h>
 #endif
@@ -17,14 +19,55 @@
    #include "../generated/include/dgmisc.h"
    #include "../generated/include/dgkernels_tdist.h"
    #include "../generated/include/dgkernels_sigmoid.h"
+   #include "../generated/include/dgkernels_softmax.h"
    #include "../generated/include/dgkernels_spmm.h"
    #include "../generated/include/dgkernels_gcn.h"
+   #include "../generated/include/dgkernels_spmm_vb.h"
+   #include "../generated/include/dgkernels_gcn_vb.h"
+   #include "../generated/include/dgkernels_spmm_sell.h"
+   #include "../generated/include/dgkernels_gcn_sell.h"
+   #include "../generated/include/dgkernels_sigmoid_mh.h"
+   #include "../generated/include/dgkernels_tdist_mh.h"
+   #include "../generated/include/dgkernels_sigmoid_eo.h"
+   #include "../generated/include/dgkernels_tdist_eo.h"
+   #include "../generated/include/dgkernels_sigmoid_sd.h"
+   #include "../generated/include/dgkernels_tdist_sd.h"
+   #include "../generated/include/dgkernels_gcn_nm.h"
+   #include "../generated/include/dgkernels_max.h"
+   #include "../generated/include/dgkernels_min.h"
+   #include "../generated/include/dgkernels_max_ag.h"
+   #include "../generated/include/dgkernels_min_ag.h"
 #else
    #include "../generated/include/sgmisc.h"
    #include "../generated/include/sgkernels_tdist.h"
    #include "../generated/include/sgkernels_sigmoid.h"
+   #include "../generated/include/sgkernels_softmax.h"
    #include "../generated/include/sgkernels_spmm.h"
    #include "../generated/include/sgkernels_gcn.h"
+   #include "../generated/include/sgkernels_spmm_vb.h"
+   #include "../generated/include/sgkernels_gcn_vb.h"
+   #include "../generated/include/sgkernels_spmm_sell.h"
+   #include "../generated/include/sgkernels_gcn_sell.h"
+   #include "../generated/include/sgkernels_sigmoid_mh.h"
+   #include "../generated/include/sgkernels_tdist_mh.h"
+   #include "../generated/include/sgkernels_sigmoid_eo.h"
+   #include "../generated/include/sgkernels_tdist_eo.h"
+   #include "../generated/include/sgkernels_sigmoid_sd.h"
+   #include "../generated/include/sgkernels_tdist_sd.h"
+   #include "../generated/include/sgkernels_gcn_nm.h"
+   #include "../generated/include/sgkernels_max.h"
+   #include "../generated/include/sgkernels_min.h"
+   #include "../generated/include/sgkernels_max_ag.h"
+   #include "../generated/include/sgkernels_min_ag.h"
+   #include "../generated/include/sgkernels_sigmoid_bf16.h"
+   #include "../generated/include/sgkernels_sigmoid_f16.h"
+   #include "../generated/include/sgkernels_spmm_bf16.h"
+   #include "../generated/include/sgkernels_spmm_f16.h"
+   #include "../generated/include/sgkernels_gcn_bf16.h"
+   #include "../generated/include/sgkernels_gcn_f16.h"
+   #include "../generated/include/sgkernels_sigmoid_i8.h"
+   #include "../generated/include/sgkernels_spmm_i8.h"
+   #include "../generated/include/sgkernels_gcn_i8.h"
 #endif
 
 #ifdef DREAL 
@@ -34,13 +77,46 @@
    #define VALUETYPE float 
    #define PRE s
 #endif
+#include "../simd/simd.h"
+/*
+ * generated kernels mask the last vector of a row when K % VLEN != 0, K must 
+ * be multiple of VLEN when the SIMD unit has no masked load/store 
+ */
+#ifdef BCL_MASK_EMULATED
+   #define GKERN_K_OK(k_) ((k_) % GVLEN == 0)
+#else
+   #define GKERN_K_OK(k_) 1
+#endif
+/* same for kernels of half precision A and B, see XBF16 in genkern.base */
+#if defined(BCL_MASK_EMULATED) || !defined(BCL_HALF_MASK)
+   #define GHALF_K_OK(k_) ((k_) % GVLEN == 0)
+#else
+   #define GHALF_K_OK(k_) 1
+#endif
+/* same for kernels of int8 B, see YI8 in genkern.base */
+#if defined(BCL_MASK_EMULATED) || !defined(BCL_S8_MASK)
+   #define GS8_K_OK(k_) ((k_) % GVLEN == 0)
+#else
+   #define GS8_K_OK(k_) 1
+#endif
 /* ============================================================================
  * Some trusted non-optimized kernel for the cases which are not handled by 
- * generated kernel. 
- * NOTE NOTE: in current version, optimized generated kernels can't be applied
- * when K%VLEN != 0. User should aways pad the row and make dimension multiple
- * of vector width before calling the optimized code.  
+ * generated kernel: K > MAXDIM without kruntime, or K%VLEN != 0 when masked 
+ * load/store is not available (see GKERN_K_OK)
  *============================================================================*/
+/*
+ * trusted kernels: C = beta * C for a row before accumulating alpha * func, C 
+ * is not read when beta = 0 
+ */
+static void ScaleRowC(const INDEXTYPE k, const VALUETYPE beta, VALUETYPE *c)
+{
+   if (beta == 0.0)
+      for (INDEXTYPE kk=0; kk < k; kk++)
+         c[kk] = 0.0;
+   else if (beta != 1.0)
+      for (INDEXTYPE kk=0; kk < k; kk++)
+         c[kk] *= beta;
+}
 
 void trusted_fusedMM_tdist_csr 
 (
@@ -48,12 +124,12 @@ void trusted_fusedMM_tdist_csr
    const INDEXTYPE m,      /* number of row of X */
    const INDEXTYPE n,      /* number of row of Y */
    const INDEXTYPE k,      /* dimension (col of X or Y) */ 
-   const VALUETYPE alpha,  /* not used yet */ 
+   const VALUETYPE alpha,  /* alpha value */ 
    const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
    const INDEXTYPE rows,   /* number of rows in sparse matrix */
    const INDEXTYPE cols,   /* number of columns in sparse matrix */
    const VALUETYPE *val,   /* value of NNZ  */
-   const INDEXTYPE *indx,  /* colids -> column indices*/
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
    const INDEXTYPE *pntrb, /* starting index for rowptr */
    const INDEXTYPE *pntre, /* ending index for rowptr */
    const VALUETYPE *a,     /* Dense B matrix */
@@ -62,90 +138,57 @@ void trusted_fusedMM_tdist_csr
    const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
    const VALUETYPE beta,   /* beta value */ 
    VALUETYPE *c,           /* Dense matrix c */
-   const INDEXTYPE ldc     /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
 )
 {
-#if defined(PTTIME) && defined(LDB)
-   omp_set_num_threads(NTHREADS);
-   #pragma omp parallel
-   {
-      INDEXTYPE RowPerThd, tt;
-      INDEXTYPE i, rowb, rowe;
-      INDEXTYPE Mnnz = 0; /* non-zero count in M rows  */
-      INDEXTYPE deg, cumRow, curRow;
-      INDEXTYPE id = omp_get_thread_num();
-      INDEXTYPE nthreads = omp_get_num_threads(); 
-      
-      for (i=0; i < m; i++)
-         Mnnz += (pntre[i] - pntrb[i]); 
-      RowPerThd = Mnnz / nthreads; 
-      
-      curRow = cumRow = 0; 
-      tt = 1; 
-      rowe = -1;  /* init */
-      /* set rowstart for 1st thread */ 
-      if (id == 0) 
-         rowb = 0;
-      for (i=0; i < m; i++)
-      {
-         deg = pntre[i] - pntrb[i]; 
-         cumRow += deg;
-         curRow += deg;
-         if (curRow > RowPerThd)
-         {
-            if (tt == id)
-               rowb = i; 
-            else if (tt == id+1)
-               rowe = i; 
-            curRow = 0;
-            RowPerThd = (Mnnz - cumRow) / (nthreads - tt);
-            tt += 1; 
-         }
-      }
-      if (tt == id+1)
-         rowe = m; 
-
-      for (i=rowb; i < rowe; i++)
-#else /* not LBD or not PTTIME */
-   #ifdef PTTIME
-      #ifdef NTHREADS
-      omp_set_num_threads(NTHREADS);
-      #endif
-      #ifdef DYNAMIC 
-         #pragma omp parallel for schedule(dynamic)
-      #else
-         #pragma omp parallel for schedule(static)
-      #endif
+/*
+ * rowb != NULL: partition t has rows rowb[t] to rowb[t+1]-1, see 
+ *    GetRowPartition in fusedMM.c
+ * rowb == NULL: each row is a partition, scheduled by openmp among npart 
+ *    threads (0: default of openmp)
+ */
+   const INDEXTYPE np = rowb ? npart : m; 
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
    #endif
-   for (INDEXTYPE i = 0; i < m; i++)
 #endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
    {
-      const INDEXTYPE iindex = i * k;
+      const VALUETYPE *Ai = a + i * lda;
+      VALUETYPE *Ci = c + i * ldc;
+      ScaleRowC(k, beta, Ci);
       VALUETYPE T[k];
       for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
       {
          const INDEXTYPE cid = indx[j];
-         const INDEXTYPE jindex = cid * k; 
+         const VALUETYPE *Bj = b + cid * ldb; 
          VALUETYPE attrc = 0.0;
          for (INDEXTYPE kk=0; kk < k; kk++)
          {
-            T[k] = a[iindex + k] - b[jindex + k];
-            attrc += T[k] * T[k];  
+            T[kk] = Ai[kk] - Bj[kk];
+            attrc += T[kk] * T[kk];  
          }
          VALUETYPE d1 = -2.0 / (1.0 + attrc); 
          // update C 
          for (INDEXTYPE kk=0; kk < k; kk++)
          {
-            VALUETYPE x = T[k] * d1 ;
+            VALUETYPE x = T[kk] * d1 ;
             x = (x > SM_BOUND) ? SM_BOUND : x; 
             x = (x < -SM_BOUND) ? -SM_BOUND : x; 
-            c[iindex+k] = c[iindex+k]  + x;
+            Ci[kk] = Ci[kk]  + alpha * x;
          }
       }
    }
-#if defined(PTTIME) && defined(LDB)
    }
-#endif 
 }
 
 void trusted_fusedMM_sigmoid_csr 
@@ -154,12 +197,12 @@ void trusted_fusedMM_sigmoid_csr
    const INDEXTYPE m,      /* number of row of X */
    const INDEXTYPE n,      /* number of row of Y */
    const INDEXTYPE k,      /* dimension (col of X or Y) */ 
-   const VALUETYPE alpha,  /* not used yet */ 
+   const VALUETYPE alpha,  /* alpha value */ 
    const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
    const INDEXTYPE rows,   /* number of rows in sparse matrix */
    const INDEXTYPE cols,   /* number of columns in sparse matrix */
    const VALUETYPE *val,   /* value of NNZ  */
-   const INDEXTYPE *indx,  /* colids -> column indices*/
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
    const INDEXTYPE *pntrb, /* starting index for rowptr */
    const INDEXTYPE *pntre, /* ending index for rowptr */
    const VALUETYPE *a,     /* Dense B matrix */
@@ -168,7 +211,9 @@ void trusted_fusedMM_sigmoid_csr
    const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
    const VALUETYPE beta,   /* beta value */ 
    VALUETYPE *c,           /* Dense matrix c */
-   const INDEXTYPE ldc     /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
 )
 {
 #ifndef SOP_INHOUSE
@@ -182,101 +227,65 @@ void trusted_fusedMM_sigmoid_csr
       exit(1);
    }
 #endif
-#if defined(PTTIME) && defined(LDB)
-   omp_set_num_threads(NTHREADS);
-   #pragma omp parallel
-   {
-      INDEXTYPE RowPerThd, tt;
-      INDEXTYPE i, rowb, rowe;
-      INDEXTYPE Mnnz = 0; /* non-zero count in M rows  */
-      INDEXTYPE deg, cumRow, curRow;
-      INDEXTYPE id = omp_get_thread_num();
-      INDEXTYPE nthreads = omp_get_num_threads(); 
-      
-      for (i=0; i < m; i++)
-         Mnnz += (pntre[i] - pntrb[i]); 
-      RowPerThd = Mnnz / nthreads; 
-      
-      curRow = cumRow = 0; 
-      tt = 1; 
-      rowe = -1;  /* init */
-      /* set rowstart for 1st thread */ 
-      if (id == 0) 
-         rowb = 0;
-      for (i=0; i < m; i++)
-      {
-         deg = pntre[i] - pntrb[i]; 
-         cumRow += deg;
-         curRow += deg;
-         if (curRow > RowPerThd)
-         {
-            if (tt == id)
-               rowb = i; 
-            else if (tt == id+1)
-               rowe = i; 
-            curRow = 0;
-            RowPerThd = (Mnnz - cumRow) / (nthreads - tt);
-            tt += 1; 
-         }
-      }
-      if (tt == id+1)
-         rowe = m; 
-
-      for (i=rowb; i < rowe; i++)
-#else /* not LBD or not PTTIME */
-   #ifdef PTTIME
-      #ifdef NTHREADS
-      omp_set_num_threads(NTHREADS);
-      #endif
-      #ifdef DYNAMIC 
-         #pragma omp parallel for schedule(dynamic)
-      #else
-         #pragma omp parallel for schedule(static)
-      #endif
+   const INDEXTYPE np = rowb ? npart : m; 
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
    #endif
-   for (INDEXTYPE i = 0; i < m; i++)
 #endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
    {
-      const INDEXTYPE iindex = i * k;
+      const VALUETYPE *Ai = a + i * lda;
+      VALUETYPE *Ci = c + i * ldc;
+      ScaleRowC(k, beta, Ci);
       for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
       {
          const INDEXTYPE cid = indx[j];
-         const INDEXTYPE jindex = cid * k; 
+         const VALUETYPE *Bj = b + cid * ldb; 
          VALUETYPE attrc = 0.0;
          VALUETYPE d1; 
          for (INDEXTYPE kk=0; kk < k; kk++)
-            attrc += a[iindex+kk] * b[jindex+kk];
+            attrc += Ai[kk] * Bj[kk];
    #ifdef SOP_INHOUSE
          d1 = fast_SM(attrc, sm_table);
          d1 = 1.0 - d1;
    #else
          SOP_UDEF_FUNC(attrc, &d1);
    #endif
+         d1 *= alpha;
          // update C 
          for (INDEXTYPE kk=0; kk < k; kk++)
-            c[iindex+kk] += d1*b[jindex+kk];
+            Ci[kk] += d1*Bj[kk];
       }
    }
-#if defined(PTTIME) && defined(LDB)
    }
-#endif
 #ifdef SOP_INHOUSE
    free(sm_table);
 #endif
 }
 
-void trusted_fusedMM_spmm_csr 
+/*
+ * softmax of the dot products of the edges of a row: max and sum of the row 
+ * first, then C += alpha * exp(s - max) / sum * Bj 
+ */
+void trusted_fusedMM_softmax_csr 
 (
-   const char tkern,       /* 't' = tdist 's' = sigmoid 'm' = spmm 'g' = gcn */
+   const char tkern,       /* 'a' = softmax */
    const INDEXTYPE m,      /* number of row of X */
    const INDEXTYPE n,      /* number of row of Y */
    const INDEXTYPE k,      /* dimension (col of X or Y) */ 
-   const VALUETYPE alpha,  /* not used yet */ 
+   const VALUETYPE alpha,  /* alpha value */ 
    const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
    const INDEXTYPE rows,   /* number of rows in sparse matrix */
    const INDEXTYPE cols,   /* number of columns in sparse matrix */
    const VALUETYPE *val,   /* value of NNZ  */
-   const INDEXTYPE *indx,  /* colids -> column indices*/
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
    const INDEXTYPE *pntrb, /* starting index for rowptr */
    const INDEXTYPE *pntre, /* ending index for rowptr */
    const VALUETYPE *a,     /* Dense B matrix */
@@ -285,78 +294,110 @@ void trusted_fusedMM_spmm_csr
    const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
    const VALUETYPE beta,   /* beta value */ 
    VALUETYPE *c,           /* Dense matrix c */
-   const INDEXTYPE ldc     /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
 )
 {
-#if defined(PTTIME) && defined(LDB)
-   omp_set_num_threads(NTHREADS);
-   #pragma omp parallel
-   {
-      INDEXTYPE RowPerThd, tt;
-      INDEXTYPE i, rowb, rowe;
-      INDEXTYPE Mnnz = 0; /* non-zero count in M rows  */
-      INDEXTYPE deg, cumRow, curRow;
-      INDEXTYPE id = omp_get_thread_num();
-      INDEXTYPE nthreads = omp_get_num_threads(); 
-      
-      for (i=0; i < m; i++)
-         Mnnz += (pntre[i] - pntrb[i]); 
-      RowPerThd = Mnnz / nthreads; 
-      
-      curRow = cumRow = 0; 
-      tt = 1; 
-      rowe = -1;  /* init */
-      /* set rowstart for 1st thread */ 
-      if (id == 0) 
-         rowb = 0;
-      for (i=0; i < m; i++)
+   const INDEXTYPE np = rowb ? npart : m; 
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
+   #endif
+#endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+   {
+      const VALUETYPE *Ai = a + i * lda;
+      VALUETYPE *Ci = c + i * ldc;
+      VALUETYPE smax = -HUGE_VAL, ssum = 0.0;
+      ScaleRowC(k, beta, Ci);
+      for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
       {
-         deg = pntre[i] - pntrb[i]; 
-         cumRow += deg;
-         curRow += deg;
-         if (curRow > RowPerThd)
+         const VALUETYPE *Bj = b + indx[j] * ldb; 
+         VALUETYPE attrc = 0.0;
+         for (INDEXTYPE kk=0; kk < k; kk++)
+            attrc += Ai[kk] * Bj[kk];
+         if (attrc > smax) /* sum is rescaled when max is raised */
          {
-            if (tt == id)
-               rowb = i; 
-            else if (tt == id+1)
-               rowe = i; 
-            curRow = 0;
-            RowPerThd = (Mnnz - cumRow) / (nthreads - tt);
-            tt += 1; 
+            ssum = ssum * exp(smax - attrc) + 1.0; 
+            smax = attrc; 
          }
+         else
+            ssum += exp(attrc - smax);
+      }
+      for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
+      {
+         const VALUETYPE *Bj = b + indx[j] * ldb; 
+         VALUETYPE attrc = 0.0, d1;
+         for (INDEXTYPE kk=0; kk < k; kk++)
+            attrc += Ai[kk] * Bj[kk];
+         d1 = alpha * exp(attrc - smax) / ssum;
+         // update C 
+         for (INDEXTYPE kk=0; kk < k; kk++)
+            Ci[kk] += d1*Bj[kk];
       }
-      if (tt == id+1)
-         rowe = m; 
+   }
+   }
+}
 
-      for (i=rowb; i < rowe; i++)
-#else /* not LBD or not PTTIME */
-   #ifdef PTTIME
-      #ifdef NTHREADS
-      omp_set_num_threads(NTHREADS);
-      #endif
-      #ifdef DYNAMIC 
-         #pragma omp parallel for schedule(dynamic)
-      #else
-         #pragma omp parallel for schedule(static)
-      #endif
+void trusted_fusedMM_spmm_csr 
+(
+   const char tkern,       /* 't' = tdist 's' = sigmoid 'm' = spmm 'g' = gcn */
+   const INDEXTYPE m,      /* number of row of X */
+   const INDEXTYPE n,      /* number of row of Y */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
+   const INDEXTYPE rows,   /* number of rows in sparse matrix */
+   const INDEXTYPE cols,   /* number of columns in sparse matrix */
+   const VALUETYPE *val,   /* value of NNZ  */
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
+   const INDEXTYPE *pntrb, /* starting index for rowptr */
+   const INDEXTYPE *pntre, /* ending index for rowptr */
+   const VALUETYPE *a,     /* Dense B matrix */
+   const INDEXTYPE lda,    /* leading dimension of a (col size since row-major) */
+   const VALUETYPE *b,     /* Dense B matrix */
+   const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
+   const VALUETYPE beta,   /* beta value */ 
+   VALUETYPE *c,           /* Dense matrix c */
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
+)
+{
+   const INDEXTYPE np = rowb ? npart : m; 
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
    #endif
-   for (INDEXTYPE i = 0; i < m; i++)
 #endif
+   for (INDEXTYPE t = 0; t < np; t++)
    {
-      const INDEXTYPE iindex = i * k;
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+   {
+      VALUETYPE *Ci = c + i * ldc;
+      ScaleRowC(k, beta, Ci);
       for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
       {
          const INDEXTYPE cid = indx[j];
-         const INDEXTYPE jindex = cid * k; 
-         VALUETYPE v0 = val[j];
+         const VALUETYPE *Bj = b + cid * ldb; 
+         VALUETYPE v0 = alpha * val[j];
          // update C 
          for (INDEXTYPE kk=0; kk < k; kk++)
-            c[iindex+kk] += v0 * b[jindex+kk];
+            Ci[kk] += v0 * Bj[kk];
       }
    }
-#if defined(PTTIME) && defined(LDB)
    }
-#endif 
 }
 
 void trusted_fusedMM_gcn_csr 
@@ -365,12 +406,12 @@ void trusted_fusedMM_gcn_csr
    const INDEXTYPE m,      /* number of row of X */
    const INDEXTYPE n,      /* number of row of Y */
    const INDEXTYPE k,      /* dimension (col of X or Y) */ 
-   const VALUETYPE alpha,  /* not used yet */ 
+   const VALUETYPE alpha,  /* alpha value */ 
    const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
    const INDEXTYPE rows,   /* number of rows in sparse matrix */
    const INDEXTYPE cols,   /* number of columns in sparse matrix */
    const VALUETYPE *val,   /* value of NNZ  */
-   const INDEXTYPE *indx,  /* colids -> column indices*/
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
    const INDEXTYPE *pntrb, /* starting index for rowptr */
    const INDEXTYPE *pntre, /* ending index for rowptr */
    const VALUETYPE *a,     /* Dense B matrix */
@@ -379,257 +420,1319 @@ void trusted_fusedMM_gcn_csr
    const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
    const VALUETYPE beta,   /* beta value */ 
    VALUETYPE *c,           /* Dense matrix c */
-   const INDEXTYPE ldc     /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
+)
+{
+   const INDEXTYPE np = rowb ? npart : m; 
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
+   #endif
+#endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+   {
+      VALUETYPE *Ci = c + i * ldc;
+      ScaleRowC(k, beta, Ci);
+      for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
+      {
+         const INDEXTYPE cid = indx[j];
+         const VALUETYPE *Bj = b + cid * ldb; 
+         // update C 
+         for (INDEXTYPE kk=0; kk < k; kk++)
+            Ci[kk] += alpha * Bj[kk];
+      }
+   }
+   }
+}
+
+/*
+ * max ('x') and min ('n') of the rows of B of the edges of a row: 
+ * C = max(alpha * max_j Bj, beta * C), C = alpha * max_j Bj when beta = 0 and 
+ * beta * C when the row has no edges. arg (if not NULL) gets the nonzero 
+ * which gave each element of C, -1 for C. Ties keep the first nonzero 
+ */
+static void trusted_maxmin_csr
+(
+   const char tkern,       /* 'x' = max 'n' = min */
+   const INDEXTYPE m,      /* number of row of X */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
+   const INDEXTYPE *pntrb, /* starting index for rowptr */
+   const INDEXTYPE *pntre, /* ending index for rowptr */
+   const VALUETYPE *b,     /* Dense B matrix */
+   const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
+   const VALUETYPE beta,   /* beta value */ 
+   VALUETYPE *c,           /* Dense matrix c */
+   const INDEXTYPE ldc,    /* leading dimension size of c and arg */ 
+   INDEXTYPE *arg,         /* nonzero of each element of c, NULL: not stored */
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
 )
 {
-#if defined(PTTIME) && defined(LDB)
-   omp_set_num_threads(NTHREADS);
-   #pragma omp parallel
-   {
-      INDEXTYPE RowPerThd, tt;
-      INDEXTYPE i, rowb, rowe;
-      INDEXTYPE Mnnz = 0; /* non-zero count in M rows  */
-      INDEXTYPE deg, cumRow, curRow;
-      INDEXTYPE id = omp_get_thread_num();
-      INDEXTYPE nthreads = omp_get_num_threads(); 
-      
-      for (i=0; i < m; i++)
-         Mnnz += (pntre[i] - pntrb[i]); 
-      RowPerThd = Mnnz / nthreads; 
-      
-      curRow = cumRow = 0; 
-      tt = 1; 
-      rowe = -1;  /* init */
-      /* set rowstart for 1st thread */ 
-      if (id == 0) 
-         rowb = 0;
-      for (i=0; i < m; i++)
+   const INDEXTYPE np = rowb ? npart : m; 
+   const int amin = (tkern == 'n');
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
+   #endif
+#endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+   {
+      VALUETYPE *Ci = c + i * ldc;
+      if (pntre[i] == pntrb[i]) /* no edges: C = beta * C */
+      {
+         ScaleRowC(k, beta, Ci);
+         if (arg)
+            for (INDEXTYPE kk=0; kk < k; kk++)
+               arg[i*ldc+kk] = -1;
+         continue;
+      }
+      for (INDEXTYPE kk=0; kk < k; kk++)
       {
-         deg = pntre[i] - pntrb[i]; 
-         cumRow += deg;
-         curRow += deg;
-         if (curRow > RowPerThd)
+         INDEXTYPE ja = pntrb[i];
+         VALUETYPE v = b[indx[ja]*ldb+kk];
+         for (INDEXTYPE j=pntrb[i]+1; j < pntre[i]; j++)
          {
-            if (tt == id)
-               rowb = i; 
-            else if (tt == id+1)
-               rowe = i; 
-            curRow = 0;
-            RowPerThd = (Mnnz - cumRow) / (nthreads - tt);
-            tt += 1; 
+            const VALUETYPE bj = b[indx[j]*ldb+kk];
+            if (amin ? bj < v : bj > v)
+            {
+               v = bj;
+               ja = j;
+            }
+         }
+         v *= alpha;
+         if (beta != 0.0) /* C wins ties */
+         {
+            const VALUETYPE cb = beta * Ci[kk];
+            if (!(amin ? v < cb : v > cb))
+            {
+               v = cb;
+               ja = -1;
+            }
          }
+         Ci[kk] = v;
+         if (arg)
+            arg[i*ldc+kk] = ja;
       }
-      if (tt == id+1)
-         rowe = m; 
+   }
+   }
+}
+
+void trusted_fusedMM_maxmin_csr 
+(
+   const char tkern,       /* 'x' = max 'n' = min */
+   const INDEXTYPE m,      /* number of row of X */
+   const INDEXTYPE n,      /* number of row of Y */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
+   const INDEXTYPE rows,   /* number of rows in sparse matrix */
+   const INDEXTYPE cols,   /* number of columns in sparse matrix */
+   const VALUETYPE *val,   /* value of NNZ  */
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
+   const INDEXTYPE *pntrb, /* starting index for rowptr */
+   const INDEXTYPE *pntre, /* ending index for rowptr */
+   const VALUETYPE *a,     /* Dense B matrix */
+   const INDEXTYPE lda,    /* leading dimension of a (col size since row-major) */
+   const VALUETYPE *b,     /* Dense B matrix */
+   const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
+   const VALUETYPE beta,   /* beta value */ 
+   VALUETYPE *c,           /* Dense matrix c */
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
+)
+{
+   trusted_maxmin_csr(tkern, m, k, alpha, indx, pntrb, pntre, b, ldb, beta, c, 
+                      ldc, NULL, npart, rowb);
+}
+
+void trusted_fusedMM_maxmin_arg_csr 
+(
+   const char tkern,       /* 'x' = max 'n' = min */
+   const INDEXTYPE m,      /* number of row of X */
+   const INDEXTYPE n,      /* number of row of Y */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
+   const INDEXTYPE rows,   /* number of rows in sparse matrix */
+   const INDEXTYPE cols,   /* number of columns in sparse matrix */
+   const VALUETYPE *val,   /* value of NNZ  */
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
+   const INDEXTYPE *pntrb, /* starting index for rowptr */
+   const INDEXTYPE *pntre, /* ending index for rowptr */
+   const VALUETYPE *a,     /* Dense B matrix */
+   const INDEXTYPE lda,    /* leading dimension of a (col size since row-major) */
+   const VALUETYPE *b,     /* Dense B matrix */
+   const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
+   const VALUETYPE beta,   /* beta value */ 
+   VALUETYPE *c,           /* Dense matrix c */
+   const INDEXTYPE ldc,    /* leading dimension size of c and arg */ 
+   INDEXTYPE *arg,         /* nonzero of each element of c */
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
+)
+{
+   trusted_maxmin_csr(tkern, m, k, alpha, indx, pntrb, pntre, b, ldb, beta, c, 
+                      ldc, arg, npart, rowb);
+}
 
-      for (i=rowb; i < rowe; i++)
-#else /* not LBD or not PTTIME */
-   #ifdef PTTIME
-      #ifdef NTHREADS
-      omp_set_num_threads(NTHREADS);
-      #endif
-      #ifdef DYNAMIC 
-         #pragma omp parallel for schedule(dynamic)
-      #else
-         #pragma omp parallel for schedule(static)
-      #endif
+/*
+ * spmm ('m') and gcn ('g') with compressed column indices (vbidx), see 
+ * VBIDX_NEXT in kernels.h 
+ */
+void trusted_fusedMM_vb_csr 
+(
+   const char tkern,       /* 'm' = spmm 'g' = gcn */
+   const INDEXTYPE m,      /* number of row of X */
+   const INDEXTYPE n,      /* number of row of Y */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
+   const INDEXTYPE rows,   /* number of rows in sparse matrix */
+   const INDEXTYPE cols,   /* number of columns in sparse matrix */
+   const VALUETYPE *val,   /* value of NNZ  */
+   const uint8_t *cidx,    /* compressed colids */
+   const INDEXTYPE *cptr,  /* row i of cidx starts at byte cptr[i] */
+   const INDEXTYPE *pntrb, /* starting index for rowptr */
+   const INDEXTYPE *pntre, /* ending index for rowptr */
+   const VALUETYPE *a,     /* Dense B matrix */
+   const INDEXTYPE lda,    /* leading dimension of a (col size since row-major) */
+   const VALUETYPE *b,     /* Dense B matrix */
+   const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
+   const VALUETYPE beta,   /* beta value */ 
+   VALUETYPE *c,           /* Dense matrix c */
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
+)
+{
+   const INDEXTYPE np = rowb ? npart : m; 
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
    #endif
-   for (INDEXTYPE i = 0; i < m; i++)
 #endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
    {
-      const INDEXTYPE iindex = i * k;
+      VALUETYPE *Ci = c + i * ldc;
+      vbidx_cur_t cs; 
+      INDEXTYPE cid = 0;
+      ScaleRowC(k, beta, Ci);
+      if (pntre[i] > pntrb[i])
+         VBIDX_ROW(cs, cidx + cptr[i]);
       for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
       {
-         const INDEXTYPE cid = indx[j];
-         const INDEXTYPE jindex = cid * k; 
+         VBIDX_NEXT(cs, cid);
+         const VALUETYPE *Bj = b + cid * ldb; 
+         VALUETYPE v0 = (tkern == 'g') ? alpha : alpha * val[j];
          // update C 
          for (INDEXTYPE kk=0; kk < k; kk++)
-            c[iindex+kk] += b[jindex+kk];
+            Ci[kk] += v0 * Bj[kk];
       }
    }
-#if defined(PTTIME) && defined(LDB)
    }
-#endif 
 }
 
-//void Mjoin(PRE,fusedMM_csr) 
-#ifdef DREAL 
-void dgfusedMM_csr
+/*=============================================================================
+ * K-tiled execution of sigmoid and tdist for K wider than the register block 
+ *    of generated kernels 
+ *    K is split in panels of P (= MAXDIM_SPMM, the widest spmm kernel) 
+ *    columns and rows of a partition in row blocks. Row blocks are sized so 
+ *    that the rows of the Y panel they touch fit in half of the L2 cache. 
+ *    The edge scalars (ROP over the whole K) are needed before updating any 
+ *    panel, so a row block is processed in 3 steps: 
+ *    1. ROP of the edges accumulated panel by panel 
+ *    2. SOP of the edges of the block 
+ *    3. update panel by panel with the spmm kernel using the scalars as the 
+ *       values of the sparse matrix, tdist: s * (Xi - Yj) is computed as 
+ *       (sum of s) * Xi - s * Yj  
+ *    Used without kruntime for K > MAXDIM and with kruntime for K >= 
+ *    KTILE_MINK (rolled loop of kruntime kernels is fine for small K-DIM). 
+ *    spmm and gcn are not tiled: they stream each row of Y once per edge 
+ *    anyway and splitting K only repeats the irregular accesses. 
+ *    Define NO_KTILE to disable it 
+ *============================================================================*/
+#define KTKERN_T Mjoin(Mjoin(kern_,PRE),gfusedMM_t)
+#ifndef KTILE_MINK
+   #define KTILE_MINK 128
+#endif
+#ifdef NO_KTILE
+   #define USE_KTILE(k_, dim_, kr_) 0
 #else
-void sgfusedMM_csr
+   #define USE_KTILE(k_, dim_, kr_) \
+      ((k_) > (dim_) && GKERN_K_OK(k_) && (!(kr_) || (k_) >= KTILE_MINK))
+#endif
+/*
+ * L2 cache size in bytes: -DKTILE_L2=<bytes> or detected at runtime
+ */
+static size_t GetL2Size(void)
+{
+#ifdef KTILE_L2
+   return KTILE_L2;
+#else
+   static size_t l2 = 0;
+   if (!l2)
+   {
+      long sz = -1;
+   #ifdef _SC_LEVEL2_CACHE_SIZE
+      sz = sysconf(_SC_LEVEL2_CACHE_SIZE);
+   #endif
+      l2 = (sz > 0) ? sz : 1048576; 
+   }
+   return l2;
 #endif
+}
+/*
+ * partial ROP of a panel: dot product (sigmoid) or squared distance (tdist) 
+ */
+static VALUETYPE PanelROP(const char tkern, const INDEXTYPE kw, 
+      const VALUETYPE *x, const VALUETYPE *y)
+{
+   INDEXTYPE kk;
+   VALUETYPE d; 
+   VTYPE Vx, Vy, Vd;
+   MTYPE Vmask;
+
+   BCL_vzero(Vd);
+   for (kk = 0; kk + VLEN <= kw; kk += VLEN)
+   {
+      BCL_vldu(Vx, x+kk); 
+      BCL_vldu(Vy, y+kk); 
+      if (tkern == 't')
+      {
+         BCL_vsub(Vx, Vx, Vy);
+         BCL_vmac(Vd, Vx, Vx);
+      }
+      else
+         BCL_vmac(Vd, Vx, Vy);
+   }
+   if (kk < kw)
+   {
+      BCL_tailmask(Vmask, kw-kk);
+      BCL_maskz_vldu(Vx, Vmask, x+kk); 
+      BCL_maskz_vldu(Vy, Vmask, y+kk); 
+      if (tkern == 't')
+      {
+         BCL_vsub(Vx, Vx, Vy);
+         BCL_vmac(Vd, Vx, Vx);
+      }
+      else
+         BCL_vmac(Vd, Vx, Vy);
+   }
+   BCL_vrsum1(d, Vd);
+   return d;
+}
+
+static void ktiled_fusedMM_csr 
 (
    const char tkern,       /* 't' = tdist 's' = sigmoid 'm' = spmm 'g' = gcn */
    const INDEXTYPE m,      /* number of row of X */
    const INDEXTYPE n,      /* number of row of Y */
    const INDEXTYPE k,      /* dimension (col of X or Y) */ 
-   const VALUETYPE alpha,  /* not used yet */ 
+   const VALUETYPE alpha,  /* alpha value */ 
    const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
    const INDEXTYPE rows,   /* number of rows in sparse matrix */
    const INDEXTYPE cols,   /* number of columns in sparse matrix */
    const VALUETYPE *val,   /* value of NNZ  */
-   const INDEXTYPE *indx,  /* colids -> column indices*/
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
    const INDEXTYPE *pntrb, /* starting index for rowptr */
    const INDEXTYPE *pntre, /* ending index for rowptr */
-   const VALUETYPE *a,     /* Dense B matrix */
+   const VALUETYPE *a,     /* Dense A matrix */
    const INDEXTYPE lda,    /* leading dimension of a (col size since row-major) */
    const VALUETYPE *b,     /* Dense B matrix */
    const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
    const VALUETYPE beta,   /* beta value */ 
    VALUETYPE *c,           /* Dense matrix c */
-   const INDEXTYPE ldc     /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
 )
 {
-   INDEXTYPE kk;
-   
-   switch(tkern)
+   const INDEXTYPE P = MAXDIM_SPMM; 
+   /* panel kernels: full panels and the last (partial) one */
+   const KTKERN_T pkern = Mjoin(PRE,gfusedMM_csr_getkern)('m', P, alpha, beta);
+   const KTKERN_T lkern = 
+      Mjoin(PRE,gfusedMM_csr_getkern)('m', k % P ? k % P : P, alpha, beta);
+   const INDEXTYPE rb0 = rowb ? rowb[0] : 0;
+   const INDEXTYPE rb1 = rowb ? rowb[npart] : m;
+   INDEXTYPE ebl, rb, np, e0, e1; 
+   VALUETYPE *pS, *S; /* edge scalars */
+   extern int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out);
+   extern int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, 
+                                  VALUETYPE *out);
+#ifdef SOP_INHOUSE
+   VALUETYPE *sm_table = NULL;
+#endif
+/*
+ * edges of a row block: their rows of the Y panel fit in half of L2 
+ */
+   ebl = GetL2Size() / (2 * P * sizeof(VALUETYPE));
+   if (ebl < 1) ebl = 1;
+/*
+ * rowb = NULL: rows are split in blocks of rb rows using the average degree 
+ */
+   if (rowb)
    {
-      case 't': // tdist
-         if (KRUNTIME_TDIST && k >= BESTK_TDIST)
-            kk = BESTK_TDIST/GVLEN; /* GVLEN: generated kernels vlen */
-         else
+      rb = 0; 
+      np = npart; 
+   }
+   else
+   {
+      rb = (m && pntre[m-1] > pntrb[0]) ? ebl * m / (pntre[m-1] - pntrb[0]) 
+           : m;
+      if (rb < 1) rb = 1;
+      np = (m + rb - 1) / rb; 
+   }
+/*
+ * scalars are indexed by the edges, so they can be passed as values to the 
+ * spmm kernel: only the edges [e0,e1) of rows rb0:rb1 are allocated, which is
+ * a chunk of a row when called on heavy rows 
+ */
+   e0 = e1 = rb1 > rb0 ? pntrb[rb0] : 0;
+   for (INDEXTYPE i = rb0; i < rb1; i++)
+   {
+      if (pntrb[i] < e0) e0 = pntrb[i];
+      if (pntre[i] > e1) e1 = pntre[i];
+   }
+   pS = (VALUETYPE*)malloc((e1 > e0 ? e1 - e0 : 1)*sizeof(VALUETYPE));
+   if (!pS)
+   {
+      fprintf(stderr, "Unable to allocate memory for K-tiled kernel!!!\n");
+      exit(1);
+   }
+   S = pS - e0;
+#ifdef SOP_INHOUSE
+   if (tkern == 's')
+   {
+      sm_table = (VALUETYPE*)malloc(sizeof(VALUETYPE)*SM_TABLE_SIZE);
+      if (!sm_table)
+      {
+         fprintf(stderr, 
+               "Unable to allocate memory for SM TABLE in K-tiled kernel!!!\n");
+         exit(1);
+      }
+      Mjoin(Mjoin(init_,PRE),SM_TABLE)(sm_table);
+   }
+#endif
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
+   #endif
+#endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE r0 = rowb ? rowb[t] : t * rb; 
+      const INDEXTYPE r1 = rowb ? rowb[t+1] : ((t+1)*rb < m ? (t+1)*rb : m); 
+      INDEXTYPE ie; 
+
+      for (INDEXTYPE ib = r0; ib < r1; ib = ie)
+      {
+         INDEXTYPE blk[2];  /* row block as a partition for the kernels */
+         INDEXTYPE ne = pntre[ib] - pntrb[ib]; 
+         for (ie = ib+1; ie < r1 && ne + pntre[ie] - pntrb[ie] <= ebl; ie++)
+            ne += pntre[ie] - pntrb[ie]; 
+         blk[0] = ib; 
+         blk[1] = ie; 
+      /*
+       *  1st pass: ROP of the edges, panel by panel 
+       */
+         for (INDEXTYPE i = ib; i < ie; i++)
+            for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+               S[j] = 0.0;
+         for (INDEXTYPE kp = 0; kp < k; kp += P)
          {
-            kk = k / GVLEN;
-            if (k % GVLEN || k > MAXDIM_TDIST) /* no optimize kernel */
-            {
-               trusted_fusedMM_tdist_csr(tkern, m, n, k, alpha, nnz, rows,
-                                        cols, val, indx, pntrb, pntre, a, lda, 
-                                        b, ldb, beta, c,ldc);
-               return;
-            }
+            const INDEXTYPE kw = (k - kp < P) ? k - kp : P; 
+            for (INDEXTYPE i = ib; i < ie; i++)
+               for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+                  S[j] += PanelROP(tkern, kw, a + i*lda + kp, 
+                                   b + indx[j]*ldb + kp);
          }
-         if (beta == 0)
-         #ifdef DREAL 
-            dgenkernels_tdist_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #else
-            sgenkernels_tdist_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #endif
-         else /* beta == 1 */
-         #ifdef DREAL 
-            dgenkernels_tdist_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #else
-            sgenkernels_tdist_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #endif
-         break;
-      case 's': // sigmoid
-         if (KRUNTIME_SIGMOID && k >= BESTK_SIGMOID)
-            kk = BESTK_SIGMOID/GVLEN; /* GVLEN: generated kernels vlen */
-         else
+      /*
+       *  SOP of the edges of the block, sign is flipped for tdist since 
+       *  s * Yj is subtracted 
+       */
+         for (INDEXTYPE i = ib; i < ie; i++)
          {
-            kk = k / GVLEN;
-            if (k % GVLEN || k > MAXDIM_SIGMOID) /* no optimize kernel */
+            const INDEXTYPE jb = pntrb[i]; 
+            const INDEXTYPE nj = pntre[i] - jb; 
+         #ifdef SOP_INHOUSE
+            if (tkern == 's')
             {
-               trusted_fusedMM_sigmoid_csr(tkern, m, n, k, alpha, nnz, rows,
-                                        cols, val, indx, pntrb, pntre, a, lda, 
-                                        b, ldb, beta, c,ldc);
-               return;
+               for (INDEXTYPE j = 0; j < nj; j++)
+                  S[jb+j] = 1.0 - fast_SM(S[jb+j], sm_table); 
             }
-         }
-         if (beta == 0)
-         #ifdef DREAL 
-            dgenkernels_sigmoid_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #else
-            sgenkernels_sigmoid_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
+            else
          #endif
-         else /* beta == 1 */
-         #ifdef DREAL 
-            dgenkernels_sigmoid_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
+            {
+         #ifdef SOP_PEREDGE
+               for (INDEXTYPE j = 0; j < nj; j++)
+                  SOP_UDEF_FUNC(S[jb+j], S+jb+j);
          #else
-            sgenkernels_sigmoid_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
+               SOP_UDEF_BATCH_FUNC(nj, S+jb, S+jb);
          #endif
-         break;
-      case 'm': // spmm
-         if (KRUNTIME_SPMM && k >= BESTK_SPMM)
-            kk = BESTK_SPMM/GVLEN; /* GVLEN: generated kernels vlen */
-         else
+            }
+            if (tkern == 't')
+               for (INDEXTYPE j = 0; j < nj; j++)
+                  S[jb+j] = -S[jb+j];
+         }
+      /*
+       *  update of the panels with the spmm kernel 
+       */
+         for (INDEXTYPE kp = 0; kp < k; kp += P)
          {
-            kk = k / GVLEN;
-            if (k % GVLEN || k > MAXDIM_SPMM) /* no optimize kernel */
+            const INDEXTYPE kw = (k - kp < P) ? k - kp : P; 
+            const KTKERN_T kern = (kw == P) ? pkern : lkern;
+            kern('m', m, n, kw, alpha, nnz, rows, cols, S, indx, pntrb, pntre,
+                 a + kp, lda, b + kp, ldb, beta, c + kp, ldc, 1, blk);
+            if (tkern == 't') /* C += alpha * (sum of s) * Xi */
             {
-               trusted_fusedMM_spmm_csr(tkern, m, n, k, alpha, nnz, rows,
-                                        cols, val, indx, pntrb, pntre, a, lda, 
-                                        b, ldb, beta, c,ldc);
-               return;
+               for (INDEXTYPE i = ib; i < ie; i++)
+               {
+                  const VALUETYPE *Ai = a + i * lda + kp;
+                  VALUETYPE *Ci = c + i * ldc + kp;
+                  VALUETYPE si = 0.0; 
+                  for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+                     si -= S[j]; 
+                  si *= alpha; 
+                  for (INDEXTYPE kk = 0; kk < kw; kk++)
+                     Ci[kk] += si * Ai[kk];
+               }
             }
          }
-         if (beta == 0)
-         #ifdef DREAL 
-            dgenkernels_spmm_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #else
-            sgenkernels_spmm_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
+      }
+   }
+#ifdef SOP_INHOUSE
+   if (sm_table)
+      free(sm_table);
+#endif
+   free(pS);
+}
+
+/*=============================================================================
+ * Edge-vectorized sigmoid and tdist for tiny K (K < SMALLK_MAXK <= VLEN) 
+ *    Generated kernels vectorize along K: with K < VLEN most lanes are masked 
+ *    off and every edge pays a full horizontal reduction and a scalar SOP. 
+ *    Here lanes are edges instead: Y rows of a block of VLEN edges of a row 
+ *    are gathered column by column into Yt (Yt[kk*VLEN+e] = Yj[kk] of edge 
+ *    e), so ROP is K vector FMAs for VLEN edges. The update of C reduces the 
+ *    K vectors of the block once. 
+ *    Unused lanes of the last block are padded so that they contribute 
+ *    nothing: Yj = Xi for tdist (Xi - Yj = 0), Yj = 0 for sigmoid. 
+ *    Y rows are prefetched SMALLK_PFD edges ahead like generated kernels do. 
+ *    Define NO_SMALLK to disable it 
+ *============================================================================*/
+/*
+ * K <= VLEN/8: K <= 2 on AVX512 and K = 1 on AVX2 in single precision. With 
+ * AVX512 the masked kernels were as fast at K = 3, 4 and faster at K = 6, 8 
+ * (copying Y costs more than the lanes saved), so the cutoff is not per ISA 
+ */
+#ifndef SMALLK_MAXK
+   #define SMALLK_MAXK (VLEN/8+1) 
+#endif
+#ifndef SMALLK_PFD
+   #define SMALLK_PFD 16 /* prefetch distance in edges */
+#endif
+#ifdef NO_SMALLK
+   #define USE_SMALLK(k_) 0
+#else
+   #define USE_SMALLK(k_) ((k_) && (k_) < SMALLK_MAXK)
+#endif
+
+static void smallk_fusedMM_csr 
+(
+   const char tkern,       /* 't' = tdist 's' = sigmoid */
+   const INDEXTYPE m,      /* number of row of X */
+   const INDEXTYPE n,      /* number of row of Y */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
+   const INDEXTYPE rows,   /* number of rows in sparse matrix */
+   const INDEXTYPE cols,   /* number of columns in sparse matrix */
+   const VALUETYPE *val,   /* value of NNZ  */
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
+   const INDEXTYPE *pntrb, /* starting index for rowptr */
+   const INDEXTYPE *pntre, /* ending index for rowptr */
+   const VALUETYPE *a,     /* Dense A matrix */
+   const INDEXTYPE lda,    /* leading dimension of a (col size since row-major) */
+   const VALUETYPE *b,     /* Dense B matrix */
+   const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
+   const VALUETYPE beta,   /* beta value */ 
+   VALUETYPE *c,           /* Dense matrix c */
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
+)
+{
+   const INDEXTYPE np = rowb ? npart : m; 
+   const int istd = (tkern == 't'); 
+   extern int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out);
+   extern int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, 
+                                  VALUETYPE *out);
+#ifdef SOP_INHOUSE
+   VALUETYPE *sm_table = NULL;
+   if (!istd)
+   {
+      sm_table = (VALUETYPE*)malloc(sizeof(VALUETYPE)*SM_TABLE_SIZE);
+      if (!sm_table)
+      {
+         fprintf(stderr, 
+            "Unable to allocate memory for SM TABLE in small-K kernel!!!\n");
+         exit(1);
+      }
+      Mjoin(Mjoin(init_,PRE),SM_TABLE)(sm_table);
+   }
+#endif
+#ifdef PTTIME
+   const int nthreads = npart ? npart : omp_get_max_threads(); 
+   #ifdef DYNAMIC 
+      #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+   #else
+      #pragma omp parallel for num_threads(nthreads) schedule(static)
+   #endif
+#endif
+   for (INDEXTYPE t = 0; t < np; t++)
+   {
+      const INDEXTYPE rowe = rowb ? rowb[t+1] : t+1; 
+      /* edges of the partition end at pfe, prefetch crosses rows up to it */
+      const INDEXTYPE pfe = (rowe > (rowb ? rowb[t] : t)) ? pntre[rowe-1] : 0;
+      VALUETYPE Yt[SMALLK_MAXK*VLEN] __attribute__ ((aligned (VLENb)));
+      VALUETYPE S[VLEN] __attribute__ ((aligned (VLENb)));
+
+      for (INDEXTYPE i = rowb ? rowb[t] : t; i < rowe; i++)
+      {
+         const VALUETYPE *Ai = a + i * lda;
+         VALUETYPE *Ci = c + i * ldc;
+
+         ScaleRowC(k, beta, Ci);
+         for (INDEXTYPE jb = pntrb[i]; jb < pntre[i]; jb += VLEN)
+         {
+            const INDEXTYPE ne = (pntre[i] - jb < VLEN) ? pntre[i] - jb : VLEN;
+            VTYPE Vs, Vy, Vx; 
+         /*
+          *  gather Y rows of the block, pad unused lanes 
+          */
+            for (INDEXTYPE e = 0; e < ne; e++)
+            {
+               const VALUETYPE *Bj = b + indx[jb+e] * ldb; 
+               if (jb + e + SMALLK_PFD < pfe)
+                  BCL_prefetch(b + indx[jb+e+SMALLK_PFD] * ldb);
+               for (INDEXTYPE kk = 0; kk < k; kk++)
+                  Yt[kk*VLEN+e] = Bj[kk]; 
+            }
+            for (INDEXTYPE e = ne; e < VLEN; e++)
+               for (INDEXTYPE kk = 0; kk < k; kk++)
+                  Yt[kk*VLEN+e] = istd ? Ai[kk] : 0.0; 
+         /*
+          *  ROP of VLEN edges: squared distance or dot product 
+          */
+            BCL_vzero(Vs);
+            for (INDEXTYPE kk = 0; kk < k; kk++)
+            {
+               BCL_vld(Vy, Yt+kk*VLEN); 
+               BCL_vbcast(Vx, Ai+kk); 
+               if (istd)
+               {
+                  BCL_vsub(Vy, Vx, Vy); 
+                  BCL_vmac(Vs, Vy, Vy); 
+               }
+               else
+                  BCL_vmac(Vs, Vx, Vy); 
+            }
+            BCL_vst(S, Vs); 
+         /*
+          *  SOP of the edges of the block 
+          */
+         #ifdef SOP_INHOUSE
+            if (!istd)
+            {
+               for (INDEXTYPE e = 0; e < ne; e++)
+                  S[e] = 1.0 - fast_SM(S[e], sm_table); 
+            }
+            else
          #endif
-         else /* beta == 1 */
-         #ifdef DREAL 
-            dgenkernels_spmm_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
+            {
+         #ifdef SOP_PEREDGE
+               for (INDEXTYPE e = 0; e < ne; e++)
+                  SOP_UDEF_FUNC(S[e], S+e);
          #else
-            sgenkernels_spmm_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
+               SOP_UDEF_BATCH_FUNC(ne, S, S);
          #endif
+            }
+            BCL_vld(Vs, S); 
+         /*
+          *  update: one reduction of the edges of the block per column 
+          */
+            for (INDEXTYPE kk = 0; kk < k; kk++)
+            {
+               VALUETYPE d; 
+               BCL_vld(Vy, Yt+kk*VLEN); 
+               if (istd)
+               {
+                  BCL_vbcast(Vx, Ai+kk); 
+                  BCL_vsub(Vy, Vx, Vy); 
+               }
+               BCL_vmul(Vy, Vy, Vs); 
+               BCL_vrsum1(d, Vy);
+               Ci[kk] += alpha * d; 
+            }
+         }
+      }
+   }
+#ifdef SOP_INHOUSE
+   if (sm_table)
+      free(sm_table);
+#endif
+}
+
+/*
+ * Select kernel based on tkern, k, alpha and beta: generated kernel when there
+ * is one for k, K-tiled execution of them for wide k, trusted kernel 
+ * otherwise. Selection doesn't depend on the sparse matrix or dense operands,
+ * so it can be done once and reused. 
+ * Generated kernels: b0 for alpha = 1 and beta = 0, b1 for alpha = 1 and 
+ * beta = 1, bX (general alpha and beta) otherwise 
+ */
+#ifdef DREAL 
+kern_dgfusedMM_t dgfusedMM_csr_getkern
+#else
+kern_sgfusedMM_t sgfusedMM_csr_getkern
+#endif
+(
+   const char tkern,       /* 't' = tdist 's' = sigmoid 'm' = spmm 'g' = gcn
+                              'a' = softmax 'x' = max 'n' = min */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta    /* beta value */ 
+)
+{
+   INDEXTYPE kk;
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+   
+   switch(tkern)
+   {
+      case 't': // tdist
+         if (USE_SMALLK(k))
+            return smallk_fusedMM_csr;
+         else if (USE_KTILE(k, MAXDIM_TDIST, KRUNTIME_TDIST))
+            return ktiled_fusedMM_csr;
+         else if (KRUNTIME_TDIST && k >= BESTK_TDIST)
+            kk = BESTK_TDIST/GVLEN; /* GVLEN: generated kernels vlen */
+         else
+         {
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_TDIST)
+               return trusted_fusedMM_tdist_csr; /* no optimized kernel */
+         }
+         if (bx)
+            return Mjoin(PRE,genkernels_tdist_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_tdist_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_tdist_b1)[kk-1];
+      case 's': // sigmoid
+         if (USE_SMALLK(k))
+            return smallk_fusedMM_csr;
+         else if (USE_KTILE(k, MAXDIM_SIGMOID, KRUNTIME_SIGMOID))
+            return ktiled_fusedMM_csr;
+         else if (KRUNTIME_SIGMOID && k >= BESTK_SIGMOID)
+            kk = BESTK_SIGMOID/GVLEN; /* GVLEN: generated kernels vlen */
+         else
+         {
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_SIGMOID)
+               return trusted_fusedMM_sigmoid_csr; /* no optimized kernel */
+         }
+         if (bx)
+            return Mjoin(PRE,genkernels_sigmoid_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_sigmoid_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_sigmoid_b1)[kk-1];
+      case 'a': // softmax
+         kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+      /*
+       *    no rolled loop for k > BESTK in softmax kernels: C can't be 
+       *    rescaled when the max of the row is raised 
+       */
+         if (!k || !GKERN_K_OK(k) || k > MAXDIM_SOFTMAX 
+               || (KRUNTIME_SOFTMAX && k > BESTK_SOFTMAX))
+            return trusted_fusedMM_softmax_csr; /* no optimized kernel */
+         if (bx)
+            return Mjoin(PRE,genkernels_softmax_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_softmax_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_softmax_b1)[kk-1];
+      case 'm': // spmm
+         if (KRUNTIME_SPMM && k >= BESTK_SPMM)
+            kk = BESTK_SPMM/GVLEN; /* GVLEN: generated kernels vlen */
+         else
+         {
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_SPMM)
+               return trusted_fusedMM_spmm_csr; /* no optimized kernel */
+         }
+         if (bx)
+            return Mjoin(PRE,genkernels_spmm_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_spmm_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_spmm_b1)[kk-1];
+      case 'g': // gcn
+         if (KRUNTIME_GCN && k >= BESTK_GCN) /* assumption: k >= BESTK */
+            kk = BESTK_GCN/GVLEN; /* GVLEN: generated kernels vlen */
+         else
+         {
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_GCN)
+               return trusted_fusedMM_gcn_csr; /* no optimized kernel */
+         }
+         if (bx)
+            return Mjoin(PRE,genkernels_gcn_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_gcn_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_gcn_b1)[kk-1];
+      case 'x': // max 
+      case 'n': // min 
+         kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+      /*
+       *    no rolled loop for k > BESTK in max and min kernels, same header 
+       *    parameters for both 
+       */
+         if (!k || !GKERN_K_OK(k) || k > MAXDIM_MAX 
+               || (KRUNTIME_MAX && k > BESTK_MAX))
+            return trusted_fusedMM_maxmin_csr; /* no optimized kernel */
+         if (tkern == 'n')
+         {
+            if (bx)
+               return Mjoin(PRE,genkernels_min_bX)[kk-1];
+            else if (beta == 0)
+               return Mjoin(PRE,genkernels_min_b0)[kk-1];
+            else /* beta == 1 */
+               return Mjoin(PRE,genkernels_min_b1)[kk-1];
+         }
+         if (bx)
+            return Mjoin(PRE,genkernels_max_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_max_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_max_b1)[kk-1];
+      default: 
          break;
+   }
+   return NULL;
+}
+
+/*
+ * Select kernel for compressed column indices, same selection as 
+ * fusedMM_csr_getkern for spmm and gcn 
+ */
+#ifdef DREAL 
+kern_dgfusedMM_vb_t dgfusedMM_vbcsr_getkern
+#else
+kern_sgfusedMM_vb_t sgfusedMM_vbcsr_getkern
+#endif
+(
+   const char tkern,       /* 'm' = spmm 'g' = gcn */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta    /* beta value */ 
+)
+{
+   INDEXTYPE kk;
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+   
+   switch(tkern)
+   {
+      case 'm': // spmm
+         if (KRUNTIME_SPMM && k >= BESTK_SPMM)
+            kk = BESTK_SPMM/GVLEN; /* GVLEN: generated kernels vlen */
+         else
+         {
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_SPMM)
+               return trusted_fusedMM_vb_csr; /* no optimized kernel */
+         }
+         if (bx)
+            return Mjoin(PRE,genkernels_spmm_vb_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_spmm_vb_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_spmm_vb_b1)[kk-1];
       case 'g': // gcn
          if (KRUNTIME_GCN && k >= BESTK_GCN) /* assumption: k >= BESTK */
             kk = BESTK_GCN/GVLEN; /* GVLEN: generated kernels vlen */
          else
          {
-            kk = k / GVLEN;
-            if (k % GVLEN || k > MAXDIM_SPMM) /* no optimize kernel */
-            {
-               trusted_fusedMM_gcn_csr(tkern, m, n, k, alpha, nnz, rows,
-                                        cols, val, indx, pntrb, pntre, a, lda, 
-                                        b, ldb, beta, c,ldc);
-               return;
-            }
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_GCN)
+               return trusted_fusedMM_vb_csr; /* no optimized kernel */
          }
-         if (beta == 0)
-         #ifdef DREAL 
-            dgenkernels_gcn_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #else
-            sgenkernels_gcn_b0[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #endif
+         if (bx)
+            return Mjoin(PRE,genkernels_gcn_vb_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_gcn_vb_b0)[kk-1];
          else /* beta == 1 */
-         #ifdef DREAL 
-            dgenkernels_gcn_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #else
-            sgenkernels_gcn_b1[kk-1](tkern, m, n, k, alpha, nnz, rows,
-                                       cols, val, indx, pntrb, pntre, a, lda, 
-                                       b, ldb, beta, c, ldc);
-         #endif
+            return Mjoin(PRE,genkernels_gcn_vb_b1)[kk-1];
+      default: 
+         break;
+   }
+   return NULL;
+}
+
+/*
+ * Select kernel for SELL-C-sigma: lock-step kernels are generated for k up to
+ * MAXDIM_SELL (a vector per row), NULL otherwise 
+ */
+#ifdef DREAL 
+kern_dgfusedMM_sell_t dgfusedMM_sell_getkern
+#else
+kern_sgfusedMM_sell_t sgfusedMM_sell_getkern
+#endif
+(
+   const char tkern,       /* 'm' = spmm 'g' = gcn */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta    /* beta value */ 
+)
+{
+   INDEXTYPE kk;
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+   
+   kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+   switch(tkern)
+   {
+      case 'm': // spmm
+         if (!k || !GKERN_K_OK(k) || k > MAXDIM_SELL_SPMM)
+            return NULL; /* no lock-step kernel */
+         if (bx)
+            return Mjoin(PRE,genkernels_spmm_sell_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_spmm_sell_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_spmm_sell_b1)[kk-1];
+      case 'g': // gcn
+         if (!k || !GKERN_K_OK(k) || k > MAXDIM_SELL_GCN)
+            return NULL; /* no lock-step kernel */
+         if (bx)
+            return Mjoin(PRE,genkernels_gcn_sell_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_gcn_sell_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_gcn_sell_b1)[kk-1];
+      default: 
+         break;
+   }
+   return NULL;
+}
+
+/*
+ * Select multi-head kernel: heads are register blocked, so k must be the 
+ * dimension of a generated kernel (no masked or rolled part) and a head a 
+ * power of 2 vectors, NULL otherwise. With kruntime, k above bestK is not 
+ * register blocked either: it is the tuned limit of the register block 
+ */
+#ifdef DREAL 
+kern_dgfusedMM_mh_t dgfusedMM_mh_getkern
+#else
+kern_sgfusedMM_mh_t sgfusedMM_mh_getkern
+#endif
+(
+   const char tkern,       /* 't' = tdist 's' = sigmoid */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const INDEXTYPE nhead,  /* number of heads */
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta    /* beta value */ 
+)
+{
+   INDEXTYPE kk, vh;
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+   
+   if (nhead < 1 || !k || k % GVLEN)
+      return NULL; 
+   kk = k / GVLEN; 
+   vh = kk / nhead; /* vectors per head */
+   if (kk % nhead || (vh & (vh - 1)))
+      return NULL; 
+   switch(tkern)
+   {
+      case 't': // tdist
+         if (k > MAXDIM_TDIST || (KRUNTIME_TDIST && k > BESTK_TDIST))
+            return NULL; 
+         if (bx)
+            return Mjoin(PRE,genkernels_tdist_mh_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_tdist_mh_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_tdist_mh_b1)[kk-1];
+      case 's': // sigmoid
+         if (k > MAXDIM_SIGMOID || (KRUNTIME_SIGMOID && k > BESTK_SIGMOID))
+            return NULL; 
+         if (bx)
+            return Mjoin(PRE,genkernels_sigmoid_mh_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_sigmoid_mh_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_sigmoid_mh_b1)[kk-1];
+      default: 
          break;
+   }
+   return NULL;
+}
+
+/*
+ * Select kernel with per-edge output: same dimensions as fusedMM_csr_getkern
+ * without small-k and K-tiled execution, NULL when there is no generated 
+ * kernel for k. SDDMM kernels are generated for beta = 0 only: they don't 
+ * access C 
+ */
+#ifdef DREAL 
+kern_dgfusedMM_edge_t dgfusedMM_edge_getkern
+#else
+kern_sgfusedMM_edge_t sgfusedMM_edge_getkern
+#endif
+(
+   const char tkern,       /* 't' = tdist 's' = sigmoid */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta,   /* beta value */ 
+   const int sddmm         /* 1: per-edge output only */
+)
+{
+   INDEXTYPE kk;
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+   
+   switch(tkern)
+   {
+      case 't': // tdist
+         if (KRUNTIME_TDIST && k >= BESTK_TDIST)
+            kk = BESTK_TDIST/GVLEN; /* GVLEN: generated kernels vlen */
+         else
+         {
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_TDIST)
+               return NULL; /* no optimized kernel */
+         }
+         if (sddmm)
+            return Mjoin(PRE,genkernels_tdist_sd_b0)[kk-1];
+         else if (bx)
+            return Mjoin(PRE,genkernels_tdist_eo_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_tdist_eo_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_tdist_eo_b1)[kk-1];
+      case 's': // sigmoid
+         if (KRUNTIME_SIGMOID && k >= BESTK_SIGMOID)
+            kk = BESTK_SIGMOID/GVLEN; /* GVLEN: generated kernels vlen */
+         else
+         {
+            kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+            if (!k || !GKERN_K_OK(k) || k > MAXDIM_SIGMOID)
+               return NULL; /* no optimized kernel */
+         }
+         if (sddmm)
+            return Mjoin(PRE,genkernels_sigmoid_sd_b0)[kk-1];
+         else if (bx)
+            return Mjoin(PRE,genkernels_sigmoid_eo_bX)[kk-1];
+         else if (beta == 0)
+            return Mjoin(PRE,genkernels_sigmoid_eo_b0)[kk-1];
+         else /* beta == 1 */
+            return Mjoin(PRE,genkernels_sigmoid_eo_b1)[kk-1];
       default: 
-         fprintf(stderr, "Kernel not implemented yet!!!\n");
          break;
    }
+   return NULL;
+}
+/*
+ * Select normalized gcn kernel, see kern_dgfusedMM_norm_t in kernels.h 
+ */
+#ifdef DREAL 
+kern_dgfusedMM_norm_t dgfusedMM_norm_getkern
+#else
+kern_sgfusedMM_norm_t sgfusedMM_norm_getkern
+#endif
+(
+   const char tkern,       /* 'g' = gcn */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta    /* beta value */ 
+)
+{
+   const INDEXTYPE kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+
+   if (tkern != 'g')
+      return NULL;
+/*
+ * no rolled loop for k > BESTK: the row scale is applied to the registers 
+ */
+   if (!k || !GKERN_K_OK(k) || k > MAXDIM_GCN 
+         || (KRUNTIME_GCN && k > BESTK_GCN))
+      return NULL; 
+   if (bx)
+      return Mjoin(PRE,genkernels_gcn_nm_bX)[kk-1];
+   else if (beta == 0)
+      return Mjoin(PRE,genkernels_gcn_nm_b0)[kk-1];
+   else /* beta == 1 */
+      return Mjoin(PRE,genkernels_gcn_nm_b1)[kk-1];
+}
+/*
+ * Select max or min kernel with arg output, see kern_dgfusedMM_arg_t in 
+ * kernels.h 
+ */
+#ifdef DREAL 
+kern_dgfusedMM_arg_t dgfusedMM_arg_getkern
+#else
+kern_sgfusedMM_arg_t sgfusedMM_arg_getkern
+#endif
+(
+   const char tkern,       /* 'x' = max 'n' = min */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta,   /* beta value */ 
+   const INDEXTYPE maxdeg  /* max nonzeros of a row */
+)
+{
+   const INDEXTYPE kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+#ifdef DREAL 
+   const INDEXTYPE maxoff = (INDEXTYPE) 1 << 53; /* exact in the mantissa */
+#else
+   const INDEXTYPE maxoff = (INDEXTYPE) 1 << 24; 
+#endif
+
+   if (tkern != 'x' && tkern != 'n')
+      return NULL;
+   if (!k || !GKERN_K_OK(k) || k > MAXDIM_MAX || maxdeg > maxoff
+         || (KRUNTIME_MAX && k > BESTK_MAX))
+      return trusted_fusedMM_maxmin_arg_csr; 
+   if (tkern == 'n')
+   {
+      if (bx)
+         return Mjoin(PRE,genkernels_min_ag_bX)[kk-1];
+      else if (beta == 0)
+         return Mjoin(PRE,genkernels_min_ag_b0)[kk-1];
+      else /* beta == 1 */
+         return Mjoin(PRE,genkernels_min_ag_b1)[kk-1];
+   }
+   if (bx)
+      return Mjoin(PRE,genkernels_max_ag_bX)[kk-1];
+   else if (beta == 0)
+      return Mjoin(PRE,genkernels_max_ag_b0)[kk-1];
+   else /* beta == 1 */
+      return Mjoin(PRE,genkernels_max_ag_b1)[kk-1];
+}
+
+//void Mjoin(PRE,fusedMM_csr) 
+#ifdef DREAL 
+void dgfusedMM_csr
+#else
+void sgfusedMM_csr
+#endif
+(
+   const char tkern,       /* 't' = tdist 's' = sigmoid 'm' = spmm 'g' = gcn
+                              'a' = softmax */
+   const INDEXTYPE m,      /* number of row of X */
+   const INDEXTYPE n,      /* number of row of Y */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const INDEXTYPE nnz,    /* nonzeros in sparse matrix  */
+   const INDEXTYPE rows,   /* number of rows in sparse matrix */
+   const INDEXTYPE cols,   /* number of columns in sparse matrix */
+   const VALUETYPE *val,   /* value of NNZ  */
+   const COLINDEXTYPE *indx, /* colids -> column indices*/
+   const INDEXTYPE *pntrb, /* starting index for rowptr */
+   const INDEXTYPE *pntre, /* ending index for rowptr */
+   const VALUETYPE *a,     /* Dense B matrix */
+   const INDEXTYPE lda,    /* leading dimension of a (col size since row-major) */
+   const VALUETYPE *b,     /* Dense B matrix */
+   const INDEXTYPE ldb,    /* leading dimension of b (col size since row-major) */ 
+   const VALUETYPE beta,   /* beta value */ 
+   VALUETYPE *c,           /* Dense matrix c */
+   const INDEXTYPE ldc,    /* leading dimension size of c (col size since row-major) */ 
+   const INDEXTYPE npart,  /* row partitions in rowb, threads if rowb = NULL */
+   const INDEXTYPE *rowb   /* row partitions, NULL: rows scheduled by openmp */
+)
+{
+#ifdef DREAL 
+   kern_dgfusedMM_t kern = dgfusedMM_csr_getkern(tkern, k, alpha, beta);
+#else
+   kern_sgfusedMM_t kern = sgfusedMM_csr_getkern(tkern, k, alpha, beta);
+#endif
+
+   if (!kern)
+   {
+      fprintf(stderr, "Kernel not implemented yet!!!\n");
+      return;
+   }
+   kern(tkern, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, pntre, a, 
+        lda, b, ldb, beta, c, ldc, npart, rowb);
 }
 
 #ifdef __cplusplus
    }
 #endif
+
+#ifdef SREAL
+/*
+ * Select kernel for half precision A and B, same selection as 
+ * fusedMM_csr_getkern for sigmoid, spmm and gcn without K-tiling. returns 
+ * NULL when there is no generated kernel, caller falls back to the general 
+ * fusedMM then 
+ */
+kern_sgfusedMM_half_t sgfusedMM_half_getkern
+(
+   const int dtype,        /* KERN_BF16 or KERN_FP16 */
+   const char tkern,       /* 's' = sigmoid 'm' = spmm 'g' = gcn */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta    /* beta value */ 
+)
+{
+   INDEXTYPE kk, maxdim, bestk;
+   int kruntime; 
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+   const int bf = (dtype == KERN_BF16); 
+   kern_sgfusedMM_half_t *tb; /* generated kernels for beta */
+   
+   if (dtype != KERN_BF16 && dtype != KERN_FP16)
+      return NULL;
+   switch(tkern)
+   {
+      case 's': // sigmoid
+         maxdim = MAXDIM_SIGMOID; 
+         kruntime = KRUNTIME_SIGMOID; 
+         bestk = BESTK_SIGMOID; 
+         if (bx)
+            tb = bf ? sgenkernels_sigmoid_bf16_bX : sgenkernels_sigmoid_f16_bX;
+         else if (beta == 0)
+            tb = bf ? sgenkernels_sigmoid_bf16_b0 : sgenkernels_sigmoid_f16_b0;
+         else /* beta == 1 */
+            tb = bf ? sgenkernels_sigmoid_bf16_b1 : sgenkernels_sigmoid_f16_b1;
+         break;
+      case 'm': // spmm
+         maxdim = MAXDIM_SPMM; 
+         kruntime = KRUNTIME_SPMM; 
+         bestk = BESTK_SPMM; 
+         if (bx)
+            tb = bf ? sgenkernels_spmm_bf16_bX : sgenkernels_spmm_f16_bX;
+         else if (beta == 0)
+            tb = bf ? sgenkernels_spmm_bf16_b0 : sgenkernels_spmm_f16_b0;
+         else /* beta == 1 */
+            tb = bf ? sgenkernels_spmm_bf16_b1 : sgenkernels_spmm_f16_b1;
+         break;
+      case 'g': // gcn
+         maxdim = MAXDIM_GCN; 
+         kruntime = KRUNTIME_GCN; 
+         bestk = BESTK_GCN; 
+         if (bx)
+            tb = bf ? sgenkernels_gcn_bf16_bX : sgenkernels_gcn_f16_bX;
+         else if (beta == 0)
+            tb = bf ? sgenkernels_gcn_bf16_b0 : sgenkernels_gcn_f16_b0;
+         else /* beta == 1 */
+            tb = bf ? sgenkernels_gcn_bf16_b1 : sgenkernels_gcn_f16_b1;
+         break;
+      default: 
+         return NULL;
+   }
+   if (kruntime && k >= bestk)
+      kk = bestk/GVLEN; /* GVLEN: generated kernels vlen */
+   else
+   {
+      kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+      if (!k || !GHALF_K_OK(k) || k > maxdim)
+         return NULL; 
+   }
+   return tb[kk-1];
+}
+/*
+ * Select kernel for int8 B, same as sgfusedMM_half_getkern 
+ */
+kern_sgfusedMM_i8_t sgfusedMM_i8_getkern
+(
+   const char tkern,       /* 's' = sigmoid 'm' = spmm 'g' = gcn */
+   const INDEXTYPE k,      /* dimension (col of X or Y) */ 
+   const VALUETYPE alpha,  /* alpha value */ 
+   const VALUETYPE beta    /* beta value */ 
+)
+{
+   INDEXTYPE kk, maxdim, bestk;
+   int kruntime; 
+   const int bx = !(alpha == 1.0 && (beta == 0.0 || beta == 1.0));
+   kern_sgfusedMM_i8_t *tb; /* generated kernels for beta */
+   
+   switch(tkern)
+   {
+      case 's': // sigmoid
+         maxdim = MAXDIM_SIGMOID; 
+         kruntime = KRUNTIME_SIGMOID; 
+         bestk = BESTK_SIGMOID; 
+         if (bx)
+            tb = sgenkernels_sigmoid_i8_bX;
+         else if (beta == 0)
+            tb = sgenkernels_sigmoid_i8_b0;
+         else /* beta == 1 */
+            tb = sgenkernels_sigmoid_i8_b1;
+         break;
+      case 'm': // spmm
+         maxdim = MAXDIM_SPMM; 
+         kruntime = KRUNTIME_SPMM; 
+         bestk = BESTK_SPMM; 
+         if (bx)
+            tb = sgenkernels_spmm_i8_bX;
+         else if (beta == 0)
+            tb = sgenkernels_spmm_i8_b0;
+         else /* beta == 1 */
+            tb = sgenkernels_spmm_i8_b1;
+         break;
+      case 'g': // gcn
+         maxdim = MAXDIM_GCN; 
+         kruntime = KRUNTIME_GCN; 
+         bestk = BESTK_GCN; 
+         if (bx)
+            tb = sgenkernels_gcn_i8_bX;
+         else if (beta == 0)
+            tb = sgenkernels_gcn_i8_b0;
+         else /* beta == 1 */
+            tb = sgenkernels_gcn_i8_b1;
+         break;
+      default: 
+         return NULL;
+   }
+   if (kruntime && k >= bestk)
+      kk = bestk/GVLEN; /* GVLEN: generated kernels vlen */
+   else
+   {
+      kk = (k + GVLEN - 1) / GVLEN; /* last vector may be partial */
+      if (!k || !GS8_K_OK(k) || k > maxdim)
+         return NULL; 
+   }
+   return tb[kk-1];
+}
+#endif
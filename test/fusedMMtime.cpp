@@ -36,6 +36,7 @@
  * Added header file for general fusedMM 
  */
 #include "../fusedMM.h"
+#include "include/Reorder.h"
 
 /*
  * Check whether the system supports the desire int data type  
@@ -72,8 +73,9 @@
  * ============================================================================
  */
 
-/* API based on CSR */
-typedef void (*csr_mm_t) 
+/* API based on CSR, CIT: type of column indices */
+template <typename CIT>
+using csr_mm_t = void (*) 
 (
    const char tkern,       // kernel variations
    const INDEXTYPE m,      // rows of A 
@@ -84,7 +86,7 @@ typedef void (*csr_mm_t)
    const INDEXTYPE rows,   // number of rows for sparse matrix 
    const INDEXTYPE cols,   // number of columns for sparse matrix 
    const VALUETYPE *val,   // NNZ value  
-   const INDEXTYPE *indx,  // colids -> column indices 
+   const CIT *indx,        // colids -> column indices 
    const INDEXTYPE *pntrb, // starting index for rowptr
    const INDEXTYPE *pntre, // ending index for rowptr
    const VALUETYPE *a,     // Dense A (X) matrix
@@ -249,6 +251,53 @@ void SDDMMSPMMCsrSigmoid
    }		
 }
 
+template <typename IdType, typename DType>
+void SDDMMSPMMCsrSoftmax
+(
+   const IdType *indptr, 
+   const IdType *indices, 
+   const IdType *edges, 
+   const DType *X, 
+   const DType *Y, 
+   DType *O, 
+   const IdType N, 
+   const int64_t dim
+   ) 
+{
+#ifdef PTTIME 
+#pragma omp parallel for
+#endif
+   for (IdType rid = 0; rid < N; ++rid)
+   {
+      const IdType row_start = indptr[rid], row_end = indptr[rid + 1];
+      const IdType iindex = rid * dim;
+      DType *S = new DType[row_end - row_start + 1];
+      DType smax = -HUGE_VAL, ssum = 0;
+      for (IdType j = row_start; j < row_end; ++j)
+      {
+         const IdType jindex = indices[j] * dim;
+         DType attrc = 0;
+         for (int64_t k = 0; k < dim; ++k) 
+            attrc += X[iindex + k] * Y[jindex + k];
+         S[j-row_start] = attrc;
+         smax = (attrc > smax) ? attrc : smax;
+      }
+      for (IdType j = row_start; j < row_end; ++j)
+      {
+         S[j-row_start] = exp(S[j-row_start] - smax);
+         ssum += S[j-row_start];
+      }
+      for (IdType j = row_start; j < row_end; ++j)
+      {
+         const IdType jindex = indices[j] * dim;
+         DType d1 = S[j-row_start] / ssum;
+	 for (int64_t k = 0; k < dim; ++k) 
+            O[iindex+k] = O[iindex+k]  + d1 * Y[jindex + k];
+      }
+      delete[] S;
+   }		
+}
+
 template <typename IdType, typename DType>
 void TrustedFR
 (  const IdType *indptr,
@@ -363,6 +412,51 @@ void truested_gcn_csr
       }
    }
 }
+/*
+ * max ('x') or min ('n') of the rows of B of a row, C of an empty row is not 
+ * changed, doTesting_Acsr applies alpha and beta 
+ */
+void truested_maxmin_csr 
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const INDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+#ifdef PTTIME 
+   #pragma omp parallel for
+#endif
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      for (INDEXTYPE j=pntrb[i]; j < pntre[i]; j++)
+      {
+         for (INDEXTYPE kk=0; kk < k; kk++)
+         {
+            const VALUETYPE v = b[indx[j]*ldb+kk];
+
+            if (j == pntrb[i] || (tkern == 'x' ? v > c[i*ldc+kk] 
+                                               : v < c[i*ldc+kk]))
+               c[i*ldc+kk] = v;
+         }
+      }
+   }
+}
 /*===========================================================================
  *    Trusted kernels from MKL, works only for SPMM  
  * 
@@ -547,6 +641,10 @@ void mytrusted_csr
          SDDMMSPMMCsrSigmoid<INDEXTYPE, VALUETYPE> (pntrb, indx, NULL, a, b, c, 
                m, k);
          break;
+      case 'a' : // softmax
+         SDDMMSPMMCsrSoftmax<INDEXTYPE, VALUETYPE> (pntrb, indx, NULL, a, b, c, 
+               m, k);
+         break;
       case 'm' : // spmm
          //fprintf(stderr, "***Applying trusted spmm kernel\n");
          truested_spmm_csr(tkern, m, n, k, alpha, nnz, rows, cols, val, indx, 
@@ -557,6 +655,11 @@ void mytrusted_csr
          truested_gcn_csr(tkern, m, n, k, alpha, nnz, rows, cols, val, indx, 
                pntrb, pntre, a, lda, b, ldb, beta, c, ldc);
          break;
+      case 'x' : // max aggregation
+      case 'n' : // min aggregation
+         truested_maxmin_csr(tkern, m, n, k, alpha, nnz, rows, cols, val, 
+               indx, pntrb, pntre, a, lda, b, ldb, beta, c, ldc);
+         break;
       case 'f' :
 	 TrustedFR<INDEXTYPE, VALUETYPE> (pntrb, indx, NULL, a, b, c, m, k);
 	 break;
@@ -623,6 +726,8 @@ VALUETYPE tscale(VALUETYPE v)
  */
 
 extern "C" int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out);
+extern "C" int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, 
+      VALUETYPE *out);
 #ifdef SIGMOID_UDEF 
 // USER DEFINED FUNCTION for SOP with Sigmoid calc 
 int  SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
@@ -630,6 +735,12 @@ int  SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
    *out = 1.0 - ufast_SM(val);
    return FUSEDMM_SUCCESS_RETURN;
 }
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out)
+{
+   for (INDEXTYPE i = 0; i < n; i++)
+      out[i] = 1.0 - ufast_SM(in[i]);
+   return FUSEDMM_SUCCESS_RETURN;
+}
 #elif defined(FR_UDEF)
 // SOP_UDEF for FR model
 int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
@@ -637,6 +748,12 @@ int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
    *out = 1.0 + 1.0 / val;
    return FUSEDMM_SUCCESS_RETURN;
 }
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out)
+{
+   for (INDEXTYPE i = 0; i < n; i++)
+      out[i] = 1.0 + 1.0 / in[i];
+   return FUSEDMM_SUCCESS_RETURN;
+}
 #elif defined(TDIST_UDEF)
 // SOP_UDEF for t-distribution  model
 int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
@@ -644,6 +761,12 @@ int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
    *out = tscale(-2.0 / (1.0 + val));
    return FUSEDMM_SUCCESS_RETURN;
 }
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out)
+{
+   for (INDEXTYPE i = 0; i < n; i++)
+      out[i] = tscale(-2.0 / (1.0 + in[i]));
+   return FUSEDMM_SUCCESS_RETURN;
+}
 #elif defined(LL_UDEF)
 // SOP_UDEF for LL model
 int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
@@ -651,6 +774,12 @@ int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
    *out = log2(1 + sqrt(val));;
    return FUSEDMM_SUCCESS_RETURN;
 }
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out)
+{
+   for (INDEXTYPE i = 0; i < n; i++)
+      out[i] = log2(1 + sqrt(in[i]));
+   return FUSEDMM_SUCCESS_RETURN;
+}
 #elif defined(FA_UDEF)
 // SOP_UDEF for FA model
 int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
@@ -658,6 +787,12 @@ int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
    *out = sqrt(val) + 1.0 / val;;
    return FUSEDMM_SUCCESS_RETURN;
 } 
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out)
+{
+   for (INDEXTYPE i = 0; i < n; i++)
+      out[i] = sqrt(in[i]) + 1.0 / in[i];
+   return FUSEDMM_SUCCESS_RETURN;
+}
 #else 
 /*
  * NOTE: other kernels don't use SOP funciton (NOOP or COPY)
@@ -671,6 +806,12 @@ int SOP_UDEF_FUNC(VALUETYPE val, VALUETYPE *out)
    *out = val;;
    return FUSEDMM_SUCCESS_RETURN;
 } 
+int SOP_UDEF_BATCH_FUNC(INDEXTYPE n, const VALUETYPE *in, VALUETYPE *out)
+{
+   for (INDEXTYPE i = 0; i < n; i++)
+      out[i] = in[i];
+   return FUSEDMM_SUCCESS_RETURN;
+}
 #endif
 #if 0
 /*
@@ -712,7 +853,7 @@ void mytest_csr
    const INDEXTYPE rows,   // number of rows for sparse matrix 
    const INDEXTYPE cols,   // number of columns for sparse matrix 
    const VALUETYPE *val,   // NNZ value  
-   const INDEXTYPE *indx,  // colids -> column indices 
+   const COLINDEXTYPE *indx, // colids -> column indices 
    const INDEXTYPE *pntrb, // starting index for rowptr
    const INDEXTYPE *pntre, // ending index for rowptr
    const VALUETYPE *a,     // Dense A (X) matrix
@@ -743,6 +884,11 @@ void mytest_csr
          fusedMM_csr(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
                pntre, a, lda, b, ldb, beta, c, ldc);
          break;
+      case 'a' : // softmax (attention)
+         imsg = VOP_COPY_RHS | ROP_DOT | SOP_SOFTMAX | VSC_MUL | AOP_ADD;
+         fusedMM_csr(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
+               pntre, a, lda, b, ldb, beta, c, ldc);
+         break;
       case 'm' : // spmm
          imsg = VOP_COPY_RHS | ROP_NOOP | SOP_COPY | VSC_MUL | AOP_ADD;
          
@@ -752,6 +898,16 @@ void mytest_csr
       case 'g' : // gcn 
          imsg = VOP_COPY_RHS | ROP_NOOP | SOP_NOOP | VSC_NOOP | AOP_ADD;
          
+         fusedMM_csr(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
+               pntre, a, lda, b, ldb, beta, c, ldc);
+         break;
+      case 'x' : // max aggregation 
+         imsg = VOP_COPY_RHS | ROP_NOOP | SOP_NOOP | VSC_NOOP | AOP_MAX;
+         fusedMM_csr(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
+               pntre, a, lda, b, ldb, beta, c, ldc);
+         break;
+      case 'n' : // min aggregation 
+         imsg = VOP_COPY_RHS | ROP_NOOP | SOP_NOOP | VSC_NOOP | AOP_MIN;
          fusedMM_csr(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, pntrb, 
                pntre, a, lda, b, ldb, beta, c, ldc);
          break;
@@ -761,515 +917,1763 @@ void mytest_csr
    }
 }
 
-/* ============================================================================
- *       Tester framework 
- *          We calculate floating point error bound to check the results
- * ============================================================================
- */
 /*
- * Find epsilon for floating point data type in the system which represents the
- * smallest value which can be represented using the type
- * NOTE: this implementation is taken from ATLAS (math-atlas)
+ * message of the test kernel for the execution plan, 0 for unknown tkern 
  */
-template <typename NT> 
-NT Epsilon(void)
+int32_t GetTestMsg(const char tkern)
 {
-   static NT eps; 
-   const NT half=0.5; 
-   volatile NT maxval, f1=0.5; 
-
-   do
+   switch(tkern)
    {
-      eps = f1;
-      f1 *= half;
-      maxval = 1.0 + f1;
+      case 't' : // t-dist 
+      case 'f': // fr model 
+	 return VOP_SUBR | ROP_NORMR | SOP_UDEF | VSC_MUL | AOP_ADD;
+      case 's' : // sigmoid
+         uinit_SM_TABLE();    // create sigmoid table to use it from SOP_UDEF
+         return VOP_COPY_RHS | ROP_DOT | SOP_UDEF | VSC_MUL | AOP_ADD;
+      case 'a' : // softmax (attention)
+         return VOP_COPY_RHS | ROP_DOT | SOP_SOFTMAX | VSC_MUL | AOP_ADD;
+      case 'm' : // spmm
+         return VOP_COPY_RHS | ROP_NOOP | SOP_COPY | VSC_MUL | AOP_ADD;
+      case 'g' : // gcn 
+         return VOP_COPY_RHS | ROP_NOOP | SOP_NOOP | VSC_NOOP | AOP_ADD;
+      case 'x' : // max aggregation 
+         return VOP_COPY_RHS | ROP_NOOP | SOP_NOOP | VSC_NOOP | AOP_MAX;
+      case 'n' : // min aggregation 
+         return VOP_COPY_RHS | ROP_NOOP | SOP_NOOP | VSC_NOOP | AOP_MIN;
+      default:
+         printf("unknown trusted kernel\n");
+         break;
    }
-   while(maxval != 1.0);
-   return(eps);
+   return 0;
 }
-
 /*
- * test the results of the outputs element by element 
- *    C->MxN, NNZA = nonzeros, Md = max degree  
- *    C trusted, D computed 
+ * options of the plans created by the tester (-reorder, -vbidx, -sell), 
+ * all zero: default plan 
  */
-template <typename IT, typename NT>
-int doChecking(IT NNZA, IT M, IT N, IT Md, NT *C, NT *D, IT ldc)
-{
-   IT i, j, k;
-   NT diff, EPS; 
-   double ErrBound; 
-
-   int nerr = 0;
+static fusedMM_plan_opts_t PlanOpts = {0}; 
 /*
- * Error bound : depends on application to application (sigmoid, tdist, etc)
- *    General computations (SDDMM+SPMM) = K*NNZ + K*NNZ FMAC = 4*K*NNZ
- *    On an average, flop per element of C = 4*K*NNZ / M*K
+ * Same as mytest_csr but using the execution plan of fusedMM: plan is created,
+ * executed once and destroyed.  
  */
-   EPS = Epsilon<NT>();
-   // HERE, the idea is, we need to multiply the Epsilon with the number of 
-   // flops that one element of the output needs 
-   // NOTE: Need to multiply by 2 for the opposit direction of errors  
-   //    NOTE: considering max degree as N as upper bound. 
-   
-   // to produce each C element, we need to perform : SDDMM + SPMM
-#ifdef SIGMOID_UDEF 
-   //    SDDMM = 2*N*K + sigmoid = 6 + SPMM =  2*N*K
-   ErrBound = 2 * Md*(2*N+6+2*N) * EPS; // Here, N = K = dimension 
-#elif FR_UDEF
-   // SDDMM + SPMM 
-   ErrBound = 2 * Md*(3*N+2+2*N) * EPS; // Here, N = K = dimension 
-#elif TDIST_UDEF
-   // SDDMM + SPMM 
-   ErrBound = 2 * Md*(3*N+2+2*N) * EPS; // Here, N = K = dimension 
-#elif SPMM_UDEF
-   ErrBound = 2 * Md * 2*N * EPS; // Here, N = K = dimension 
-#elif GCN_UDEF
-   ErrBound = 2 *  Md * N * EPS; // Here, N = K = dimension 
-#else  // upper bound
-   ErrBound = 2 * 4 * (NNZA) * EPS; /* considering upper bound for now */
-#endif
-
-   //cout << "--- EPS = " << EPS << " ErrBound = " << ErrBound << endl; 
-   
-   for (i=0; i < M; i++)
+void mytestplan_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   fusedMM_plan_t *plan; 
+   if (!imsg)
+      return;
+   if (fusedMM_plan_create_ex(&plan, imsg, m, n, k, nnz, rows, cols, indx, 
+            pntrb, pntre, &PlanOpts) != FUSEDMM_SUCCESS_RETURN)
    {
-      for (j=0; j < N; j++)
-      {
-         k = i*ldc + j;
-         diff = C[k] - D[k];
-         if (diff < 0.0) diff = -diff; 
-         if (diff > ErrBound)
-         {
-      #if 0
-            fprintf(stderr, "C(%d,%d) : expected=%e, got=%e, diff=%e\n",
-                    i, j, C[k], D[k], diff);
-      #else // print single value... 
-            if (!i && !j)
-               fprintf(stderr, "C(%ld,%ld) : expected=%e, got=%e, diff=%e\n",
-                       i, j, C[k], D[k], diff);
-      #endif
-            nerr++;
-         }
-         else if (D[k] != D[k]) /* test for NaNs */
-         {
-            fprintf(stderr, "C(%ld,%ld) : expected=%e, got=%e\n",
-                    i, j, C[k], D[k]);
-            nerr++;
-
-         }
-      }
+      printf("failed to create plan\n");
+      exit(1);
    }
-   return(nerr);
+   fusedMM_plan_execute(plan, alpha, val, a, lda, b, ldb, beta, c, ldc);
+   fusedMM_plan_destroy(plan);
 }
 /*
- * Tester function, truested and test are templated function pointers 
+ * Same as mytestplan_csr but the plan works in the permuted space of the 
+ * reordered graph (opts.permuted): A, B and C are permuted before execute and
+ * C back after it  
  */
-template <csr_mm_t trusted, csr_mm_t test>
-int doTesting_Acsr
+void mytestpplan_csr
 (
-   CSR<INDEXTYPE,VALUETYPE> &S, 
-   INDEXTYPE M, 
-   INDEXTYPE N, 
-   INDEXTYPE K, 
-   VALUETYPE alpha, 
-   VALUETYPE beta,
-   int tkern
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
 )
 {
-   int nerr, szAligned; 
-   size_t i, j, szA, szB, szC, lda, ldc, ldb; 
-   VALUETYPE *pb, *b, *pc0, *c0, *pc, *c, *pa, *a, *values;
-
-   std::default_random_engine generator;
-   std::uniform_real_distribution<VALUETYPE> distribution(0.0,1.0);
-/*
- * NOTE: we are considering only row major A, B and C storage now
- *       A -> MxK, B->NxK, C->MxD  
- */
-   lda = ldb = ldc = K; // both row major, K multiple of VLEN 
-/*
- * NOTE: not sure about system's VLEN from this user code. So, make it cacheline
- * size aligned ....
- */
-   szAligned = ATL_Cachelen / sizeof(VALUETYPE);
-   szA = ((M*ldb+szAligned-1)/szAligned)*szAligned;  // szB in element
-   szB = ((N*ldb+szAligned-1)/szAligned)*szAligned;  // szB in element
-   szC = ((M*ldc+szAligned-1)/szAligned)*szAligned;  // szC in element 
-   
-   pa = (VALUETYPE*)malloc(szA*sizeof(VALUETYPE)+2*ATL_Cachelen);
-   assert(pa);
-   a = (VALUETYPE*) ATL_AlignPtr(pa);
-   
-   pb = (VALUETYPE*)malloc(szB*sizeof(VALUETYPE)+2*ATL_Cachelen);
-   assert(pb);
-   b = (VALUETYPE*) ATL_AlignPtr(pb);
-
-   pc0 = (VALUETYPE*)malloc(szC*sizeof(VALUETYPE)+2*ATL_Cachelen);
-   assert(pc0);
-   c0 = (VALUETYPE*) ATL_AlignPtr(pc0); 
-      
-   pc = (VALUETYPE*)malloc(szC*sizeof(VALUETYPE)+2*ATL_Cachelen);
-   assert(pc);
-   c = (VALUETYPE*) ATL_AlignPtr(pc); 
-   
-   // init   
-   for (i=0; i < szA; i++)
-   {
-   #if 1
-      a[i] = distribution(generator);  
-   #else
-      //a[i] = 1.0*i;  
-      a[i] = 0.5;  
-   #endif
-   }
-   for (i=0; i < szB; i++)
+   int32_t imsg = GetTestMsg(tkern); 
+   fusedMM_plan_t *plan; 
+   const INDEXTYPE *perm; 
+   VALUETYPE *pa, *pb, *pc; 
+   if (!imsg)
+      return;
+   PlanOpts.permuted = 1; 
+   if (fusedMM_plan_create_ex(&plan, imsg, m, n, k, nnz, rows, cols, indx, 
+            pntrb, pntre, &PlanOpts) != FUSEDMM_SUCCESS_RETURN)
    {
-   #if 1
-      b[i] = distribution(generator);  
-   #else
-      //b[i] = 1.0*i;  
-      b[i] = 0.5;  
-   #endif
+      printf("failed to create plan\n");
+      exit(1);
    }
-   for (i=0; i < szC; i++)
+   PlanOpts.permuted = 0; 
+   perm = fusedMM_plan_perm(plan);
+   if (!perm) // plan does not reorder, operands stay in original order 
    {
-   #if 0
-      c[i] = c0[i] = distribution(generator);  
-   #else  /* to test beta0 case */
-      c[i] = 0.0; c0[i] = 0.0;
-   #endif
+      fusedMM_plan_execute(plan, alpha, val, a, lda, b, ldb, beta, c, ldc);
+      fusedMM_plan_destroy(plan);
+      return;
    }
-  
-   if (M > S.rows) M = S.rows; // M can't be greater than A.rows  
-/*
- *    csr may consists all 1 as values... init with random values
- */
-   values = (VALUETYPE*)malloc(S.nnz*sizeof(VALUETYPE));
-   assert(values);
-   for (i=0; i < S.nnz; i++)
-      values[i] = distribution(generator);  
-/*
- * Let's apply trusted and test kernels 
- */
-   fprintf(stdout, "Applying trusted kernel\n");
-   trusted(tkern, M, N, K, alpha, S.nnz, S.rows, S.cols, values, 
-           S.colids, S.rowptr, S.rowptr+1, a, lda, b, ldb, beta, c0, ldc);   
-   
-   fprintf(stdout, "Applying test kernel\n");
-   test(tkern, M, N, K, alpha, S.nnz, S.rows, S.cols, values, 
-         S.colids, S.rowptr, S.rowptr+1, a, lda, b, ldb, beta, c, ldc);   
-/*
- * check for errors 
- */
-   nerr = doChecking<INDEXTYPE, VALUETYPE>(S.nnz, M, K, N, c0, c, ldc);
-
-   free(values);
-   free(pc0);
+   pa = (VALUETYPE*)malloc(m*k*sizeof(VALUETYPE));
+   pb = (VALUETYPE*)malloc(n*k*sizeof(VALUETYPE));
+   pc = (VALUETYPE*)malloc(m*k*sizeof(VALUETYPE));
+   assert(pa && pb && pc);
+   fusedMM_permute_dense(0, m, k, perm, a, lda, pa, k);
+   fusedMM_permute_dense(0, n, k, perm, b, ldb, pb, k);
+   fusedMM_permute_dense(0, m, k, perm, c, ldc, pc, k);
+   fusedMM_plan_execute(plan, alpha, val, pa, k, pb, k, beta, pc, k);
+   fusedMM_permute_dense(1, m, k, perm, pc, k, c, ldc);
+   fusedMM_plan_destroy(plan);
    free(pc);
    free(pb);
    free(pa);
-
-   return(nerr);
 }
-/*==============================================================================
- *    Timer framework  
- *
- *============================================================================*/
 /*
- * NOTE: kernel timer prototype, typedef template function pointer   
+ * dtype of half precision X and Y (-half), 0: not used. doTesting_Acsr rounds
+ * A and B to it, so trusted kernel sees the values stored by the test kernel 
  */
-template <typename IT>
-using csr_timer_t = vector<double> (*) 
-(
-   const int tkern,        // kernel type
-   const int nrep,         // number of repetition  
-   const IT M,             // rows of A 
-   const IT N,             // rows of B
-   const IT K,             // feature dimension: col of A and B
-   const VALUETYPE alpha,  // alpha, not used yet
-   const IT nnz,           // nonzeros
-   const IT rows,          // rows of sparse matrix
-   const IT cols,          // col of sparse matrix 
-   VALUETYPE *values,      // nonzero values
-   IT *rowptr,             // rowptr of sparse matrix 
-   IT *colids,             // col id of sparse matrix 
-   const VALUETYPE *a,     // Dense A matrix
-   const IT lda,           // leading dimension of A 
-   const VALUETYPE *b,     // Dense B matrix
-   const IT ldb,           // leading dimension of B
-   const VALUETYPE beta,   // beta  
-   VALUETYPE *c,           // Dense C matrix
-   const IT ldc            // leading dimension of C
-);
-// Cache flushing timer 
-template <typename IT>
-using csr_timer_cf_t = vector<double> (*) 
-(
-   const IT ndsets,        // number of data set
-   const IT wdsz,          // data workspace size
-   const IT nisets,        // number of index set
-   const IT wisz,          // index workspace size
-   const int nrep,         // number of repetition 
-   const int tkern,        // kernel type
-   const IT M,             // rows of A 
-   const IT N,             // rows of B
-   const IT K,             // feature dimension: cols of A and B
-   const VALUETYPE alpha,  // alpha, not used yet
-   const IT nnz,           // nonzeros
-   const IT rows,          // rows of sparse matrix
-   const IT cols,          // cols of sparse matrix
-   VALUETYPE *values,      // nnz values
-   IT *rowptr,             // row pointer of sparse 
-   IT *colids,             // colid of sparse
-   const VALUETYPE *a,     // dense A 
-   const IT lda,           // leading dimension of A
-   const VALUETYPE *b,     // dense B
-   const IT ldb,           // leading dimension of B
-   const VALUETYPE beta,   // beta
-   VALUETYPE *c,           // dense C
-   const IT ldc            // leading dimension of C
-);
+static int HalfType = 0; 
+
+VALUETYPE RoundHalf(VALUETYPE v)
+{
+   uint16_t h; 
+   fusedMM_cvt_half(HalfType, 1, &v, &h);
+   fusedMM_cvt_float(HalfType, 1, &h, &v);
+   return v; 
+}
 /*
- * Kernel timer wrapper for trusted kernel.. 
- * This wrapper handles all extra setup needed to call a library, 
- * For Example: MKL uses inspection and execution model  
+ * Same as mytest_csr but A and B are converted to HalfType and computed by 
+ * fusedMM_csr_half  
  */
-vector<double> callTimerTrusted_Acsr
+void mytesthalf_csr
 (
-   const int tkern,        // kernel type
-   const int nrep,         // number of repetition  
-   const INDEXTYPE M,      // rows of A 
-   const INDEXTYPE N,      // rows of B
-   const INDEXTYPE K,      // feature dimension: col of A and B
-   const VALUETYPE alpha,  // alpha, not used yet
-   const INDEXTYPE nnz,    // nonzeros
-   const INDEXTYPE rows,   // rows of sparse matrix
-   const INDEXTYPE cols,   // col of sparse matrix 
-   VALUETYPE *values,      // nonzero values 
-   INDEXTYPE *rowptr,      // rowptr of sparse matrix 
-   INDEXTYPE *colids,      // col id of sparse matrix 
-   const VALUETYPE *a,     // Dense A matrix  
-   const INDEXTYPE lda,    // leading dimension of A 
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
    const VALUETYPE *b,     // Dense B matrix
-   const INDEXTYPE ldb,    // leading dimension of B
-   const VALUETYPE beta,   // beta  
-   VALUETYPE *c,           // Dense C matrix
-   const INDEXTYPE ldc     // leading dimension of C
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
 )
 {
-   double start, end;
-   vector <double> results;    
+   int32_t imsg = GetTestMsg(tkern); 
+   uint16_t *ha, *hb; 
+   if (!imsg)
+      return;
+   ha = (uint16_t*)malloc(m*lda*sizeof(uint16_t));
+   hb = (uint16_t*)malloc(n*ldb*sizeof(uint16_t));
+   assert(ha && hb);
+   fusedMM_cvt_half(HalfType, m*lda, a, ha);
+   fusedMM_cvt_half(HalfType, n*ldb, b, hb);
+   if (fusedMM_csr_half(imsg, HalfType, m, n, k, alpha, nnz, rows, cols, val, 
+            indx, pntrb, pntre, ha, lda, hb, ldb, beta, c, ldc) 
+         != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csr_half\n");
+      exit(1);
+   }
+   free(hb);
+   free(ha);
+}
 /*
- * NOTE: 
- *    flag can be used to select different option, like: ROW_MAJOR, 
- *    INDEX_BASE_ZERO. For now, we only support following options (no checking):
- *       SPARSE_INDEX_BASE_ZERO
- *       SPARSE_OPERATION_NON_TRANSPOSE
- *       SPARSE_LAYOUT_ROW_MAJOR
+ * int8 B (-i8): doTesting_Acsr replaces B by its dequantized values, which 
+ * are quantized to the same int8 again by the test kernel  
  */
-   // timing inspector phase 
+static int I8Type = 0; 
+
+void RoundI8(const INDEXTYPE n, const INDEXTYPE k, VALUETYPE *b, 
+      const INDEXTYPE ldb)
+{
+   int8_t *q = (int8_t*)malloc(k*sizeof(int8_t));
+   VALUETYPE bq[2]; 
+   assert(q);
+   for (INDEXTYPE j=0; j < n; j++)
    {
-      results.push_back(0.0); // no inspection phase 
+      fusedMM_quantize_i8(1, k, b+j*ldb, ldb, q, k, bq);
+      for (INDEXTYPE kk=0; kk < k; kk++)
+         b[j*ldb+kk] = bq[0] * (q[kk] - bq[1]);
    }
-   
-   mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
-              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
-   
-   start = omp_get_wtime();
-   for (int i=0; i < nrep; i++)
+   free(q);
+}
+/*
+ * Same as mytest_csr but B is quantized to int8 and computed by 
+ * fusedMM_csr_i8 
+ */
+void mytesti8_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   int8_t *qb; 
+   VALUETYPE *bq; 
+   if (!imsg)
+      return;
+   qb = (int8_t*)malloc(n*ldb*sizeof(int8_t));
+   bq = (VALUETYPE*)malloc(2*n*sizeof(VALUETYPE));
+   assert(qb && bq);
+   fusedMM_quantize_i8(n, k, b, ldb, qb, ldb, bq);
+   if (fusedMM_csr_i8(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, 
+            pntrb, pntre, a, lda, qb, ldb, bq, beta, c, ldc) 
+         != FUSEDMM_SUCCESS_RETURN)
    {
-      mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
-                 colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+      printf("failed to run fusedMM_csr_i8\n");
+      exit(1);
    }
-   end = omp_get_wtime();
-   results.push_back((end-start)/((double)nrep)); // execution time 
-
-   return(results);
+   free(bq);
+   free(qb);
 }
+/*
+ * multi-head (-mh): number of heads, 0: not used. Trusted kernel is applied to 
+ * each head separately, head h of A, B and C is copied to a matrix of 
+ * k/MhHeads columns since the trusted sigmoid and t-dist ignore lda 
+ */
+static INDEXTYPE MhHeads = 0; 
 
-// Cache flushing timer 
-// NOTE: If the dataset is small enough to fit in cache, we want to use this 
-// cache flushing timer. calling for all cases now since for larger data, it will 
-// create only one working set 
-vector<double> callCFTimerTrusted_Acsr
+void mytrustedmh_csr
 (
-   const INDEXTYPE ndsets,    // number of data set in cache
-   const INDEXTYPE wdsz,      // data workspace size in cache
-   const INDEXTYPE nisets,    // number of index set in cache
-   const INDEXTYPE wisz,      // index workspace size in cache
-   const int nrep,            // number of repetition
-   const int tkern,           // kernel type 
-   const INDEXTYPE M,         // rows of A
-   const INDEXTYPE N,         // rows of B
-   const INDEXTYPE K,         // col of A and B
-   const VALUETYPE alpha,     // not used
-   const INDEXTYPE nnz,       // non zeros
-   const INDEXTYPE rows,      // rows of sparse matrix
-   const INDEXTYPE cols,      // cols of sparse matrix
-   VALUETYPE *values,         // non zero values
-   INDEXTYPE *rowptr,         // row ptr of sparse
-   INDEXTYPE *colids,         // col id of sparse
-   const VALUETYPE *a,        // dense A
-   const INDEXTYPE lda,       // lda of A
-   const VALUETYPE *b,        // dense B
-   const INDEXTYPE ldb,       // ld of B
-   const VALUETYPE beta,      // beta
-   VALUETYPE *c,              // dense C
-   const INDEXTYPE ldc        // ld of C
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const INDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   const INDEXTYPE dh = k / MhHeads; 
+   VALUETYPE *ha, *hb, *hc; 
+
+   ha = (VALUETYPE*)malloc(m*dh*sizeof(VALUETYPE));
+   hb = (VALUETYPE*)malloc(n*dh*sizeof(VALUETYPE));
+   hc = (VALUETYPE*)malloc(m*dh*sizeof(VALUETYPE));
+   assert(ha && hb && hc);
+   for (INDEXTYPE h = 0; h < k; h += dh)
+   {
+      for (INDEXTYPE i = 0; i < m; i++)
+         for (INDEXTYPE kk = 0; kk < dh; kk++)
+         {
+            ha[i*dh+kk] = a[i*lda+h+kk];
+            hc[i*dh+kk] = c[i*ldc+h+kk];
+         }
+      for (INDEXTYPE j = 0; j < n; j++)
+         for (INDEXTYPE kk = 0; kk < dh; kk++)
+            hb[j*dh+kk] = b[j*ldb+h+kk];
+      mytrusted_csr(tkern, m, n, dh, alpha, nnz, rows, cols, val, indx, pntrb,
+            pntre, ha, dh, hb, dh, beta, hc, dh);
+      for (INDEXTYPE i = 0; i < m; i++)
+         for (INDEXTYPE kk = 0; kk < dh; kk++)
+            c[i*ldc+h+kk] = hc[i*dh+kk];
+   }
+   free(hc);
+   free(hb);
+   free(ha);
+}
+/*
+ * Same as mytest_csr but computed by fusedMM_csr_mh with MhHeads heads 
+ */
+void mytestmh_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   if (!imsg)
+      return;
+   if (fusedMM_csr_mh(imsg, MhHeads, m, n, k, alpha, nnz, rows, cols, val, 
+            indx, pntrb, pntre, a, lda, b, ldb, beta, c, ldc) 
+         != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csr_mh\n");
+      exit(1);
+   }
+}
+/*
+ * transposed execution (-csc): doTesting_Acsr is called with the CSR of S^T, 
+ * which is the CSC of S (CSR(S_csc, true)). mytestcsc_csr passes it to 
+ * fusedMM_csc as the CSC of S (rows and cols of S are swapped back) 
+ */
+void mytestcsc_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   if (!imsg)
+      return;
+   if (fusedMM_csc(imsg, m, n, k, alpha, nnz, cols, rows, val, indx, pntrb, 
+            pntre, a, lda, b, ldb, beta, c, ldc) != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csc\n");
+      exit(1);
+   }
+}
+/*
+ * transposed plan (-csc with -T 2): S is recovered in CSR by transposing the
+ * given CSR of S^T, the plan transposes it back internally 
+ */
+void mytesttplan_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   fusedMM_plan_t *plan; 
+   COLINDEXTYPE *sindx; 
+   INDEXTYPE *srowptr; 
+   VALUETYPE *sval; 
+   if (!imsg)
+      return;
+   sindx = (COLINDEXTYPE*)malloc((nnz+1)*sizeof(COLINDEXTYPE));
+   srowptr = (INDEXTYPE*)malloc((cols+1)*sizeof(INDEXTYPE));
+   sval = (VALUETYPE*)malloc((nnz+1)*sizeof(VALUETYPE));
+   assert(sindx && srowptr && sval);
+   fusedMM_csr2csc(rows, cols, indx, pntrb, pntre, val, sindx, srowptr, sval,
+         NULL);
+   PlanOpts.transpose = 1;
+   if (fusedMM_plan_create_ex(&plan, imsg, m, n, k, nnz, cols, rows, sindx, 
+            srowptr, srowptr+1, &PlanOpts) != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to create plan\n");
+      exit(1);
+   }
+   PlanOpts.transpose = 0;
+   fusedMM_plan_execute(plan, alpha, sval, a, lda, b, ldb, beta, c, ldc);
+   fusedMM_plan_destroy(plan);
+   free(sval);
+   free(srowptr);
+   free(sindx);
+}
+
+/* ============================================================================
+ *       Tester framework 
+ *          We calculate floating point error bound to check the results
+ * ============================================================================
+ */
+/*
+ * Find epsilon for floating point data type in the system which represents the
+ * smallest value which can be represented using the type
+ * NOTE: this implementation is taken from ATLAS (math-atlas)
+ */
+template <typename NT> 
+NT Epsilon(void)
+{
+   static NT eps; 
+   const NT half=0.5; 
+   volatile NT maxval, f1=0.5; 
+
+   do
+   {
+      eps = f1;
+      f1 *= half;
+      maxval = 1.0 + f1;
+   }
+   while(maxval != 1.0);
+   return(eps);
+}
+
+/*
+ * test the results of the outputs element by element 
+ *    C->MxN, NNZA = nonzeros, Md = max degree  
+ *    C trusted, D computed 
+ */
+template <typename IT, typename NT>
+int doChecking(IT NNZA, IT M, IT N, IT Md, NT *C, NT *D, IT ldc)
+{
+   IT i, j, k;
+   NT diff, EPS; 
+   double ErrBound; 
+
+   int nerr = 0;
+/*
+ * Error bound : depends on application to application (sigmoid, tdist, etc)
+ *    General computations (SDDMM+SPMM) = K*NNZ + K*NNZ FMAC = 4*K*NNZ
+ *    On an average, flop per element of C = 4*K*NNZ / M*K
+ */
+   EPS = Epsilon<NT>();
+   // HERE, the idea is, we need to multiply the Epsilon with the number of 
+   // flops that one element of the output needs 
+   // NOTE: Need to multiply by 2 for the opposit direction of errors  
+   //    NOTE: considering max degree as N as upper bound. 
+   
+   // to produce each C element, we need to perform : SDDMM + SPMM
+#ifdef SIGMOID_UDEF 
+   //    SDDMM = 2*N*K + sigmoid = 6 + SPMM =  2*N*K
+   ErrBound = 2 * Md*(2*N+6+2*N) * EPS; // Here, N = K = dimension 
+#elif FR_UDEF
+   // SDDMM + SPMM 
+   ErrBound = 2 * Md*(3*N+2+2*N) * EPS; // Here, N = K = dimension 
+#elif TDIST_UDEF
+   // SDDMM + SPMM 
+   ErrBound = 2 * Md*(3*N+2+2*N) * EPS; // Here, N = K = dimension 
+#elif SOFTMAX_UDEF
+   // SDDMM + exp + SPMM 
+   ErrBound = 2 * Md*(2*N+20+2*N) * EPS; // Here, N = K = dimension 
+#elif SPMM_UDEF
+   ErrBound = 2 * Md * 2*N * EPS; // Here, N = K = dimension 
+#elif GCN_UDEF
+   ErrBound = 2 *  Md * N * EPS; // Here, N = K = dimension 
+#else  // upper bound
+   ErrBound = 2 * 4 * (NNZA) * EPS; /* considering upper bound for now */
+#endif
+
+   //cout << "--- EPS = " << EPS << " ErrBound = " << ErrBound << endl; 
+   
+   for (i=0; i < M; i++)
+   {
+      for (j=0; j < N; j++)
+      {
+         k = i*ldc + j;
+         diff = C[k] - D[k];
+         if (diff < 0.0) diff = -diff; 
+         if (diff > ErrBound)
+         {
+      #if 0
+            fprintf(stderr, "C(%d,%d) : expected=%e, got=%e, diff=%e\n",
+                    i, j, C[k], D[k], diff);
+      #else // print single value... 
+            if (!i && !j)
+               fprintf(stderr, "C(%ld,%ld) : expected=%e, got=%e, diff=%e\n",
+                       i, j, C[k], D[k], diff);
+      #endif
+            nerr++;
+         }
+         else if (D[k] != D[k]) /* test for NaNs */
+         {
+            fprintf(stderr, "C(%ld,%ld) : expected=%e, got=%e\n",
+                    i, j, C[k], D[k]);
+            nerr++;
+
+         }
+      }
+   }
+   return(nerr);
+}
+/*
+ * per-edge output (-edge): mytestedge_csr computes C by fusedMM_csr_edge and 
+ * checks the scalars of the edges, with C and in SDDMM-only mode, against ROP
+ * and SOP of each edge computed here. EdgeErr: number of wrong scalars 
+ */
+static int EdgeErr = 0; 
+
+int doEdgeChecking
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE *val,   // NNZ value, NULL: pattern only (1.0)  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A 
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B 
+   const VALUETYPE *eout   // scalars of the edges 
+)
+{
+   int nerr = 0;
+   const double ErrBound = 2 * (3*k+6) * Epsilon<VALUETYPE>(); 
+
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+      {
+         const VALUETYPE *Ai = a + i * lda, *Bj = b + indx[j] * ldb; 
+         VALUETYPE d = 0.0, out = val ? val[j] : 1.0, diff; 
+
+         if (tkern == 's')
+         {
+            for (INDEXTYPE kk = 0; kk < k; kk++)
+               d += Ai[kk] * Bj[kk];
+            SOP_UDEF_FUNC(d, &out);
+         }
+         else if (tkern == 't')
+         {
+            for (INDEXTYPE kk = 0; kk < k; kk++)
+               d += (Ai[kk] - Bj[kk]) * (Ai[kk] - Bj[kk]);
+            SOP_UDEF_FUNC(d, &out);
+         }
+         diff = out - eout[j]; 
+         if (diff < 0.0) diff = -diff; 
+         if (diff > ErrBound * (out < 0.0 ? 1.0 - out : 1.0 + out) 
+               || eout[j] != eout[j])
+         {
+            if (!nerr)
+               fprintf(stderr, "edge(%ld) : expected=%e, got=%e\n",
+                       (long) j, out, eout[j]);
+            nerr++;
+         }
+      }
+   }
+   return(nerr);
+}
+/*
+ * Same as mytest_csr but computed by fusedMM_csr_edge, scalars of the edges 
+ * are checked with C and in SDDMM-only mode (C is not updated), also without
+ * values (pattern only) 
+ */
+void mytestedge_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   VALUETYPE *eout; 
+
+   if (!imsg)
+      return;
+   eout = (VALUETYPE*)malloc(nnz*sizeof(VALUETYPE));
+   assert(eout);
+   if (fusedMM_csr_edge(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, 
+            pntrb, pntre, a, lda, b, ldb, beta, c, ldc, eout) 
+         != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csr_edge\n");
+      exit(1);
+   }
+   EdgeErr += doEdgeChecking(tkern, m, k, val, indx, pntrb, pntre, a, lda, b,
+         ldb, eout);
+   for (INDEXTYPE j = 0; j < nnz; j++)
+      eout[j] = 0.0; 
+   if (fusedMM_csr_edge(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, 
+            pntrb, pntre, a, lda, b, ldb, beta, NULL, ldc, eout) 
+         != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csr_edge without Z\n");
+      exit(1);
+   }
+   EdgeErr += doEdgeChecking(tkern, m, k, val, indx, pntrb, pntre, a, lda, b,
+         ldb, eout);
+   for (INDEXTYPE j = 0; j < nnz; j++)
+      eout[j] = 0.0; 
+   if (fusedMM_csr_edge(imsg, m, n, k, alpha, nnz, rows, cols, NULL, indx, 
+            pntrb, pntre, a, lda, b, ldb, beta, NULL, ldc, eout) 
+         != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csr_edge without values\n");
+      exit(1);
+   }
+   EdgeErr += doEdgeChecking(tkern, m, k, NULL, indx, pntrb, pntre, a, lda, b,
+         ldb, eout);
+   free(eout);
+}
+/*
+ * degree normalization (-norm): NormType is FUSEDMM_NORM_SYM or _MEAN, 0: not
+ * used. Trusted spmm is called on the values scaled by the degrees computed 
+ * here, mytestnorm_csr lets fusedMM_csr_norm compute them (spmm and gcn) 
+ */
+static int NormType = 0; 
+
+void mytrustednorm_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const INDEXTYPE *indx,  // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   VALUETYPE *ds, *sval; 
+
+   ds = (VALUETYPE*)malloc(m*sizeof(VALUETYPE));
+   sval = (VALUETYPE*)malloc((nnz+1)*sizeof(VALUETYPE));
+   assert(ds && sval);
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      const INDEXTYPE deg = pntre[i] - pntrb[i]; 
+
+      if (!deg)
+         ds[i] = 0.0;
+      else
+         ds[i] = (NormType == FUSEDMM_NORM_SYM) ? 1.0 / sqrt((double)deg) 
+                                                : 1.0 / deg;
+   }
+   for (INDEXTYPE i = 0; i < m; i++)
+      for (INDEXTYPE j = pntrb[i]; j < pntre[i]; j++)
+         sval[j] = ds[i] * (tkern == 'm' ? val[j] : 1.0) 
+                   * (NormType == FUSEDMM_NORM_SYM ? ds[indx[j]] : 1.0);
+   mytrusted_csr('m', m, n, k, alpha, nnz, rows, cols, sval, indx, pntrb, 
+         pntre, a, lda, b, ldb, beta, c, ldc);
+   free(sval);
+   free(ds);
+}
+/*
+ * Same as mytest_csr but computed by fusedMM_csr_norm, scales are computed 
+ * from the degrees by the library 
+ */
+void mytestnorm_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   if (!imsg)
+      return;
+   if (fusedMM_csr_norm(imsg, NormType, NULL, NULL, m, n, k, alpha, nnz, 
+            rows, cols, val, indx, pntrb, pntre, a, lda, b, ldb, beta, c, ldc)
+         != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csr_norm\n");
+      exit(1);
+   }
+}
+/*
+ * argmax output (-arg): mytestarg_csr computes C by fusedMM_csr_arg and checks
+ * that the nonzero recorded for each feature gave it. ArgErr: number of wrong
+ * entries of arg 
+ */
+static int ArgErr = 0; 
+
+void mytestarg_csr
+(
+   const char tkern,       // kernel variations
+   const INDEXTYPE m,      // rows of A 
+   const INDEXTYPE n,      // rows of B
+   const INDEXTYPE k,      // dimension: col of A and B
+   const VALUETYPE alpha,  // not used yet  
+   const INDEXTYPE nnz,    // nonzeros  
+   const INDEXTYPE rows,   // number of rows for sparse matrix 
+   const INDEXTYPE cols,   // number of columns for sparse matrix 
+   const VALUETYPE *val,   // NNZ value  
+   const COLINDEXTYPE *indx, // colids -> column indices 
+   const INDEXTYPE *pntrb, // starting index for rowptr
+   const INDEXTYPE *pntre, // ending index for rowptr
+   const VALUETYPE *a,     // Dense A (X) matrix
+   const INDEXTYPE lda,    // leading dimension of A (col size since A row-major)  
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B (col size since B row-major)  
+   const VALUETYPE beta,   // beta value 
+   VALUETYPE *c,           // Dense matrix c
+   const INDEXTYPE ldc     // leading dimension of c (col size since C row-major) 
+)
+{
+   int32_t imsg = GetTestMsg(tkern); 
+   INDEXTYPE *arg; 
+
+   if (!imsg)
+      return;
+   arg = (INDEXTYPE*)malloc(m*ldc*sizeof(INDEXTYPE));
+   assert(arg);
+   if (fusedMM_csr_arg(imsg, m, n, k, alpha, nnz, rows, cols, val, indx, 
+            pntrb, pntre, a, lda, b, ldb, beta, c, ldc, arg) 
+         != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to run fusedMM_csr_arg\n");
+      exit(1);
+   }
+   for (INDEXTYPE i = 0; i < m; i++)
+   {
+      for (INDEXTYPE kk = 0; kk < k; kk++)
+      {
+         const INDEXTYPE j = arg[i*ldc+kk]; 
+/*
+ *       -1: C won (beta != 0) or the row is empty 
+ */
+         if (j == -1 && (pntrb[i] == pntre[i] || beta != 0.0))
+            continue;
+         if (j < pntrb[i] || j >= pntre[i] 
+               || alpha * b[indx[j]*ldb+kk] != c[i*ldc+kk])
+         {
+            if (!ArgErr)
+               fprintf(stderr, "arg(%ld,%ld) : got=%ld\n", (long) i, 
+                       (long) kk, (long) j);
+            ArgErr++;
+         }
+      }
+   }
+   free(arg);
+}
+/*
+ * Tester function, truested and test are templated function pointers 
+ */
+template <csr_mm_t<INDEXTYPE> trusted, csr_mm_t<COLINDEXTYPE> test>
+int doTesting_Acsr
+(
+   CSR<INDEXTYPE,VALUETYPE> &S, 
+   INDEXTYPE M, 
+   INDEXTYPE N, 
+   INDEXTYPE K, 
+   VALUETYPE alpha, 
+   VALUETYPE beta,
+   int tkern,
+   INDEXTYPE ldpad  // padding of leading dimensions, tests strided sub-views
+)
+{
+   int nerr, szAligned; 
+   size_t i, j, szA, szB, szC, lda, ldc, ldb; 
+   VALUETYPE *pb, *b, *pc0, *c0, *pc, *c, *pa, *a, *values;
+   VALUETYPE *ta, *tb, *tc;
+   COLINDEXTYPE *colids;
+   const VALUETYPE padval = -7.0; // sentinel for padding of C, must not change
+
+   std::default_random_engine generator;
+   std::uniform_real_distribution<VALUETYPE> distribution(0.0,1.0);
+/*
+ * NOTE: we are considering only row major A, B and C storage now
+ *       A -> MxK, B->NxK, C->MxD  
+ */
+   lda = ldb = ldc = K + ldpad; // both row major 
+/*
+ * NOTE: not sure about system's VLEN from this user code. So, make it cacheline
+ * size aligned ....
+ */
+   szAligned = ATL_Cachelen / sizeof(VALUETYPE);
+   szA = ((M*lda+szAligned-1)/szAligned)*szAligned;  // szA in element
+   szB = ((N*ldb+szAligned-1)/szAligned)*szAligned;  // szB in element
+   szC = ((M*ldc+szAligned-1)/szAligned)*szAligned;  // szC in element 
+   
+   pa = (VALUETYPE*)malloc(szA*sizeof(VALUETYPE)+2*ATL_Cachelen);
+   assert(pa);
+   a = (VALUETYPE*) ATL_AlignPtr(pa);
+   
+   pb = (VALUETYPE*)malloc(szB*sizeof(VALUETYPE)+2*ATL_Cachelen);
+   assert(pb);
+   b = (VALUETYPE*) ATL_AlignPtr(pb);
+
+   pc0 = (VALUETYPE*)malloc(szC*sizeof(VALUETYPE)+2*ATL_Cachelen);
+   assert(pc0);
+   c0 = (VALUETYPE*) ATL_AlignPtr(pc0); 
+      
+   pc = (VALUETYPE*)malloc(szC*sizeof(VALUETYPE)+2*ATL_Cachelen);
+   assert(pc);
+   c = (VALUETYPE*) ATL_AlignPtr(pc); 
+   
+   // init   
+   for (i=0; i < szA; i++)
+   {
+   #if 1
+      a[i] = distribution(generator);  
+   #else
+      //a[i] = 1.0*i;  
+      a[i] = 0.5;  
+   #endif
+   }
+   for (i=0; i < szB; i++)
+   {
+   #if 1
+      b[i] = distribution(generator);  
+   #else
+      //b[i] = 1.0*i;  
+      b[i] = 0.5;  
+   #endif
+   }
+   if (HalfType) /* A and B as stored in half precision */
+   {
+      for (i=0; i < szA; i++)
+         a[i] = RoundHalf(a[i]);
+      for (i=0; i < szB; i++)
+         b[i] = RoundHalf(b[i]);
+   }
+   if (I8Type) /* B as stored in int8 */
+      RoundI8(N, K, b, ldb);
+   for (i=0; i < szC; i++)
+   {
+   #if 0
+      c[i] = c0[i] = distribution(generator);  
+   #else  /* to test beta0 case, C is random otherwise */
+      c0[i] = 0.0;
+      c[i] = (beta == 0.0) ? 0.0 : distribution(generator);
+   #endif
+   }
+   for (i=0; i < M; i++)
+      for (j=K; j < ldc; j++)
+         c[i*ldc+j] = padval;
+  
+   if (M > S.rows) M = S.rows; // M can't be greater than A.rows  
+/*
+ *    csr may consists all 1 as values... init with random values
+ */
+   values = (VALUETYPE*)malloc(S.nnz*sizeof(VALUETYPE));
+   assert(values);
+   for (i=0; i < S.nnz; i++)
+      values[i] = distribution(generator);  
+/*
+ * test kernel takes column indices of the library type (COLINDEXTYPE)
+ */
+   colids = (COLINDEXTYPE*)malloc(S.nnz*sizeof(COLINDEXTYPE));
+   assert(colids);
+   for (i=0; i < S.nnz; i++)
+      colids[i] = S.colids[i];
+/*
+ * Let's apply trusted and test kernels 
+ */
+   fprintf(stdout, "Applying trusted kernel\n");
+/*
+ * trusted kernels assume packed operands, pack A and B for them when padded 
+ */
+   ta = a; tb = b; tc = c0;
+   if (ldpad)
+   {
+      ta = (VALUETYPE*)malloc(M*K*sizeof(VALUETYPE));
+      tb = (VALUETYPE*)malloc(N*K*sizeof(VALUETYPE));
+      tc = (VALUETYPE*)calloc(M*K, sizeof(VALUETYPE));
+      assert(ta && tb && tc);
+      for (i=0; i < M; i++)
+         for (j=0; j < K; j++)
+            ta[i*K+j] = a[i*lda+j];
+      for (i=0; i < N; i++)
+         for (j=0; j < K; j++)
+            tb[i*K+j] = b[i*ldb+j];
+   }
+   trusted(tkern, M, N, K, alpha, S.nnz, S.rows, S.cols, values, 
+           S.colids, S.rowptr, S.rowptr+1, ta, K, tb, K, beta, tc, K);   
+   if (ldpad)
+   {
+      for (i=0; i < M; i++)
+         for (j=0; j < K; j++)
+            c0[i*ldc+j] = tc[i*K+j];
+      free(tc);
+      free(tb);
+      free(ta);
+   }
+/*
+ * trusted kernels compute only func: C0 = alpha * func + beta * C, max and min
+ * take beta * C in the aggregation instead: C0 = max(alpha * func, beta * C)
+ */
+   if (tkern == 'x' || tkern == 'n')
+   {
+      for (i=0; i < M; i++)
+      {
+         for (j=0; j < ldc; j++)
+         {
+            const VALUETYPE ac = alpha * c0[i*ldc+j], bc = beta * c[i*ldc+j];
+
+            if (S.rowptr[i] == S.rowptr[i+1])
+               c0[i*ldc+j] = bc;
+            else if (beta == 0.0)
+               c0[i*ldc+j] = ac;
+            else
+               c0[i*ldc+j] = (tkern == 'x') ? (ac >= bc ? ac : bc) 
+                                            : (ac <= bc ? ac : bc);
+         }
+      }
+   }
+   else
+   {
+      for (i=0; i < szC; i++)
+         c0[i] = alpha * c0[i] + beta * c[i];
+   }
+   
+   fprintf(stdout, "Applying test kernel\n");
+   test(tkern, M, N, K, alpha, S.nnz, S.rows, S.cols, values, 
+         colids, S.rowptr, S.rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+/*
+ * check for errors 
+ */
+   nerr = doChecking<INDEXTYPE, VALUETYPE>(S.nnz, M, K, N, c0, c, ldc);
+   for (i=0; i < M; i++)
+   {
+      for (j=K; j < ldc; j++)
+      {
+         if (c[i*ldc+j] != padval)
+         {
+            if (!nerr)
+               fprintf(stderr, "C(%ld,%ld) : padding overwritten\n", i, j);
+            nerr++;
+         }
+      }
+   }
+
+   free(colids);
+   free(values);
+   free(pc0);
+   free(pc);
+   free(pb);
+   free(pa);
+
+   return(nerr);
+}
+/*==============================================================================
+ *    Timer framework  
+ *
+ *============================================================================*/
+/*
+ * NOTE: kernel timer prototype, typedef template function pointer   
+ */
+template <typename IT, typename CIT>
+using csr_timer_t = vector<double> (*) 
+(
+   const int tkern,        // kernel type
+   const int nrep,         // number of repetition  
+   const IT M,             // rows of A 
+   const IT N,             // rows of B
+   const IT K,             // feature dimension: col of A and B
+   const VALUETYPE alpha,  // alpha, not used yet
+   const IT nnz,           // nonzeros
+   const IT rows,          // rows of sparse matrix
+   const IT cols,          // col of sparse matrix 
+   VALUETYPE *values,      // nonzero values
+   IT *rowptr,             // rowptr of sparse matrix 
+   CIT *colids,            // col id of sparse matrix 
+   const VALUETYPE *a,     // Dense A matrix
+   const IT lda,           // leading dimension of A 
+   const VALUETYPE *b,     // Dense B matrix
+   const IT ldb,           // leading dimension of B
+   const VALUETYPE beta,   // beta  
+   VALUETYPE *c,           // Dense C matrix
+   const IT ldc            // leading dimension of C
+);
+// Cache flushing timer 
+template <typename IT, typename CIT>
+using csr_timer_cf_t = vector<double> (*) 
+(
+   const IT ndsets,        // number of data set
+   const IT wdsz,          // data workspace size
+   const IT nisets,        // number of index set
+   const IT wisz,          // index workspace size
+   const int nrep,         // number of repetition 
+   const int tkern,        // kernel type
+   const IT M,             // rows of A 
+   const IT N,             // rows of B
+   const IT K,             // feature dimension: cols of A and B
+   const VALUETYPE alpha,  // alpha, not used yet
+   const IT nnz,           // nonzeros
+   const IT rows,          // rows of sparse matrix
+   const IT cols,          // cols of sparse matrix
+   VALUETYPE *values,      // nnz values
+   IT *rowptr,             // row pointer of sparse 
+   CIT *colids,            // colid of sparse
+   const VALUETYPE *a,     // dense A 
+   const IT lda,           // leading dimension of A
+   const VALUETYPE *b,     // dense B
+   const IT ldb,           // leading dimension of B
+   const VALUETYPE beta,   // beta
+   VALUETYPE *c,           // dense C
+   const IT ldc            // leading dimension of C
+);
+/*
+ * Kernel timer wrapper for trusted kernel.. 
+ * This wrapper handles all extra setup needed to call a library, 
+ * For Example: MKL uses inspection and execution model  
+ */
+vector<double> callTimerTrusted_Acsr
+(
+   const int tkern,        // kernel type
+   const int nrep,         // number of repetition  
+   const INDEXTYPE M,      // rows of A 
+   const INDEXTYPE N,      // rows of B
+   const INDEXTYPE K,      // feature dimension: col of A and B
+   const VALUETYPE alpha,  // alpha, not used yet
+   const INDEXTYPE nnz,    // nonzeros
+   const INDEXTYPE rows,   // rows of sparse matrix
+   const INDEXTYPE cols,   // col of sparse matrix 
+   VALUETYPE *values,      // nonzero values 
+   INDEXTYPE *rowptr,      // rowptr of sparse matrix 
+   INDEXTYPE *colids,      // col id of sparse matrix 
+   const VALUETYPE *a,     // Dense A matrix  
+   const INDEXTYPE lda,    // leading dimension of A 
+   const VALUETYPE *b,     // Dense B matrix
+   const INDEXTYPE ldb,    // leading dimension of B
+   const VALUETYPE beta,   // beta  
+   VALUETYPE *c,           // Dense C matrix
+   const INDEXTYPE ldc     // leading dimension of C
+)
+{
+   double start, end;
+   vector <double> results;    
+/*
+ * NOTE: 
+ *    flag can be used to select different option, like: ROW_MAJOR, 
+ *    INDEX_BASE_ZERO. For now, we only support following options (no checking):
+ *       SPARSE_INDEX_BASE_ZERO
+ *       SPARSE_OPERATION_NON_TRANSPOSE
+ *       SPARSE_LAYOUT_ROW_MAJOR
+ */
+   // timing inspector phase 
+   {
+      results.push_back(0.0); // no inspection phase 
+   }
+   
+   mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
+              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+   
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+   {
+      mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
+                 colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+   }
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // execution time 
+
+   return(results);
+}
+
+// Cache flushing timer 
+// NOTE: If the dataset is small enough to fit in cache, we want to use this 
+// cache flushing timer. calling for all cases now since for larger data, it will 
+// create only one working set 
+vector<double> callCFTimerTrusted_Acsr
+(
+   const INDEXTYPE ndsets,    // number of data set in cache
+   const INDEXTYPE wdsz,      // data workspace size in cache
+   const INDEXTYPE nisets,    // number of index set in cache
+   const INDEXTYPE wisz,      // index workspace size in cache
+   const int nrep,            // number of repetition
+   const int tkern,           // kernel type 
+   const INDEXTYPE M,         // rows of A
+   const INDEXTYPE N,         // rows of B
+   const INDEXTYPE K,         // col of A and B
+   const VALUETYPE alpha,     // not used
+   const INDEXTYPE nnz,       // non zeros
+   const INDEXTYPE rows,      // rows of sparse matrix
+   const INDEXTYPE cols,      // cols of sparse matrix
+   VALUETYPE *values,         // non zero values
+   INDEXTYPE *rowptr,         // row ptr of sparse
+   INDEXTYPE *colids,         // col id of sparse
+   const VALUETYPE *a,        // dense A
+   const INDEXTYPE lda,       // lda of A
+   const VALUETYPE *b,        // dense B
+   const INDEXTYPE ldb,       // ld of B
+   const VALUETYPE beta,      // beta
+   VALUETYPE *c,              // dense C
+   const INDEXTYPE ldc        // ld of C
+)
+{
+   INDEXTYPE nds = ndsets;
+   INDEXTYPE nis = nisets;
+   double start, end;
+   vector <double> results;  // don't use single precision, use double  
+   
+   // timing inspector phase 
+   {
+      results.push_back(0.0); // no inspection phase 
+   }
+
+#if 0   
+   mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
+              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+#endif
+   
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+   {
+      nds--; nis--; 
+      mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, 
+            values+nds*wdsz, colids+nis*wisz, rowptr+nis*wisz, 
+            rowptr+nis*wisz+1, a+nds*wdsz, lda, b+nds*wdsz, ldb, beta, 
+            c+nds*wdsz, ldc);   
+      if (!nds)
+         nds = ndsets;
+      if (!nis)
+         nis = nisets;
+   }
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // execution time 
+
+   return(results);
+}
+
+#if TIME_MKL 
+/*
+ * kernel timer wrapper for MKL
+ * NOTE: MKL: M,N,K  => FUUSEDMM : M,K,N
+ * always ROW_MAJOR, INDEX_BASE_ZERO  
+ */
+vector<double> callTimerMKL_Acsr
+(
+   const int tkern,      // always 'm'
+   const int nrep,       
+   const MKL_INT M,
+   const MKL_INT N,
+   const MKL_INT K, 
+   const VALUETYPE alpha,
+   const MKL_INT nnz,
+   const MKL_INT rows,
+   const MKL_INT cols,
+   VALUETYPE *values, 
+   MKL_INT *rowptr,
+   MKL_INT *colids,
+   const VALUETYPE *a,   /* not used in spmm */
+   const MKL_INT lda,    /* not used in spmm */
+   const VALUETYPE *b,
+   const MKL_INT ldb,
+   const VALUETYPE beta,
+   VALUETYPE *c,
+   const MKL_INT ldc
+)
+{
+   double start, end;
+   vector <double> results;  // don't use single precision, use double  
+   MKL_INT n, k; 
+   sparse_status_t stat; 
+   sparse_matrix_t Amkl = NULL; 
+   struct matrix_descr Adsc;
+
+   n = K; k = N; /* difference in notation for FUSEDMM and MKL */
+/*
+ * NOTE: 
+ *    flag can be used to select different option, like: ROW_MAJOR, 
+ *    INDEX_BASE_ZERO. For now, we only support following options (no checking):
+ *       SPARSE_INDEX_BASE_ZERO
+ *       SPARSE_OPERATION_NON_TRANSPOSE
+ *       SPARSE_LAYOUT_ROW_MAJOR
+ */
+   // timing inspector phase 
+   {
+/*
+ *	force mkl to use specified threads 
+ */
+   #ifdef PTTME
+      #ifdef NTHREADS
+         //cout << "setting mkl threads = " << NTHREADS << endl;
+         mkl_set_num_threads(NTHREADS); 
+      #endif
+   #endif
+
+      start = omp_get_wtime();
+   #ifdef DREAL 
+      stat = mkl_sparse_d_create_csr (&Amkl, SPARSE_INDEX_BASE_ZERO, M, k, 
+               rowptr, rowptr+1, colids, values);  
+   #else
+      stat = mkl_sparse_s_create_csr (&Amkl, SPARSE_INDEX_BASE_ZERO, M, k, 
+               rowptr, rowptr+1, colids, values);  
+   #endif
+      end = omp_get_wtime();
+      results.push_back(end-start); // setup time 
+#if 0
+      if (stat != SPARSE_STATUS_SUCCESS)
+      {
+         cout << "creating csr for MKL failed!";
+         exit(1);
+      }
+#endif
+   }
+   
+   Adsc.type = SPARSE_MATRIX_TYPE_GENERAL;
+   //Adsc.fill // no need for general matrix  
+   //Adsc.diag =  SPARSE_DIAG_NON_UNIT;  // no need for general 
+  
+   // skiping first call 
+   #ifdef DREAL 
+      stat = mkl_sparse_d_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
+                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
+   #else
+      stat = mkl_sparse_s_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
+                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
+   #endif
+#if 1
+   if (stat != SPARSE_STATUS_SUCCESS)
+   {
+      cout << "creating csr for MKL failed, stat =!" << SPARSE_STATUS_SUCCESS 
+           << endl;
+      exit(1);
+   }
+#endif
+   
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+   {
+   #ifdef DREAL 
+      stat = mkl_sparse_d_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
+                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
+   #else
+      stat = mkl_sparse_s_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
+                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
+   #endif
+   }
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // execution time 
+
+   mkl_sparse_destroy(Amkl);
+   return(results);
+}
+
+#endif   /* END OF TIME_MKL */
+
+/*
+ * Non cache flushing timer wrapper for the execution plan of test kernel, 
+ * plan creation is timed as inspection phase 
+ */
+vector<double> callTimerPlan_Acsr
+(
+   const int tkern,        
+   const int nrep,       
+   const INDEXTYPE M,
+   const INDEXTYPE N,
+   const INDEXTYPE K, 
+   const VALUETYPE alpha,
+   const INDEXTYPE nnz,
+   const INDEXTYPE rows,
+   const INDEXTYPE cols,
+   VALUETYPE *values, 
+   INDEXTYPE *rowptr,
+   COLINDEXTYPE *colids,
+   const VALUETYPE *a,     
+   const INDEXTYPE lda,   
+   const VALUETYPE *b,
+   const INDEXTYPE ldb,
+   const VALUETYPE beta,
+   VALUETYPE *c,
+   const INDEXTYPE ldc
+)
+{
+   double start, end;
+   vector <double> results;  // don't use single precision, use double  
+   fusedMM_plan_t *plan; 
+   const int32_t imsg = GetTestMsg(tkern); 
+
+   start = omp_get_wtime();
+   if (!imsg || fusedMM_plan_create_ex(&plan, imsg, M, N, K, nnz, rows, cols, 
+            colids, rowptr, rowptr+1, &PlanOpts) != FUSEDMM_SUCCESS_RETURN)
+   {
+      printf("failed to create plan\n");
+      exit(1);
+   }
+   end = omp_get_wtime();
+   results.push_back(end-start); // inspection: plan creation 
+
+   fusedMM_plan_execute(plan, alpha, values, a, lda, b, ldb, beta, c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_plan_execute(plan, alpha, values, a, lda, b, ldb, beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // execution time 
+   fusedMM_plan_destroy(plan);
+
+   return(results);
+}
+/*
+ * Timer of half precision A and B: results[0] is the execution time of the 
+ * test kernel on float A and B, results[1] of fusedMM_csr_half on them 
+ * converted to HalfType (conversion is not timed) 
+ */
+vector<double> callTimerHalf_Acsr
+(
+   const int tkern,        
+   const int nrep,       
+   const INDEXTYPE M,
+   const INDEXTYPE N,
+   const INDEXTYPE K, 
+   const VALUETYPE alpha,
+   const INDEXTYPE nnz,
+   const INDEXTYPE rows,
+   const INDEXTYPE cols,
+   VALUETYPE *values, 
+   INDEXTYPE *rowptr,
+   COLINDEXTYPE *colids,
+   const VALUETYPE *a,     
+   const INDEXTYPE lda,   
+   const VALUETYPE *b,
+   const INDEXTYPE ldb,
+   const VALUETYPE beta,
+   VALUETYPE *c,
+   const INDEXTYPE ldc
+)
+{
+   double start, end;
+   vector <double> results;  // don't use single precision, use double  
+   uint16_t *ha, *hb; 
+   const int32_t imsg = GetTestMsg(tkern); 
+
+   ha = (uint16_t*)malloc(M*lda*sizeof(uint16_t));
+   hb = (uint16_t*)malloc(N*ldb*sizeof(uint16_t));
+   assert(imsg && ha && hb);
+   fusedMM_cvt_half(HalfType, M*lda, a, ha);
+   fusedMM_cvt_half(HalfType, N*ldb, b, hb);
+
+   fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, rowptr,
+         rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+            rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // float execution time 
+
+   fusedMM_csr_half(imsg, HalfType, M, N, K, alpha, nnz, rows, cols, values, 
+         colids, rowptr, rowptr+1, ha, lda, hb, ldb, beta, c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr_half(imsg, HalfType, M, N, K, alpha, nnz, rows, cols, 
+            values, colids, rowptr, rowptr+1, ha, lda, hb, ldb, beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // half execution time 
+
+   free(hb);
+   free(ha);
+   return(results);
+}
+/*
+ * Timer of int8 B: results[0] is the execution time of the test kernel on 
+ * float B, results[1] of fusedMM_csr_i8 on B quantized (not timed) 
+ */
+vector<double> callTimerI8_Acsr
+(
+   const int tkern,        
+   const int nrep,       
+   const INDEXTYPE M,
+   const INDEXTYPE N,
+   const INDEXTYPE K, 
+   const VALUETYPE alpha,
+   const INDEXTYPE nnz,
+   const INDEXTYPE rows,
+   const INDEXTYPE cols,
+   VALUETYPE *values, 
+   INDEXTYPE *rowptr,
+   COLINDEXTYPE *colids,
+   const VALUETYPE *a,     
+   const INDEXTYPE lda,   
+   const VALUETYPE *b,
+   const INDEXTYPE ldb,
+   const VALUETYPE beta,
+   VALUETYPE *c,
+   const INDEXTYPE ldc
+)
+{
+   double start, end;
+   vector <double> results;  // don't use single precision, use double  
+   int8_t *qb; 
+   VALUETYPE *bq; 
+   const int32_t imsg = GetTestMsg(tkern); 
+
+   qb = (int8_t*)malloc(N*ldb*sizeof(int8_t));
+   bq = (VALUETYPE*)malloc(2*N*sizeof(VALUETYPE));
+   assert(imsg && qb && bq);
+   fusedMM_quantize_i8(N, K, b, ldb, qb, ldb, bq);
+
+   fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, rowptr,
+         rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+            rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // float execution time 
+
+   fusedMM_csr_i8(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+         rowptr, rowptr+1, a, lda, qb, ldb, bq, beta, c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr_i8(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+            rowptr, rowptr+1, a, lda, qb, ldb, bq, beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // int8 execution time 
+
+   free(bq);
+   free(qb);
+   return(results);
+}
+/*
+ * Timer of multi-head: results[0] is the execution time of MhHeads calls of 
+ * the test kernel, one on each head of A, B and C, results[1] of 
+ * fusedMM_csr_mh 
+ */
+vector<double> callTimerMh_Acsr
+(
+   const int tkern,        
+   const int nrep,       
+   const INDEXTYPE M,
+   const INDEXTYPE N,
+   const INDEXTYPE K, 
+   const VALUETYPE alpha,
+   const INDEXTYPE nnz,
+   const INDEXTYPE rows,
+   const INDEXTYPE cols,
+   VALUETYPE *values, 
+   INDEXTYPE *rowptr,
+   COLINDEXTYPE *colids,
+   const VALUETYPE *a,     
+   const INDEXTYPE lda,   
+   const VALUETYPE *b,
+   const INDEXTYPE ldb,
+   const VALUETYPE beta,
+   VALUETYPE *c,
+   const INDEXTYPE ldc
+)
+{
+   double start, end;
+   vector <double> results;  // don't use single precision, use double  
+   const int32_t imsg = GetTestMsg(tkern); 
+   const INDEXTYPE dh = K / MhHeads; 
+
+   assert(imsg);
+   for (INDEXTYPE h = 0; h < K; h += dh)
+      fusedMM_csr(imsg, M, N, dh, alpha, nnz, rows, cols, values, colids, 
+            rowptr, rowptr+1, a+h, lda, b+h, ldb, beta, c+h, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      for (INDEXTYPE h = 0; h < K; h += dh)
+         fusedMM_csr(imsg, M, N, dh, alpha, nnz, rows, cols, values, colids, 
+               rowptr, rowptr+1, a+h, lda, b+h, ldb, beta, c+h, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // head by head time 
+
+   fusedMM_csr_mh(imsg, MhHeads, M, N, K, alpha, nnz, rows, cols, values, 
+         colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr_mh(imsg, MhHeads, M, N, K, alpha, nnz, rows, cols, values, 
+            colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // multi-head time 
+
+   return(results);
+}
+/*
+ * Timer of per-edge output: results[0] is the execution time of fusedMM_csr 
+ * followed by a second pass of fusedMM_csr_edge in SDDMM-only mode, 
+ * results[1] of fusedMM_csr_edge which updates C and the edges in one pass 
+ */
+vector<double> callTimerEdge_Acsr
+(
+   const int tkern,        
+   const int nrep,       
+   const INDEXTYPE M,
+   const INDEXTYPE N,
+   const INDEXTYPE K, 
+   const VALUETYPE alpha,
+   const INDEXTYPE nnz,
+   const INDEXTYPE rows,
+   const INDEXTYPE cols,
+   VALUETYPE *values, 
+   INDEXTYPE *rowptr,
+   COLINDEXTYPE *colids,
+   const VALUETYPE *a,     
+   const INDEXTYPE lda,   
+   const VALUETYPE *b,
+   const INDEXTYPE ldb,
+   const VALUETYPE beta,
+   VALUETYPE *c,
+   const INDEXTYPE ldc
 )
 {
-   INDEXTYPE nds = ndsets;
-   INDEXTYPE nis = nisets;
    double start, end;
    vector <double> results;  // don't use single precision, use double  
-   
-   // timing inspector phase 
+   const int32_t imsg = GetTestMsg(tkern); 
+   VALUETYPE *eout; 
+
+   assert(imsg);
+   eout = (VALUETYPE*)malloc(nnz*sizeof(VALUETYPE));
+   assert(eout);
+   fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, rowptr,
+         rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   fusedMM_csr_edge(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+         rowptr, rowptr+1, a, lda, b, ldb, beta, NULL, ldc, eout);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
    {
-      results.push_back(0.0); // no inspection phase 
+      fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+            rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);
+      fusedMM_csr_edge(imsg, M, N, K, alpha, nnz, rows, cols, values, colids,
+            rowptr, rowptr+1, a, lda, b, ldb, beta, NULL, ldc, eout);
    }
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // two passes time 
 
-#if 0   
-   mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
-              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
-#endif
-   
+   fusedMM_csr_edge(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+         rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, eout);
    start = omp_get_wtime();
    for (int i=0; i < nrep; i++)
-   {
-      nds--; nis--; 
-      mytrusted_csr(tkern, M, N, K, alpha, nnz, rows, cols, 
-            values+nds*wdsz, colids+nis*wisz, rowptr+nis*wisz, 
-            rowptr+nis*wisz+1, a+nds*wdsz, lda, b+nds*wdsz, ldb, beta, 
-            c+nds*wdsz, ldc);   
-      if (!nds)
-         nds = ndsets;
-      if (!nis)
-         nis = nisets;
-   }
+      fusedMM_csr_edge(imsg, M, N, K, alpha, nnz, rows, cols, values, colids,
+            rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, eout);
    end = omp_get_wtime();
-   results.push_back((end-start)/((double)nrep)); // execution time 
+   results.push_back((end-start)/((double)nrep)); // one pass time 
 
+   free(eout);
    return(results);
 }
-
-#if TIME_MKL 
 /*
- * kernel timer wrapper for MKL
- * NOTE: MKL: M,N,K  => FUUSEDMM : M,K,N
- * always ROW_MAJOR, INDEX_BASE_ZERO  
+ * Timer of argmax output: results[0] is the execution time of fusedMM_csr 
+ * with the max/min message, results[1] of fusedMM_csr_arg 
  */
-vector<double> callTimerMKL_Acsr
+vector<double> callTimerArg_Acsr
 (
-   const int tkern,      // always 'm'
+   const int tkern,        
    const int nrep,       
-   const MKL_INT M,
-   const MKL_INT N,
-   const MKL_INT K, 
+   const INDEXTYPE M,
+   const INDEXTYPE N,
+   const INDEXTYPE K, 
    const VALUETYPE alpha,
-   const MKL_INT nnz,
-   const MKL_INT rows,
-   const MKL_INT cols,
+   const INDEXTYPE nnz,
+   const INDEXTYPE rows,
+   const INDEXTYPE cols,
    VALUETYPE *values, 
-   MKL_INT *rowptr,
-   MKL_INT *colids,
-   const VALUETYPE *a,   /* not used in spmm */
-   const MKL_INT lda,    /* not used in spmm */
+   INDEXTYPE *rowptr,
+   COLINDEXTYPE *colids,
+   const VALUETYPE *a,     
+   const INDEXTYPE lda,   
    const VALUETYPE *b,
-   const MKL_INT ldb,
+   const INDEXTYPE ldb,
    const VALUETYPE beta,
    VALUETYPE *c,
-   const MKL_INT ldc
+   const INDEXTYPE ldc
 )
 {
    double start, end;
    vector <double> results;  // don't use single precision, use double  
-   MKL_INT n, k; 
-   sparse_status_t stat; 
-   sparse_matrix_t Amkl = NULL; 
-   struct matrix_descr Adsc;
+   const int32_t imsg = GetTestMsg(tkern); 
+   INDEXTYPE *arg; 
+
+   assert(imsg);
+   arg = (INDEXTYPE*)malloc(M*ldc*sizeof(INDEXTYPE));
+   assert(arg);
+   fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, rowptr,
+         rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+            rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // max/min time 
 
-   n = K; k = N; /* difference in notation for FUSEDMM and MKL */
-/*
- * NOTE: 
- *    flag can be used to select different option, like: ROW_MAJOR, 
- *    INDEX_BASE_ZERO. For now, we only support following options (no checking):
- *       SPARSE_INDEX_BASE_ZERO
- *       SPARSE_OPERATION_NON_TRANSPOSE
- *       SPARSE_LAYOUT_ROW_MAJOR
- */
-   // timing inspector phase 
-   {
+   fusedMM_csr_arg(imsg, M, N, K, alpha, nnz, rows, cols, values, colids, 
+         rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, arg);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr_arg(imsg, M, N, K, alpha, nnz, rows, cols, values, colids,
+            rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, arg);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // with arg time 
+
+   free(arg);
+   return(results);
+}
 /*
- *	force mkl to use specified threads 
+ * Timer of degree normalization: results[0] is the execution time of scaling 
+ * the values by the degrees followed by fusedMM_csr with the spmm message, 
+ * results[1] of fusedMM_csr_norm with the same scales 
  */
-   #ifdef PTTME
-      #ifdef NTHREADS
-         //cout << "setting mkl threads = " << NTHREADS << endl;
-         mkl_set_num_threads(NTHREADS); 
-      #endif
-   #endif
-
-      start = omp_get_wtime();
-   #ifdef DREAL 
-      stat = mkl_sparse_d_create_csr (&Amkl, SPARSE_INDEX_BASE_ZERO, M, k, 
-               rowptr, rowptr+1, colids, values);  
-   #else
-      stat = mkl_sparse_s_create_csr (&Amkl, SPARSE_INDEX_BASE_ZERO, M, k, 
-               rowptr, rowptr+1, colids, values);  
-   #endif
-      end = omp_get_wtime();
-      results.push_back(end-start); // setup time 
-#if 0
-      if (stat != SPARSE_STATUS_SUCCESS)
-      {
-         cout << "creating csr for MKL failed!";
-         exit(1);
-      }
-#endif
-   }
-   
-   Adsc.type = SPARSE_MATRIX_TYPE_GENERAL;
-   //Adsc.fill // no need for general matrix  
-   //Adsc.diag =  SPARSE_DIAG_NON_UNIT;  // no need for general 
-  
-   // skiping first call 
-   #ifdef DREAL 
-      stat = mkl_sparse_d_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
-                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
-   #else
-      stat = mkl_sparse_s_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
-                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
-   #endif
-#if 1
-   if (stat != SPARSE_STATUS_SUCCESS)
-   {
-      cout << "creating csr for MKL failed, stat =!" << SPARSE_STATUS_SUCCESS 
-           << endl;
-      exit(1);
-   }
-#endif
-   
+vector<double> callTimerNorm_Acsr
+(
+   const int tkern,        
+   const int nrep,       
+   const INDEXTYPE M,
+   const INDEXTYPE N,
+   const INDEXTYPE K, 
+   const VALUETYPE alpha,
+   const INDEXTYPE nnz,
+   const INDEXTYPE rows,
+   const INDEXTYPE cols,
+   VALUETYPE *values, 
+   INDEXTYPE *rowptr,
+   COLINDEXTYPE *colids,
+   const VALUETYPE *a,     
+   const INDEXTYPE lda,   
+   const VALUETYPE *b,
+   const INDEXTYPE ldb,
+   const VALUETYPE beta,
+   VALUETYPE *c,
+   const INDEXTYPE ldc
+)
+{
+   double start, end;
+   vector <double> results;  // don't use single precision, use double  
+   const int32_t imsg = GetTestMsg(tkern); 
+   const int32_t smsg = GetTestMsg('m'); 
+   VALUETYPE *ds, *sval; 
+   const VALUETYPE *cs; 
+
+   assert(imsg);
+   ds = (VALUETYPE*)malloc(M*sizeof(VALUETYPE));
+   sval = (VALUETYPE*)malloc((nnz+1)*sizeof(VALUETYPE));
+   assert(ds && sval);
+   fusedMM_degree_scale(NormType, M, rowptr, rowptr+1, ds);
+   cs = (NormType == FUSEDMM_NORM_SYM) ? ds : NULL; 
+   fusedMM_csr(smsg, M, N, K, alpha, nnz, rows, cols, values, colids, rowptr,
+         rowptr+1, a, lda, b, ldb, beta, c, ldc);
    start = omp_get_wtime();
    for (int i=0; i < nrep; i++)
    {
-   #ifdef DREAL 
-      stat = mkl_sparse_d_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
-                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
-   #else
-      stat = mkl_sparse_s_mm (SPARSE_OPERATION_NON_TRANSPOSE, alpha, Amkl, Adsc, 
-                              SPARSE_LAYOUT_ROW_MAJOR, b, n, ldb, beta, c, ldc); 
-   #endif
+      #pragma omp parallel for schedule(static)
+      for (INDEXTYPE r = 0; r < M; r++)
+         for (INDEXTYPE j = rowptr[r]; j < rowptr[r+1]; j++)
+            sval[j] = ds[r] * (tkern == 'm' ? values[j] : 1.0) 
+                      * (cs ? cs[colids[j]] : 1.0);
+      fusedMM_csr(smsg, M, N, K, alpha, nnz, rows, cols, sval, colids, 
+            rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);
    }
    end = omp_get_wtime();
-   results.push_back((end-start)/((double)nrep)); // execution time 
+   results.push_back((end-start)/((double)nrep)); // scaled values time 
 
-   mkl_sparse_destroy(Amkl);
+   fusedMM_csr_norm(imsg, FUSEDMM_NORM_SCALE, ds, cs, M, N, K, alpha, nnz, 
+         rows, cols, values, colids, rowptr, rowptr+1, a, lda, b, ldb, beta, 
+         c, ldc);
+   start = omp_get_wtime();
+   for (int i=0; i < nrep; i++)
+      fusedMM_csr_norm(imsg, FUSEDMM_NORM_SCALE, ds, cs, M, N, K, alpha, nnz,
+            rows, cols, values, colids, rowptr, rowptr+1, a, lda, b, ldb, 
+            beta, c, ldc);
+   end = omp_get_wtime();
+   results.push_back((end-start)/((double)nrep)); // normalized kernel time 
+
+   free(sval);
+   free(ds);
    return(results);
 }
-
-#endif   /* END OF TIME_MKL */
-
 /*
  * Non cache flushing timer wrapper for test kernel 
  */
@@ -1286,7 +2690,7 @@ vector<double> callTimerTest_Acsr
    const INDEXTYPE cols,
    VALUETYPE *values, 
    INDEXTYPE *rowptr,
-   INDEXTYPE *colids,
+   COLINDEXTYPE *colids,
    const VALUETYPE *a,     
    const INDEXTYPE lda,   
    const VALUETYPE *b,
@@ -1313,10 +2717,12 @@ vector<double> callTimerTest_Acsr
 #if 0  
 #ifdef DREAL
    dgfusedMM_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
-              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, 
+              0, NULL);
 #else
    sgfusedMM_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
-              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+              colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, 
+              0, NULL);
 #endif
 #else  // calling general fusedmm 
    mytest_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
@@ -1328,10 +2734,12 @@ vector<double> callTimerTest_Acsr
 #if 0
    #ifdef DREAL
       dgfusedMM_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
-                 colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+                 colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, 
+              0, NULL);
    #else
       sgfusedMM_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
-                 colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc);   
+                 colids, rowptr, rowptr+1, a, lda, b, ldb, beta, c, ldc, 
+              0, NULL);
    #endif
 #else  // calling general fusedmm 
       mytest_csr(tkern, M, N, K, alpha, nnz, rows, cols, values, 
@@ -1362,7 +2770,7 @@ vector<double> callCFTimerTest_Acsr
    const INDEXTYPE cols,      // cols of sparse matrix
    VALUETYPE *values,         // non zero values
    INDEXTYPE *rowptr,         // row ptr of sparse
-   INDEXTYPE *colids,         // col id of sparse
+   COLINDEXTYPE *colids,      // col id of sparse
    const VALUETYPE *a,        // dense A
    const INDEXTYPE lda,       // lda of A
    const VALUETYPE *b,        // dense B
@@ -1389,12 +2797,12 @@ vector<double> callCFTimerTest_Acsr
       dgfusedMM_csr(tkern, M, N, K, alpha, nnz, rows, cols, 
             values+nds*wdsz, colids+nis*wisz, rowptr+nis*wisz, 
             rowptr+nis*wisz+1, a+nds*wdsz, lda, b+nds*wdsz, ldb, beta, 
-            c+nds*wdsz, ldc);   
+            c+nds*wdsz, ldc, 0, NULL);   
    #else
       sgfusedMM_csr(tkern, M, N, K, alpha, nnz, rows, cols, 
             values+nds*wdsz, colids+nis*wisz, rowptr+nis*wisz, 
             rowptr+nis*wisz+1, a+nds*wdsz, lda, b+nds*wdsz, ldb, beta, 
-            c+nds*wdsz, ldc);   
+            c+nds*wdsz, ldc, 0, NULL);   
    #endif
 #else  // calling general fusedmm 
       mytest_csr(tkern, M, N, K, alpha, nnz, rows, cols, 
@@ -1416,7 +2824,7 @@ vector<double> callCFTimerTest_Acsr
 /*
  * Non cache flushing timer: assuming large working set, sizeof B+D > L3 cache 
  */
-template<typename IT, csr_timer_t<IT> CSR_TIMER>
+template<typename IT, typename CIT, csr_timer_t<IT,CIT> CSR_TIMER>
 vector <double> doTiming_Acsr
 (
  const CSR<INDEXTYPE, VALUETYPE> &S, 
@@ -1437,7 +2845,8 @@ vector <double> doTiming_Acsr
    IT nnz, rows, cols;
    IT szA, szB, szC, lda, ldb, ldc; 
    VALUETYPE *pa, *a, *pb, *b, *pc, *c, *values;
-   IT *rowptr, *colids;
+   IT *rowptr;
+   CIT *colids;
 
 #if defined(PTTIME) && defined(NTHREADS)
    omp_set_num_threads(NTHREADS);
@@ -1447,6 +2856,7 @@ vector <double> doTiming_Acsr
    std::uniform_real_distribution<double> distribution(0.0,1.0);
 
    lda = ldb = ldc = K; // considering both row-major   
+   nnz = S.nnz; rows = S.rows; cols = S.cols; 
 
    szAligned = ATL_Cachelen / sizeof(VALUETYPE);
    szA = ((M*ldb+szAligned-1)/szAligned)*szAligned;  // szB in element
@@ -1492,7 +2902,7 @@ vector <double> doTiming_Acsr
       for (i=0; i < M+1; i++)
          rowptr[i] = S.rowptr[i];
    
-      colids = (IT*) malloc(S.nnz*sizeof(IT));
+      colids = (CIT*) malloc(S.nnz*sizeof(CIT));
       assert(colids);
 #ifdef PTTIME
    #pragma omp parallel for schedule(static)
@@ -1530,7 +2940,7 @@ vector <double> doTiming_Acsr
  * cache flushing timer. calling for all cases now since for larger data, it will 
  * create only one working set 
  */
-template<typename IT, csr_timer_cf_t<IT> CSR_TIMER>
+template<typename IT, typename CIT, csr_timer_cf_t<IT,CIT> CSR_TIMER>
 vector <double> doCFTiming_Acsr
 (
  const CSR<INDEXTYPE, VALUETYPE> &S, 
@@ -1552,9 +2962,10 @@ vector <double> doCFTiming_Acsr
    IT szA, szB, szC, lda, ldb, ldc; 
    IT szM, szNNZ, csz, dsz, ndsets;
    IT nisets, isz;
-   VALUETYPE *vp, *vip;
+   VALUETYPE *vp, *vip, *vcp;
    VALUETYPE *pa, *a, *pb, *b, *pc, *c, *values;
-   IT *rowptr, *colids;
+   IT *rowptr;
+   CIT *colids;
 
 #if 0
 #if defined(PTTIME) && defined(NTHREADS)
@@ -1567,6 +2978,7 @@ vector <double> doCFTiming_Acsr
    std::uniform_real_distribution<double> distribution(0.0,1.0);
 
    lda = ldb = ldc = K; // considering all row-major   
+   nnz = S.nnz; rows = S.rows; cols = S.cols; 
 /*
  * NOTE: we are considering two work set here for two types: 
  *    VALUETYPE, INDEXTYPE
@@ -1610,7 +3022,10 @@ vector <double> doCFTiming_Acsr
    vip = (VALUETYPE*)malloc(nisets*isz*sizeof(IT));
    assert(vip);
    rowptr = (IT*) ATL_AlignPtr(vip);
-   colids = rowptr + szM;
+   // colids has its own workspace since CIT may differ from IT 
+   vcp = (VALUETYPE*)malloc(nisets*isz*sizeof(CIT)+ATL_Cachelen);
+   assert(vcp);
+   colids = (CIT*) ATL_AlignPtr(vcp);
 /*
  * initialize all working set
  * NOTE: the idea here is that each part of the working will be sz apart
@@ -1649,6 +3064,7 @@ vector <double> doCFTiming_Acsr
          beta, c, ldc); 
    free(vp);
    free(vip);
+   free(vcp);
    
    return(results);
 }
@@ -1658,12 +3074,15 @@ vector <double> doCFTiming_Acsr
  */
 void GetSpeedup(string inputfile, int option, INDEXTYPE M, 
       INDEXTYPE K, int csKB, int nrep, int isTest, int skipHeader, 
-      VALUETYPE alpha, VALUETYPE beta, int tkern)
+      VALUETYPE alpha, VALUETYPE beta, int tkern, INDEXTYPE ldpad, 
+      int reorder, int vbidx, int half, int i8, INDEXTYPE sell, int csc, 
+      INDEXTYPE mh, int edge, int norm, int arg)
 {
    int nerr, norandom;
    INDEXTYPE i;
-   vector<double> res0, res1; 
-   double exeTime0, exeTime1, inspTime0, inspTime1; 
+   vector<double> res0, res1, res2, res3, res4, res5, res6, res7, res8, res9; 
+   vector<double> res10, res11, res12; 
+   double exeTime0, exeTime1, inspTime0, inspTime1, reordTime; 
    INDEXTYPE N, blkid; /* A->MxN, B-> NxD, C-> MxD */
    vector <INDEXTYPE> rblkids;
    CSR<INDEXTYPE, VALUETYPE> S_csr0; 
@@ -1692,11 +3111,103 @@ void GetSpeedup(string inputfile, int option, INDEXTYPE M,
  *          Dense Matrix  : A->MxK B->NxK, C->MxK
  */
    assert(N && M && K);
+   if (reorder && (M != S_csr0.rows || S_csr0.rows != S_csr0.cols))
+   {
+      fprintf(stderr, "Reordering needs square sparse matrix, skipped\n");
+      reorder = 0; 
+   }
+   HalfType = half; 
+   if (mh && (mh < 0 || K % mh))
+   {
+      fprintf(stderr, "Number of heads must divide K, -mh skipped\n");
+      mh = 0; 
+   }
+   MhHeads = mh; 
+   if (norm && ((norm != FUSEDMM_NORM_SYM && norm != FUSEDMM_NORM_MEAN) 
+            || (tkern != 'g' && tkern != 'm')))
+   {
+      fprintf(stderr, "Normalization needs spmm or gcn, -norm skipped\n");
+      norm = 0; 
+   }
+   if (norm == FUSEDMM_NORM_SYM 
+         && (M != S_csr0.rows || S_csr0.rows != S_csr0.cols))
+   {
+      fprintf(stderr, "Symmetric normalization needs square sparse matrix, "
+              "-norm skipped\n");
+      norm = 0; 
+   }
+   NormType = norm; 
+   if (arg && tkern != 'x' && tkern != 'n')
+   {
+      fprintf(stderr, "Argmax output needs max or min, -arg skipped\n");
+      arg = 0; 
+   }
    if (isTest)
    {
       // passed mytrusted and mytest function pointers 
-      nerr = doTesting_Acsr<mytrusted_csr, mytest_csr>
-                               (S_csr0, M, N, K, alpha, beta, tkern); 
+      if (half) // test half precision A and B 
+         nerr = doTesting_Acsr<mytrusted_csr, mytesthalf_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+      else if (csc) // test transposed execution on CSR of S^T (CSC of S)
+      {
+         CSR<INDEXTYPE, VALUETYPE> S_csrt(S_csc, true); 
+         PlanOpts.reorder = reorder;
+         if (isTest == 2)
+            nerr = doTesting_Acsr<mytrusted_csr, mytesttplan_csr>
+                               (S_csrt, S_csrt.rows, S_csrt.cols, K, alpha, 
+                                beta, tkern, ldpad); 
+         else
+            nerr = doTesting_Acsr<mytrusted_csr, mytestcsc_csr>
+                               (S_csrt, S_csrt.rows, S_csrt.cols, K, alpha, 
+                                beta, tkern, ldpad); 
+         PlanOpts.reorder = FUSEDMM_REORDER_NONE;
+      }
+      else if (mh) // test multi-head against trusted kernel on each head
+         nerr = doTesting_Acsr<mytrustedmh_csr, mytestmh_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+      else if (edge) // test per-edge output, C and scalars of the edges
+      {
+         EdgeErr = 0; 
+         nerr = doTesting_Acsr<mytrusted_csr, mytestedge_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+         nerr += EdgeErr; 
+      }
+      else if (norm) // test degree normalization 
+         nerr = doTesting_Acsr<mytrustednorm_csr, mytestnorm_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+      else if (arg) // test argmax output, C and the nonzeros recorded 
+      {
+         ArgErr = 0; 
+         nerr = doTesting_Acsr<mytrusted_csr, mytestarg_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+         nerr += ArgErr; 
+      }
+      else if (i8) // test int8 B 
+      {
+         I8Type = 1; 
+         nerr = doTesting_Acsr<mytrusted_csr, mytesti8_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+         I8Type = 0; 
+      }
+      else if (isTest == 2) // test through the execution plan 
+      {
+         // plan reorders the graph and operands transparently 
+         PlanOpts.reorder = reorder;
+         PlanOpts.vbidx = vbidx;
+         PlanOpts.sell = sell;
+         nerr = doTesting_Acsr<mytrusted_csr, mytestplan_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+         // operands given in the permuted order of the reordered graph 
+         if (reorder)
+            nerr += doTesting_Acsr<mytrusted_csr, mytestpplan_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+         PlanOpts.reorder = FUSEDMM_REORDER_NONE;
+         PlanOpts.vbidx = 0;
+         PlanOpts.sell = 0;
+      }
+      else
+         nerr = doTesting_Acsr<mytrusted_csr, mytest_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
       // error checking 
       if (!nerr)
          fprintf(stdout, "PASSED TEST\n");
@@ -1719,33 +3230,33 @@ void GetSpeedup(string inputfile, int option, INDEXTYPE M,
       assert(tkern == 'm'); // only spmm 
       
       // non cache flushing timers, no cache flushing timer for MKL
-      res0 = doTiming_Acsr<MKL_INT, callTimerMKL_Acsr>(S_csr0, M, N, K, 
+      res0 = doTiming_Acsr<MKL_INT, MKL_INT, callTimerMKL_Acsr>(S_csr0, M, N, K, 
                   alpha, beta, csKB, nrep, tkern);
       
       // test kernel with non cache flushing timer 
-      res1 = doTiming_Acsr<INDEXTYPE, callTimerTest_Acsr>(S_csr0, M, N, K, 
-                  alpha, beta, csKB, nrep, tkern);
+      res1 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerTest_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
 
 #else // Trusted kernels as 
       // call Trusted kernel
       
       // non cache flushing 
-      //res0 = doTiming_Acsr<INDEXTYPE, callTimerTrusted_Acsr>(S_csr0, M, N, K, 
-      //            alpha, beta, csKB, nrep, tkern);
+      //res0 = doTiming_Acsr<INDEXTYPE, INDEXTYPE, callTimerTrusted_Acsr>
+      //            (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
       
       // Cache flushing timer 
-      res0 = doCFTiming_Acsr<INDEXTYPE, callCFTimerTrusted_Acsr>(S_csr0, M, N, K, 
-                  alpha, beta, csKB, nrep, tkern);
+      res0 = doCFTiming_Acsr<INDEXTYPE, INDEXTYPE, callCFTimerTrusted_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
       
       // call test kernels
 
       // non cache flushing 
-      //res1 = doTiming_Acsr<INDEXTYPE, callTimerTest_Acsr>(S_csr0, M, N, K, 
-      //            alpha, beta, csKB, nrep, tkern);
+      //res1 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerTest_Acsr>
+      //            (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
       
       // Cache flushing timer 
-      res1 = doCFTiming_Acsr<INDEXTYPE, callCFTimerTest_Acsr>(S_csr0, M, N, K, 
-                  alpha, beta, csKB, nrep, tkern);
+      res1 = doCFTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callCFTimerTest_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
 #endif
       inspTime0 += res0[0];
       exeTime0 += res0[1];
@@ -1754,6 +3265,94 @@ void GetSpeedup(string inputfile, int option, INDEXTYPE M,
       inspTime1 += res1[0];
       exeTime1 += res1[1];
    }
+/*
+ * time the plan of test kernel without and with compressed column indices
+ */
+   if (vbidx)
+   {
+      res3 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerPlan_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+      PlanOpts.vbidx = 1;
+      res4 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerPlan_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+      PlanOpts.vbidx = 0;
+   }
+/*
+ * time the plan of test kernel without and with SELL-C-sigma 
+ */
+   if (sell)
+   {
+      res7 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerPlan_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+      PlanOpts.sell = sell;
+      res8 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerPlan_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+      PlanOpts.sell = 0;
+   }
+/*
+ * time the test kernel with half precision A and B 
+ */
+   if (half)
+      res5 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerHalf_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+/*
+ * time the test kernel with int8 B 
+ */
+   if (i8)
+      res6 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerI8_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+/*
+ * time the test kernel on each head and multi-head 
+ */
+   if (mh)
+      res9 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerMh_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+/*
+ * time per-edge output in a second pass and in the same pass 
+ */
+   if (edge)
+      res10 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerEdge_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+/*
+ * time degree normalization on scaled values and in the kernel 
+ */
+   if (norm)
+      res11 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerNorm_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+/*
+ * time max/min aggregation with and without argmax output 
+ */
+   if (arg)
+      res12 = doTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callTimerArg_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+/*
+ * time the test kernel again on the reordered graph 
+ */
+   reordTime = 0.0; 
+   if (reorder)
+   {
+      vector<INDEXTYPE> perm(M);
+      reordTime = omp_get_wtime();
+      if (!ReorderCSR(S_csr0, reorder, perm.data()))
+      {
+         fprintf(stderr, "Reordering failed\n");
+         exit(1);
+      }
+      reordTime = omp_get_wtime() - reordTime; 
+      if (isTest)
+      {
+         nerr = doTesting_Acsr<mytrusted_csr, mytest_csr>
+                               (S_csr0, M, N, K, alpha, beta, tkern, ldpad); 
+         if (nerr)
+         {
+            fprintf(stdout, "FAILED TEST AFTER REORDERING, %d ELEMENTS\n", 
+                    nerr);
+            exit(1); 
+         }
+      }
+      res2 = doCFTiming_Acsr<INDEXTYPE, COLINDEXTYPE, callCFTimerTest_Acsr>
+                  (S_csr0, M, N, K, alpha, beta, csKB, nrep, tkern);
+   }
    
    if(!skipHeader) 
    {
@@ -1775,7 +3374,46 @@ void GetSpeedup(string inputfile, int option, INDEXTYPE M,
          << "Speedup_total,"
          << "Critical_point" 
 #endif
-         << endl;
+         ;
+      if (reorder)
+         cout << ",Reorder_time,"
+              << "Reordered_test_exe_time,"
+              << "Speedup_reordered_exe_time";
+      if (vbidx)
+         cout << ",Plan_exe_time,"
+              << "Vbidx_plan_inspect_time,"
+              << "Vbidx_plan_exe_time,"
+              << "Speedup_vbidx_exe_time";
+      if (half)
+         cout << ",Float_exe_time,"
+              << "Half_exe_time,"
+              << "Speedup_half_exe_time";
+      if (i8)
+         cout << ",Float_exe_time,"
+              << "I8_exe_time,"
+              << "Speedup_i8_exe_time";
+      if (sell)
+         cout << ",Plan_exe_time,"
+              << "Sell_plan_inspect_time,"
+              << "Sell_plan_exe_time,"
+              << "Speedup_sell_exe_time";
+      if (mh)
+         cout << ",Heads_exe_time,"
+              << "Mh_exe_time,"
+              << "Speedup_mh_exe_time";
+      if (edge)
+         cout << ",Twopass_exe_time,"
+              << "Edge_exe_time,"
+              << "Speedup_edge_exe_time";
+      if (norm)
+         cout << ",Scaled_val_exe_time,"
+              << "Norm_exe_time,"
+              << "Speedup_norm_exe_time";
+      if (arg)
+         cout << ",Maxmin_exe_time,"
+              << "Arg_exe_time,"
+              << "Speedup_arg_exe_time";
+      cout << endl;
    }
 #ifdef TIME_MKL 
    double critical_point = (res0[0]/(res1[1]-res0[1])) < 0.0 ?  -1.0 
@@ -1801,7 +3439,64 @@ void GetSpeedup(string inputfile, int option, INDEXTYPE M,
         << ((inspTime0+exeTime0)/(inspTime1+exeTime1)) << ","  
         << critical_point
 #endif
-        << endl;
+        ;
+   if (reorder)
+      cout << "," << std::scientific 
+           << reordTime << "," 
+           << res2[1] << "," 
+           << std::fixed << std::showpoint
+           << exeTime1/res2[1];
+   if (vbidx)
+      cout << "," << std::scientific 
+           << res3[1] << "," 
+           << res4[0] << "," 
+           << res4[1] << "," 
+           << std::fixed << std::showpoint
+           << res3[1]/res4[1];
+   if (half)
+      cout << "," << std::scientific 
+           << res5[0] << "," 
+           << res5[1] << "," 
+           << std::fixed << std::showpoint
+           << res5[0]/res5[1];
+   if (i8)
+      cout << "," << std::scientific 
+           << res6[0] << "," 
+           << res6[1] << "," 
+           << std::fixed << std::showpoint
+           << res6[0]/res6[1];
+   if (sell)
+      cout << "," << std::scientific 
+           << res7[1] << "," 
+           << res8[0] << "," 
+           << res8[1] << "," 
+           << std::fixed << std::showpoint
+           << res7[1]/res8[1];
+   if (mh)
+      cout << "," << std::scientific 
+           << res9[0] << "," 
+           << res9[1] << "," 
+           << std::fixed << std::showpoint
+           << res9[0]/res9[1];
+   if (edge)
+      cout << "," << std::scientific 
+           << res10[0] << "," 
+           << res10[1] << "," 
+           << std::fixed << std::showpoint
+           << res10[0]/res10[1];
+   if (norm)
+      cout << "," << std::scientific 
+           << res11[0] << "," 
+           << res11[1] << "," 
+           << std::fixed << std::showpoint
+           << res11[0]/res11[1];
+   if (arg)
+      cout << "," << std::scientific 
+           << res12[0] << "," 
+           << res12[1] << "," 
+           << std::fixed << std::showpoint
+           << res12[0]/res12[1];
+   cout << endl;
 }
 
 void Usage()
@@ -1811,24 +3506,49 @@ void Usage()
    printf("-input <string>, full path of input file (required).\n");
    printf("-M <number>, rows of S (can be less than actual rows of S).\n");
    printf("-K <number>, number of cols of A, B and C \n");
+   printf("-ldpad <number>, leading dimensions of A, B and C are K+ldpad in test \n");
    printf("-C <number>, Cachesize in KB to flush it for small workset \n");
    printf("-nrep <number>, number of repeatation \n");
    printf("-nrblk <number>, number of random blk with row M, 0/-1: all  \n");
-   printf("-T <0,1>, 1 means, run tester as well  \n");
-   printf("-t <t,s>, t : t-distribution, s : sigmoid  \n");
+   printf("-T <0,1,2>, 1 means, run tester as well, 2 tests execution plan  \n");
+   printf("-t <t,s,a,x,n>, t : t-distribution, s : sigmoid, a : softmax,\n"
+          "   x : max, n : min aggregation  \n");
    printf("-skHd<1>, 1 means, skip header of the printed results  \n");
    printf("-trusted <option#>\n" 
           "   1)MKL 2)FUSEDMM_UNOPTIMIZED\n");
    //printf("-test <option#>\n"
    //       "   1)MKL 2)CSR_IKJ 3)CSR_KIJ 4)CSR_IKJ_D128 5)CSR_KIJ_D128\n");
-   printf("-ialpha <1, 0, 2>, alpha respectively 1.0, 0.0, X  \n");
-   printf("-ibeta <1, 0, 2>, beta respectively 1.0, 0.0, X \n");
+   printf("-ialpha <1, 0, 2>, alpha respectively 1.0, 0.0, X (2.0) \n");
+   printf("-ibeta <1, 0, 2>, beta respectively 1.0, 0.0, X (2.0) \n");
+   printf("-reorder <0,1,2,3>, time test kernel again after reordering the graph\n"
+          "   0)NONE 1)RCM 2)DEGREE 3)HUB, -T 2 tests plan with reordering\n");
+   printf("-vbidx <0,1>, 1: time plan with compressed column indices (spmm, gcn),\n"
+          "   -T 2 tests plan with them\n");
+   printf("-half <0,1,2>, time fusedMM_csr_half with A and B in 1)BF16 2)FP16,\n"
+          "   -T tests it instead of fusedMM_csr\n");
+   printf("-i8 <0,1>, 1: time fusedMM_csr_i8 with B in int8, -T tests it instead\n"
+          "   of fusedMM_csr\n");
+   printf("-csc <0,1>, 1: -T tests fusedMM_csc on the CSC of S, -T 2 tests the\n"
+          "   transposed plan\n");
+   printf("-sell <sigma>, >0: time plan with SELL-C-sigma (spmm, gcn), -T 2 tests\n"
+          "   plan with it\n");
+   printf("-mh <nhead>, >1: time fusedMM_csr_mh with nhead heads against a call\n"
+          "   of fusedMM_csr per head, -T tests it instead of fusedMM_csr\n");
+   printf("-edge <0,1>, 1: time fusedMM_csr_edge against fusedMM_csr and a second\n"
+          "   pass for the edges, -T tests it instead of fusedMM_csr\n");
+   printf("-norm <0,1,2>, time fusedMM_csr_norm with 1)D^-1/2 A D^-1/2 2)D^-1 A\n"
+          "   against scaled values (spmm, gcn), -T tests it instead of fusedMM_csr\n");
+   printf("-arg <0,1>, 1: time fusedMM_csr_arg against fusedMM_csr (max, min),\n"
+          "   -T tests it instead of fusedMM_csr\n");
    printf("-h, show this usage message  \n");
 
 }
 void GetFlags(int narg, char **argv, string &inputfile, int &option, 
       INDEXTYPE &M, INDEXTYPE &K, int &csKB, int &nrep, 
-      int &isTest, int &skHd, VALUETYPE &alpha, VALUETYPE &beta, char &tkern)
+      int &isTest, int &skHd, VALUETYPE &alpha, VALUETYPE &beta, char &tkern,
+      INDEXTYPE &ldpad, int &reorder, int &vbidx, int &half, int &i8, 
+      INDEXTYPE &sell, int &csc, INDEXTYPE &mh, int &edge, int &norm, 
+      int &arg)
 {
    int ialpha, ibeta; 
 /*
@@ -1838,6 +3558,17 @@ void GetFlags(int narg, char **argv, string &inputfile, int &option,
    inputfile = "";
    K = 128; 
    M = 0;
+   ldpad = 0;
+   reorder = FUSEDMM_REORDER_NONE;
+   vbidx = 0;
+   half = 0;
+   i8 = 0;
+   sell = 0;
+   csc = 0;
+   mh = 0;
+   edge = 0;
+   norm = 0;
+   arg = 0;
 /*
  * default kernel based on macro now
  */
@@ -1851,6 +3582,8 @@ void GetFlags(int narg, char **argv, string &inputfile, int &option,
    tkern = 'm';
 #elif defined(FR_UDEF)
    tkern = 'f';
+#elif defined(SOFTMAX_UDEF)
+   tkern = 'a';
 #else
    tkern = 's';
 #endif
@@ -1883,6 +3616,50 @@ void GetFlags(int narg, char **argv, string &inputfile, int &option,
       {
 	 M = atoi(argv[p+1]);
       }
+      else if(strcmp(argv[p], "-ldpad") == 0)
+      {
+	 ldpad = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-reorder") == 0)
+      {
+	 reorder = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-vbidx") == 0)
+      {
+	 vbidx = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-half") == 0)
+      {
+	 half = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-i8") == 0)
+      {
+	 i8 = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-sell") == 0)
+      {
+	 sell = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-csc") == 0)
+      {
+	 csc = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-mh") == 0)
+      {
+	 mh = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-edge") == 0)
+      {
+	 edge = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-norm") == 0)
+      {
+	 norm = atoi(argv[p+1]);
+      }
+      else if(strcmp(argv[p], "-arg") == 0)
+      {
+	 arg = atoi(argv[p+1]);
+      }
       else if(strcmp(argv[p], "-C") == 0)
       {
 	 csKB = atoi(argv[p+1]);
@@ -1944,24 +3721,25 @@ void GetFlags(int narg, char **argv, string &inputfile, int &option,
    }
 #endif
 /*
- * supported beta = 0 and beta = 1 case
+ * X = 2.0, general alpha and beta are applied by optimized kernels only 
  */
-   if (ibeta == 0)
-      beta = 0.0;
-   else
-      beta = 1.0;
+   alpha = (ialpha == 0 || ialpha == 1) ? ialpha : 2.0;
+   beta = (ibeta == 0 || ibeta == 1) ? ibeta : 2.0;
 
 }
 int main(int narg, char **argv)
 {
-   INDEXTYPE M, K;
+   INDEXTYPE M, K, ldpad, sell, mh;
    VALUETYPE alpha, beta;
-   int option, csKB, nrep, isTest, skHd, nrblk;
+   int option, csKB, nrep, isTest, skHd, nrblk, reorder, vbidx, half, i8, csc;
+   int edge, norm, arg;
    char tkern;
    string inputfile; 
    GetFlags(narg, argv, inputfile, option, M, K, csKB, nrep, isTest, skHd, 
-            alpha, beta, tkern);
+            alpha, beta, tkern, ldpad, reorder, vbidx, half, i8, sell, csc, mh,
+            edge, norm, arg);
    GetSpeedup(inputfile, option, M, K, csKB, nrep, isTest, skHd, alpha, beta, 
-         tkern);
+         tkern, ldpad, reorder, vbidx, half, i8, sell, csc, mh, edge, norm, 
+         arg);
    return 0;
 }
@@ -0,0 +1,71 @@
+#ifndef _REORDER_H_
+#define _REORDER_H_
+
+#include <cstdlib>
+#include <type_traits>
+#include "CSR.h"
+#include "utility.h"
+
+/*
+ * Reordering of the vertices of a graph stored in CSR (rows = cols).
+ * Permutation is computed and applied by the fusedMM library, see
+ * fusedMM_reorder_csr in fusedMM.h (must be included before this file).
+ * IT and NT must be the INDEXTYPE and VALUETYPE of the library, column
+ * indices are converted when the library uses a different COLINDEXTYPE.
+ *    perm[i] is the original id of vertex i, use fusedMM_permute_dense to
+ *    permute the dense matrices indexed by the vertices
+ */
+template <class IT, class NT>
+bool ReorderCSR(CSR<IT,NT> &A, const int method, IT *perm)
+{
+    const bool samecid = std::is_same<IT, COLINDEXTYPE>::value;
+    COLINDEXTYPE *cids, *pcids;
+
+    if (A.rows != A.cols || !A.zerobased)
+        return false;
+/*
+ *  the library takes column indices as COLINDEXTYPE, copy when it differs
+ */
+    if (samecid)
+        cids = reinterpret_cast<COLINDEXTYPE*>(A.colids);
+    else
+    {
+        cids = my_malloc<COLINDEXTYPE>(A.nnz);
+        for (IT i = 0; i < A.nnz; i++)
+            cids[i] = A.colids[i];
+    }
+    IT *rowptr = my_malloc<IT>(A.rows + 1);
+    pcids = my_malloc<COLINDEXTYPE>(A.nnz);
+    NT *values = my_malloc<NT>(A.nnz);
+    if (fusedMM_reorder_csr(method, A.rows, cids, A.rowptr, A.rowptr + 1,
+                perm) != FUSEDMM_SUCCESS_RETURN
+        || fusedMM_permute_csr(A.rows, perm, cids, A.rowptr, A.rowptr + 1,
+                A.values, pcids, rowptr, values, NULL)
+            != FUSEDMM_SUCCESS_RETURN) {
+        if (!samecid)
+            my_free<COLINDEXTYPE>(cids);
+        my_free<IT>(rowptr);
+        my_free<COLINDEXTYPE>(pcids);
+        my_free<NT>(values);
+        return false;
+    }
+    my_free<IT>(A.rowptr);
+    my_free<NT>(A.values);
+    A.rowptr = rowptr;
+    A.values = values;
+    if (samecid)
+    {
+        my_free<IT>(A.colids);
+        A.colids = reinterpret_cast<IT*>(pcids);
+    }
+    else
+    {
+        for (IT i = 0; i < A.nnz; i++)
+            A.colids[i] = pcids[i];
+        my_free<COLINDEXTYPE>(cids);
+        my_free<COLINDEXTYPE>(pcids);
+    }
+    return true;
+}
+
+#endif